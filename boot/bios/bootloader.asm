@@ -1,42 +1,298 @@
-; bootloader.asm - stage1 simples para ArcanOS (carrega kernel.bin em 0x1000:0x0000)
+; bootloader.asm - stage1 para ArcanOS (carrega kernel.bin em 1 MiB e em 0x1000:0x0000)
 ; Assemble: nasm -f bin bootloader.asm -o bootloader.bin
+;
+; Layout do disco (LBA):
+;   0       init.bin (boot sector)
+;   1..2    bootloader.bin (este stage1, 1024 bytes)
+;   3..     kernel.bin
+;
+; O primeiro setor do kernel traz um cabeçalho em KHDR_OFFSET:
+;   dd 'ARCK'          ; magic
+;   dd setores         ; tamanho total do kernel em setores (inclui o primeiro)
+; (o kernel começa em 0x1000:0x0000, então os bytes 0..7 devem pular o cabeçalho)
+;
+; Destino: a imagem inteira é copiada, contígua, para KERNEL_HIGH (1 MiB); o
+; tamanho do cabeçalho é o único limite. Os primeiros setores (até LOW_END_SEG,
+; 448 KiB) ficam também em 0x1000:0x0000, onde roda a entrada em modo real.
+; Como o stage1 fica em modo real, cada rajada é lida abaixo de 1 MiB (na cópia
+; baixa ou, quando ela enche, no buffer em BOUNCE_SEG) e copiada para cima com
+; INT 15h AH=87h, que também habilita a A20 durante a cópia.
+;
+; Leitura: INT 13h extensões (AH=42h) com disk address packet, em rajadas de
+; até MAX_RUN setores que terminam no fim de uma trilha da geometria da BIOS
+; (AH=08h); se a BIOS recusar uma rajada, o tamanho cai pela metade e vira o
+; novo limite. Sem extensões, cai para CHS (AH=02h) lendo até o fim de cada
+; trilha por chamada.
+; O tempo de carga (delta do TSC, em hex) é impresso antes do salto para o kernel.
 
 [BITS 16]
 [ORG 0x7E00]
 
+KERNEL_LBA     equ 3
+KERNEL_SEG     equ 0x1000          ; cópia baixa (entrada em modo real)
+LOW_END_SEG    equ 0x8000          ; fim da cópia baixa
+BOUNCE_SEG     equ 0x8000          ; 0x80000..0x8FE00: rajadas depois da cópia baixa
+KERNEL_HIGH    equ 0x100000        ; imagem completa
+MAX_SECTORS    equ (0x100000000 - KERNEL_HIGH) / 512 ; abaixo de 4 GiB
+KHDR_OFFSET    equ 8
+KHDR_MAGIC     equ 0x4B435241      ; 'ARCK'
+MAX_RUN        equ 127             ; limite usual de setores por chamada AH=42h
+SECT_PARAS     equ 512 / 16        ; parágrafos por setor
+
 start:
     cli
     xor ax, ax
     mov ds, ax
     mov es, ax
+    mov [drive], dl       ; drive passado pelo init.asm
+    sti
 
     mov si, msg
     call print_string
 
-    ; carregar kernel (assume kernel começando no setor 3 e ocupa N setores)
-    mov bx, 0x0000
-    mov es, 0x1000        ; carregar em 0x1000:0x0000
-    mov di, 0x0000
-    mov cx, 8             ; número de setores do kernel (ajuste conforme build)
-    mov dx, [drive]
-    mov si, 3             ; setor inicial do kernel
-.load_loop:
-    push cx
-    push si
-    mov ah, 0x02
-    mov al, 1
-    mov ch, 0
-    mov cl, si
-    mov dh, 0
+    ; geometria (AH=08h): endereçamento do fallback CHS e alinhamento das
+    ; rajadas LBA às trilhas
+    mov ah, 0x08
+    mov dl, [drive]
+    xor di, di
+    int 0x13
+    push 0
+    pop es
+    jc .no_geom
+    and cx, 0x3F
+    mov [spt], cx
+    xor ax, ax
+    mov al, dh
+    inc ax
+    mov [heads], ax
+.no_geom:
+
+    ; verificar extensões INT 13h (AH=41h) com suporte a DAP (CX bit 0)
+    mov ah, 0x41
+    mov bx, 0x55AA
+    mov dl, [drive]
     int 0x13
+    jc .no_ext
+    cmp bx, 0xAA55
+    jne .no_ext
+    test cx, 1
+    jz .no_ext
+    mov byte [use_lba], 1
+    ; maior múltiplo da trilha que cabe em MAX_RUN
+    mov ax, MAX_RUN
+    mov cx, [spt]
+    jcxz .read_header
+    cmp ax, cx
+    jb .read_header
+    xor dx, dx
+    div cx
+    mul cx
+    mov [max_run], ax
+    jmp .read_header
+
+.no_ext:
+    cmp word [spt], 0
+    je disk_fail          ; sem extensões e sem geometria
+
+.read_header:
+    rdtsc
+    mov [tsc_start], eax
+
+    ; primeiro setor do kernel (contém o cabeçalho)
+    mov dword [lba], KERNEL_LBA
+    mov word [seg_], KERNEL_SEG
+    mov word [count], 1
+    call read_run
     jc disk_fail
-    add si, 1
-    pop si
-    pop cx
-    loop .load_loop
 
-    ; saltar para kernel em 0x1000:0x0000
-    jmp 0x1000:0x0000
+    mov ax, KERNEL_SEG
+    mov es, ax
+    cmp dword [es:KHDR_OFFSET], KHDR_MAGIC
+    jne bad_header
+    mov eax, [es:KHDR_OFFSET + 4]
+    test eax, eax
+    jz bad_header
+    cmp eax, MAX_SECTORS
+    ja too_big
+    mov [total], eax
+    mov [remaining], eax
+    mov dword [high], KERNEL_HIGH
+    jmp .copy             ; o setor do cabeçalho também vai para 1 MiB
+
+.load_loop:
+    mov eax, [remaining]
+    test eax, eax
+    jz .loaded
+    movzx ecx, word [max_run]
+    cmp eax, ecx
+    jbe .run_ok
+    mov eax, ecx
+.run_ok:
+    mov [count], ax
+    call align_run
+    ; destino da leitura: continua a cópia baixa enquanto couber
+    cmp byte [low_full], 0
+    jne .bounce
+    mov ax, [count]
+    shl ax, 5             ; setores -> parágrafos (SECT_PARAS)
+    add ax, [seg_]
+    cmp ax, LOW_END_SEG
+    jbe .read
+    mov byte [low_full], 1
+.bounce:
+    mov word [seg_], BOUNCE_SEG
+.read:
+    call read_run         ; pode reduzir [count]; retorna setores lidos em [count]
+    jc disk_fail
+.copy:
+    call copy_high
+    jc disk_fail
+    movzx eax, word [count]
+    sub [remaining], eax
+    add [lba], eax
+    shl eax, 9
+    add [high], eax
+    cmp byte [low_full], 0
+    jne .load_loop
+    shr ax, 4             ; bytes -> parágrafos
+    add [seg_], ax
+    jmp .load_loop
+
+.loaded:
+    rdtsc
+    sub eax, [tsc_start]
+    push eax
+    mov si, load_msg
+    call print_string
+    pop eax
+    call print_hex32
+    mov si, sect_msg
+    call print_string
+    mov eax, [total]
+    call print_hex32
+
+    ; saltar para kernel em 0x1000:0x0000 (DL = drive de boot)
+    mov dl, [drive]
+    jmp KERNEL_SEG:0x0000
+
+; -------------------------
+; align_run: com LBA e geometria conhecida, encurta [count] para a rajada
+; terminar no fim de uma trilha (exceto a última).
+; -------------------------
+align_run:
+    cmp byte [use_lba], 0
+    je .done              ; o caminho CHS já para no fim da trilha
+    movzx ecx, word [spt]
+    jecxz .done
+    movzx ebx, word [count]
+    cmp ebx, [remaining]
+    jae .done
+    mov eax, [lba]
+    add eax, ebx
+    xor edx, edx
+    div ecx               ; edx = setores depois do fim da trilha
+    cmp edx, ebx
+    jae .done
+    sub [count], dx
+.done:
+    ret
+
+; -------------------------
+; copy_high: copia [count] setores de [seg_]:0000 para o endereço linear
+; [high] com INT 15h AH=87h. CF=1 em erro.
+; -------------------------
+copy_high:
+    movzx eax, word [seg_]
+    shl eax, 4
+    mov bx, gdt_src
+    call set_base
+    mov eax, [high]
+    mov bx, gdt_dst
+    call set_base
+    mov cx, [count]
+    shl cx, 8             ; setores -> words
+    push 0
+    pop es
+    mov si, gdt87
+    mov ah, 0x87
+    int 0x15
+    ret
+
+; set_base: grava EAX como base do descritor em [bx]
+set_base:
+    mov [bx + 2], ax
+    shr eax, 16
+    mov [bx + 4], al
+    mov [bx + 7], ah
+    ret
+
+; -------------------------
+; read_run: lê [count] setores a partir de [lba] para [seg_]:0000.
+; Pode reduzir [count]; CF=1 em erro fatal.
+; -------------------------
+read_run:
+    cmp byte [use_lba], 0
+    je read_chs
+.retry:
+    mov ax, [count]
+    mov [dap_count], ax
+    mov word [dap_off], 0
+    mov ax, [seg_]
+    mov [dap_seg], ax
+    mov eax, [lba]
+    mov [dap_lba], eax
+    mov dword [dap_lba + 4], 0
+    mov si, dap
+    mov ah, 0x42
+    mov dl, [drive]
+    int 0x13
+    jnc .ok
+    ; rajada recusada: metade do tamanho, que passa a ser o limite
+    mov ax, [count]
+    shr ax, 1
+    jz .fail
+    mov [count], ax
+    mov [max_run], ax
+    xor ah, ah            ; reset do controlador antes de tentar de novo
+    mov dl, [drive]
+    int 0x13
+    jmp .retry
+.ok:
+    clc
+    ret
+.fail:
+    stc
+    ret
+
+read_chs:
+    mov eax, [lba]
+    xor edx, edx
+    movzx ecx, word [spt]
+    div ecx               ; eax = trilha lógica, edx = setor - 1
+    mov bx, [spt]
+    sub bx, dx            ; setores até o fim da trilha
+    cmp bx, [count]
+    jae .fits
+    mov [count], bx
+.fits:
+    inc dx
+    mov [chs_sector], dl
+    xor edx, edx
+    movzx ebx, word [heads]
+    div ebx               ; eax = cilindro, edx = cabeça
+    mov dh, dl
+    mov ch, al            ; cilindro bits 0-7
+    mov cl, ah
+    shl cl, 6             ; cilindro bits 8-9 em CL[7:6]
+    or cl, [chs_sector]
+    mov ax, [seg_]
+    mov es, ax
+    xor bx, bx
+    mov dl, [drive]
+    mov al, [count]
+    mov ah, 0x02
+    int 0x13              ; CF repassado ao chamador
+    ret
 
 print_string:
     mov ah, 0x0E
@@ -49,13 +305,78 @@ print_string:
 .ret2:
     ret
 
+; print_hex32: imprime EAX em hexadecimal (8 dígitos)
+print_hex32:
+    mov cx, 8
+.digit:
+    rol eax, 4
+    push eax
+    and al, 0x0F
+    add al, '0'
+    cmp al, '9'
+    jbe .emit
+    add al, 7
+.emit:
+    mov ah, 0x0E
+    xor bx, bx
+    int 0x10
+    pop eax
+    loop .digit
+    ret
+
 disk_fail:
     mov si, err
+    jmp halt_msg
+bad_header:
+    mov si, hdr_err
+    jmp halt_msg
+too_big:
+    mov si, big_err
+halt_msg:
     call print_string
+    cli
     hlt
 
-msg db "ArcanOS stage1 loaded. Jumping to kernel...", 0
-err db "KERNEL LOAD FAILED", 0
-drive dw 0
+msg      db "ArcanOS stage1 loaded. Loading kernel...", 13, 10, 0
+load_msg db "Kernel load TSC: 0x", 0
+sect_msg db " sectors: 0x", 0
+err      db "KERNEL LOAD FAILED", 0
+hdr_err  db "BAD KERNEL HEADER", 0
+big_err  db "KERNEL TOO LARGE", 0
+
+drive      db 0
+use_lba    db 0
+low_full   db 0
+chs_sector db 0
+max_run    dw MAX_RUN
+spt        dw 0
+heads      dw 0
+seg_       dw 0
+count      dw 0
+total      dd 0
+remaining  dd 0
+lba        dd 0
+high       dd 0
+tsc_start  dd 0
+
+; disk address packet (AH=42h)
+align 4
+dap:
+    db 0x10, 0
+dap_count dw 0
+dap_off   dw 0
+dap_seg   dw 0
+dap_lba   dq 0
+
+; GDT para INT 15h AH=87h: nula, GDT, origem, destino e duas da BIOS
+gdt87:
+    times 16 db 0
+gdt_src:
+    dw 0xFFFF, 0
+    db 0, 0x93, 0, 0
+gdt_dst:
+    dw 0xFFFF, 0
+    db 0, 0x93, 0, 0
+    times 16 db 0
 
 times 1024-($-$$) db 0
@@ -11,20 +11,23 @@ start:
     mov es, ax
     mov ss, ax
     mov sp, 0x7C00
+    mov [BOOT_DRIVE], dl ; drive de boot informado pelo BIOS
+    sti
 
     ; mostrar mensagem
     mov si, boot_msg
     call print_string
 
-    ; carregar setor 2 (primeiro setor do stage1) para 0x0000:0x7E00
+    ; carregar setores 2-3 (stage1, 1024 bytes) para 0x0000:0x7E00
     mov bx, 0x7E00
+    mov al, 2    ; número de setores
     mov dh, 0    ; head
     mov dl, [BOOT_DRIVE] ; drive passado pelo BIOS (será atualizado pelo loader)
     mov ch, 0
     mov cl, 2    ; setor 2 (assumindo imagem simples)
     call read_sector
 
-    ; saltar para stage1 em 0000:7E00
+    ; saltar para stage1 em 0000:7E00 (DL = drive de boot)
     jmp 0x0000:0x7E00
 
 ; -------------------------
@@ -42,11 +45,10 @@ print_string:
     ret
 
 ; read_sector: AH = 0x02 already set inside
-; inputs: DL = drive, CH = cyl, DH=head, CL=sector, ES:BX = buffer
+; inputs: AL = setores, DL = drive, CH = cyl, DH=head, CL=sector, ES:BX = buffer
 read_sector:
     pusha
     mov ah, 0x02
-    mov al, 1        ; ler 1 setor
     int 0x13
     jc disk_error
     popa
@@ -1,5 +1,7 @@
-/* memory_map.c - consulta mapa de memória via int 0x15, e820 (template)
-   Gera saída simples para debug durante build. */
+/* memory_map.c - consulta mapa de memória via int 0x15, e820
+   Compilar como código real-mode (ex: i386-elf-gcc -m16) com DS = ES = SS = 0.
+   As entradas alimentam o alocador de páginas do kernel (pmm_init, em
+   src/sys/kernel/kernl/mm/page_alloc.h), que usa os mesmos códigos de tipo. */
 
 #include <stdint.h>
 
@@ -10,25 +12,52 @@ struct e820_entry {
     uint32_t acpi;
 } __attribute__((packed));
 
+#define E820_SMAP 0x534D4150 /* 'SMAP' */
+
 typedef int (*e820_cb)(struct e820_entry *e);
 
+/* Percorre o mapa E820 chamando cb para cada entrada válida.
+   cb retorna != 0 para interromper. Retorna o número de entradas entregues,
+   ou -1 se o BIOS não suportar E820. */
 int query_e820(e820_cb cb) {
     uint32_t cont = 0;
+    int delivered = 0;
     struct e820_entry e;
     for (;;) {
         uint32_t eax = 0xE820;
         uint32_t ebx = cont;
         uint32_t ecx = sizeof(e);
-        uint32_t edx = 0x534D4150; /* 'SMAP' */
-        uint16_t es = 0; /* callback buffer segment */
-        uint32_t carry = 0;
+        uint32_t edx = E820_SMAP;
+        uint8_t carry;
+
+        e.acpi = 1; /* entradas de 20 bytes não escrevem este campo: "válida" */
+
+        /* int 0x15, AX=0xE820: ES:DI = buffer, EBX = continuação */
+        asm volatile (
+            "int $0x15\n\t"
+            "setc %0"
+            : "=qm"(carry), "+a"(eax), "+b"(ebx), "+c"(ecx), "+d"(edx)
+            : "D"(&e)
+            : "memory", "cc"
+        );
+
+        if (carry || eax != E820_SMAP) {
+            /* Carry na primeira chamada = sem suporte; depois = fim da lista */
+            return delivered == 0 && cont == 0 ? -1 : delivered;
+        }
 
-        /* Em ambiente real isso deve usar int 0x15; aqui é apenas placeholder */
-        /* Chamada real: int 0x15 AH=0xE820 */
-        (void)eax; (void)ebx; (void)ecx; (void)edx; (void)es;
+        /* Ignora entradas vazias e as marcadas como "ignorar" (ACPI 3.0, bit 0 = 0) */
+        if (ecx >= 20 && e.length != 0 && (ecx < 24 || (e.acpi & 1))) {
+            delivered++;
+            if (cb(&e)) {
+                break;
+            }
+        }
 
-        /* Simular fim */
-        break;
+        cont = ebx;
+        if (cont == 0) {
+            break;
+        }
     }
-    return 0;
+    return delivered;
 }
@@ -1,15 +1,199 @@
-/* boot_services.c - wrappers mínimos para Boot Services (placeholder)
-   No EDK2, Boot Services são extensos; aqui só colocamos stubs. */
+/* boot_services.c - wrappers mínimos para Boot Services
+   Alocação de páginas, região contígua do ramdisk e saída dos Boot Services
+   com o mapa de memória convertido para o ArcBootInfo do kernel. */
 
 #include "efi_table.h"
+#include "boot_info.h"
+
+static EFI_BOOT_SERVICES *g_bs;
+
+/* Folga no buffer do mapa: alocações feitas depois da medição criam novas entradas */
+#define MAP_SLACK_DESCRIPTORS 16
+
+/* Buffers reservados antes de ExitBootServices (nenhuma alocação é permitida entre
+   o último GetMemoryMap e ExitBootServices) */
+static EFI_MEMORY_DESCRIPTOR *g_map;
+static UINTN g_map_capacity;
+static ArcBootInfo *g_info;
+static ArcMemRegion *g_regions;
+static UINTN g_regions_capacity;
+
+void uefi_boot_services_init(EFI_SYSTEM_TABLE *st) {
+    g_bs = st->BootServices;
+}
 
 void *uefi_allocate_pages(unsigned long pages) {
-    /* stub - use Boot Services AllocatePages in real implementation */
-    (void)pages;
-    return 0;
+    EFI_PHYSICAL_ADDRESS addr = 0;
+    if (g_bs == 0 || EFI_ERROR(g_bs->AllocatePages(AllocateAnyPages, EfiLoaderData, pages, &addr))) {
+        return 0;
+    }
+    return (void *)(uintptr_t)addr;
+}
+
+/* Aloca 'pages' páginas contíguas alinhadas a 'align' (potência de 2, >= 4 KiB).
+   Reserva a mais e devolve ao firmware as sobras antes e depois do trecho alinhado. */
+void *uefi_allocate_aligned_pages(unsigned long pages, uint64_t align) {
+    UINTN extra = (UINTN)(align / EFI_PAGE_SIZE) - 1;
+    EFI_PHYSICAL_ADDRESS base = 0;
+
+    if (g_bs == 0 || EFI_ERROR(g_bs->AllocatePages(AllocateAnyPages, EfiLoaderData,
+                                                   pages + extra, &base))) {
+        return 0;
+    }
+
+    EFI_PHYSICAL_ADDRESS aligned = (base + align - 1) & ~(align - 1);
+    UINTN head = (UINTN)((aligned - base) / EFI_PAGE_SIZE);
+    UINTN tail = extra - head;
+
+    if (head) {
+        g_bs->FreePages(base, head);
+    }
+    if (tail) {
+        g_bs->FreePages(aligned + (EFI_PHYSICAL_ADDRESS)pages * EFI_PAGE_SIZE, tail);
+    }
+    return (void *)(uintptr_t)aligned;
+}
+
+/* Tipo EFI -> tipo E820/ArcMemRegion. Memória de Boot Services é liberada após
+   ExitBootServices; LoaderCode/Data (loader, kernel, ramdisk, boot info) vira
+   ARC_MEM_TYPE_LOADER: reservada para o kernel, mas mapeada pelas tabelas do boot. */
+static uint32_t efi_to_region_type(uint32_t efi_type) {
+    switch (efi_type) {
+    case EfiConventionalMemory:
+    case EfiBootServicesCode:
+    case EfiBootServicesData:
+        return 1;
+    case EfiLoaderCode:
+    case EfiLoaderData:
+        return ARC_MEM_TYPE_LOADER;
+    case EfiACPIReclaimMemory:
+        return 3;
+    case EfiACPIMemoryNVS:
+        return 4;
+    case EfiUnusableMemory:
+        return 5;
+    default:
+        return 2;
+    }
+}
+
+/* Converte o mapa EFI, unindo entradas adjacentes do mesmo tipo. */
+static void convert_memory_map(UINTN map_size, UINTN desc_size) {
+    uint32_t n = 0;
+
+    for (UINTN off = 0; off + desc_size <= map_size; off += desc_size) {
+        const EFI_MEMORY_DESCRIPTOR *d = (const EFI_MEMORY_DESCRIPTOR *)((uint8_t *)g_map + off);
+        uint32_t type = efi_to_region_type(d->Type);
+        uint64_t length = d->NumberOfPages * EFI_PAGE_SIZE;
+
+        if (n > 0 && g_regions[n - 1].type == type &&
+            g_regions[n - 1].base + g_regions[n - 1].length == d->PhysicalStart) {
+            g_regions[n - 1].length += length;
+            continue;
+        }
+        if (n == g_regions_capacity) {
+            break; /* não acontece: a capacidade cobre o buffer inteiro do mapa */
+        }
+        g_regions[n].base = d->PhysicalStart;
+        g_regions[n].length = length;
+        g_regions[n].type = type;
+        n++;
+    }
+    g_info->mem_region_count = n;
 }
 
-void uefi_exit_boot_services(void *image, void *map_key) {
-    /* stub */
-    (void)image; (void)map_key;
+/* Reserva a região contígua ramdisk + arena (alinhada a 2 MiB) e os buffers do
+   handoff. Deve ser chamada antes de uefi_exit_boot_services(). */
+ArcBootInfo *uefi_prepare_boot_info(uint64_t ramdisk_size, uint64_t arena_size) {
+    UINTN map_size = 0, map_key, desc_size = sizeof(EFI_MEMORY_DESCRIPTOR);
+    uint32_t desc_version;
+
+    if (g_bs == 0) {
+        return 0;
+    }
+
+    /* 1. Região grande e contígua para o ramdisk e a arena de descompressão */
+    uint64_t ramdisk_bytes = (ramdisk_size + ARC_RAMDISK_ALIGN - 1) & ~(ARC_RAMDISK_ALIGN - 1);
+    uint64_t arena_bytes = (arena_size + ARC_RAMDISK_ALIGN - 1) & ~(ARC_RAMDISK_ALIGN - 1);
+    uint8_t *region = uefi_allocate_aligned_pages(
+        (unsigned long)((ramdisk_bytes + arena_bytes) / EFI_PAGE_SIZE), ARC_RAMDISK_ALIGN);
+    if (region == 0) {
+        return 0;
+    }
+
+    /* 2. Mede o mapa e reserva buffers com folga para as próximas alocações */
+    g_bs->GetMemoryMap(&map_size, 0, &map_key, &desc_size, &desc_version);
+    map_size += (MAP_SLACK_DESCRIPTORS + 4) * desc_size;
+
+    UINTN max_descs = map_size / desc_size;
+    UINTN info_bytes = sizeof(ArcBootInfo) + max_descs * sizeof(ArcMemRegion);
+
+    g_map = uefi_allocate_pages((unsigned long)((map_size + EFI_PAGE_SIZE - 1) / EFI_PAGE_SIZE));
+    g_info = uefi_allocate_pages((unsigned long)((info_bytes + EFI_PAGE_SIZE - 1) / EFI_PAGE_SIZE));
+    if (g_map == 0 || g_info == 0) {
+        return 0;
+    }
+    g_map_capacity = map_size;
+    g_regions = (ArcMemRegion *)(g_info + 1);
+    g_regions_capacity = max_descs;
+
+    g_info->magic = ARC_BOOT_INFO_MAGIC;
+    g_info->version = ARC_BOOT_INFO_VERSION;
+    g_info->mem_region_count = 0;
+    g_info->mem_regions_paddr = (uint64_t)(uintptr_t)g_regions;
+    g_info->ramdisk_paddr = (uint64_t)(uintptr_t)region;
+    g_info->ramdisk_size = ramdisk_bytes;
+    g_info->arena_paddr = (uint64_t)(uintptr_t)region + ramdisk_bytes;
+    g_info->arena_size = arena_bytes;
+    g_info->cpu_count = 1;           /* Preenchido pelo bl_smp_publish() */
+    g_info->smp_mailboxes_paddr = 0;
+    return g_info;
+}
+
+/* Lê o mapa atual e o converte para o ArcBootInfo sem sair dos Boot Services,
+   para o resumo impresso antes do handoff. Não aloca nada: uefi_exit_boot_services()
+   lê e converte o mapa de novo. */
+EFI_STATUS uefi_snapshot_memory_map(ArcBootInfo *info) {
+    UINTN map_size = g_map_capacity, map_key, desc_size;
+    uint32_t desc_version;
+
+    if (g_bs == 0 || info != g_info) {
+        return EFI_INVALID_PARAMETER;
+    }
+    EFI_STATUS status = g_bs->GetMemoryMap(&map_size, g_map, &map_key, &desc_size, &desc_version);
+    if (EFI_ERROR(status)) {
+        return status;
+    }
+    convert_memory_map(map_size, desc_size);
+    return EFI_SUCCESS;
+}
+
+/* Obtém o mapa final, sai dos Boot Services e preenche o mapa do ArcBootInfo.
+   Se o map key ficar desatualizado (EFI_INVALID_PARAMETER), lê o mapa de novo e
+   tenta mais uma vez, sem alocar nada no meio, como exige a especificação. */
+EFI_STATUS uefi_exit_boot_services(EFI_HANDLE image, ArcBootInfo *info) {
+    EFI_STATUS status = EFI_INVALID_PARAMETER;
+    UINTN map_size, map_key, desc_size;
+    uint32_t desc_version;
+
+    if (g_bs == 0 || info != g_info) {
+        return EFI_INVALID_PARAMETER;
+    }
+
+    for (int attempt = 0; attempt < 2 && status == EFI_INVALID_PARAMETER; attempt++) {
+        map_size = g_map_capacity;
+        status = g_bs->GetMemoryMap(&map_size, g_map, &map_key, &desc_size, &desc_version);
+        if (EFI_ERROR(status)) {
+            return status;
+        }
+        status = g_bs->ExitBootServices(image, map_key);
+    }
+    if (EFI_ERROR(status)) {
+        return status;
+    }
+
+    /* Boot Services encerrados: daqui em diante só memória */
+    g_bs = 0;
+    convert_memory_map(map_size, desc_size);
+    return EFI_SUCCESS;
 }
@@ -1,5 +1,7 @@
 /* efi_table.h - definições mínimas EFI para compilar um app simples
-   Este header é propositalmente reduzido; para builds reais use EDK2 headers. */
+   Este header é propositalmente reduzido; para builds reais use EDK2 headers.
+   Os layouts seguem a especificação UEFI: campos não usados viram ponteiros
+   opacos apenas para manter os offsets corretos. */
 
 #ifndef EFI_TABLE_H
 #define EFI_TABLE_H
@@ -9,16 +11,125 @@
 typedef uint64_t EFI_STATUS;
 typedef void* EFI_HANDLE;
 typedef uint16_t CHAR16;
+typedef uint64_t EFI_PHYSICAL_ADDRESS;
+typedef uint64_t EFI_VIRTUAL_ADDRESS;
+typedef uint64_t UINTN;
 
-#define EFI_SUCCESS 0
+/* Convenção de chamada do firmware (Microsoft x64 no x86_64) */
+#if defined(__x86_64__)
+#define EFIAPI __attribute__((ms_abi))
+#else
+#define EFIAPI
+#endif
+
+#define EFI_SUCCESS            0
+#define EFI_ERROR_BIT          (1ull << 63)
+#define EFI_INVALID_PARAMETER  (EFI_ERROR_BIT | 2)
+#define EFI_BUFFER_TOO_SMALL   (EFI_ERROR_BIT | 5)
+#define EFI_OUT_OF_RESOURCES   (EFI_ERROR_BIT | 9)
+#define EFI_ERROR(status)      (((status) & EFI_ERROR_BIT) != 0)
+
+#define EFI_PAGE_SIZE 4096
 
-/* Simple console out proto */
 typedef struct {
-    EFI_STATUS (*OutputString)(void *This, const CHAR16 *String);
+    uint64_t Signature;
+    uint32_t Revision;
+    uint32_t HeaderSize;
+    uint32_t CRC32;
+    uint32_t Reserved;
+} EFI_TABLE_HEADER;
+
+/* Tipos de memória (EFI_MEMORY_TYPE) */
+typedef enum {
+    EfiReservedMemoryType,
+    EfiLoaderCode,
+    EfiLoaderData,
+    EfiBootServicesCode,
+    EfiBootServicesData,
+    EfiRuntimeServicesCode,
+    EfiRuntimeServicesData,
+    EfiConventionalMemory,
+    EfiUnusableMemory,
+    EfiACPIReclaimMemory,
+    EfiACPIMemoryNVS,
+    EfiMemoryMappedIO,
+    EfiMemoryMappedIOPortSpace,
+    EfiPalCode,
+    EfiPersistentMemory,
+    EfiMaxMemoryType
+} EFI_MEMORY_TYPE;
+
+typedef enum {
+    AllocateAnyPages,
+    AllocateMaxAddress,
+    AllocateAddress,
+    MaxAllocateType
+} EFI_ALLOCATE_TYPE;
+
+/* Entrada do mapa de memória. O firmware informa o DescriptorSize real,
+   que pode ser maior que sizeof(EFI_MEMORY_DESCRIPTOR): sempre use-o como passo. */
+typedef struct {
+    uint32_t Type;
+    EFI_PHYSICAL_ADDRESS PhysicalStart;
+    EFI_VIRTUAL_ADDRESS VirtualStart;
+    uint64_t NumberOfPages;
+    uint64_t Attribute;
+} EFI_MEMORY_DESCRIPTOR;
+
+/* Simple console out proto */
+typedef struct SIMPLE_TEXT_OUTPUT_PROTOCOL {
+    EFI_STATUS (EFIAPI *Reset)(struct SIMPLE_TEXT_OUTPUT_PROTOCOL *This, uint8_t ExtendedVerification);
+    EFI_STATUS (EFIAPI *OutputString)(struct SIMPLE_TEXT_OUTPUT_PROTOCOL *This, const CHAR16 *String);
 } SIMPLE_TEXT_OUTPUT_PROTOCOL;
 
+/* Boot Services: apenas os serviços de memória e ExitBootServices são tipados */
+typedef struct {
+    EFI_TABLE_HEADER Hdr;
+    void *RaiseTPL;
+    void *RestoreTPL;
+    EFI_STATUS (EFIAPI *AllocatePages)(EFI_ALLOCATE_TYPE Type, EFI_MEMORY_TYPE MemoryType,
+                                       UINTN Pages, EFI_PHYSICAL_ADDRESS *Memory);
+    EFI_STATUS (EFIAPI *FreePages)(EFI_PHYSICAL_ADDRESS Memory, UINTN Pages);
+    EFI_STATUS (EFIAPI *GetMemoryMap)(UINTN *MemoryMapSize, EFI_MEMORY_DESCRIPTOR *MemoryMap,
+                                      UINTN *MapKey, UINTN *DescriptorSize, uint32_t *DescriptorVersion);
+    void *AllocatePool;
+    void *FreePool;
+    void *CreateEvent;
+    void *SetTimer;
+    void *WaitForEvent;
+    void *SignalEvent;
+    void *CloseEvent;
+    void *CheckEvent;
+    void *InstallProtocolInterface;
+    void *ReinstallProtocolInterface;
+    void *UninstallProtocolInterface;
+    void *HandleProtocol;
+    void *Reserved;
+    void *RegisterProtocolNotify;
+    void *LocateHandle;
+    void *LocateDevicePath;
+    void *InstallConfigurationTable;
+    void *LoadImage;
+    void *StartImage;
+    void *Exit;
+    void *UnloadImage;
+    EFI_STATUS (EFIAPI *ExitBootServices)(EFI_HANDLE ImageHandle, UINTN MapKey);
+} EFI_BOOT_SERVICES;
+
 typedef struct {
+    EFI_TABLE_HEADER Hdr;
+    CHAR16 *FirmwareVendor;
+    uint32_t FirmwareRevision;
+    EFI_HANDLE ConsoleInHandle;
+    void *ConIn;
+    EFI_HANDLE ConsoleOutHandle;
     SIMPLE_TEXT_OUTPUT_PROTOCOL *ConOut;
+    EFI_HANDLE StandardErrorHandle;
+    SIMPLE_TEXT_OUTPUT_PROTOCOL *StdErr;
+    void *RuntimeServices;
+    EFI_BOOT_SERVICES *BootServices;
+    UINTN NumberOfTableEntries;
+    void *ConfigurationTable;
 } EFI_SYSTEM_TABLE;
 
 #endif /* EFI_TABLE_H */
@@ -3,14 +3,116 @@
    Linkar como PE/COFF UEFI app (EDK2 recommended). */
 
 #include "efi_table.h"
+#include "boot_info.h"
 
-EFI_STATUS efi_main(EFI_HANDLE ImageHandle, EFI_SYSTEM_TABLE *SystemTable) {
+/* Tamanhos da região contígua do ramdisk (ajuste conforme a imagem) */
+#ifndef ARC_RAMDISK_BYTES
+#define ARC_RAMDISK_BYTES (256ull * 1024 * 1024)
+#endif
+#ifndef ARC_ARENA_BYTES
+#define ARC_ARENA_BYTES (64ull * 1024 * 1024)
+#endif
+
+void uefi_boot_services_init(EFI_SYSTEM_TABLE *st);
+ArcBootInfo *uefi_prepare_boot_info(uint64_t ramdisk_size, uint64_t arena_size);
+EFI_STATUS uefi_snapshot_memory_map(ArcBootInfo *info);
+EFI_STATUS uefi_exit_boot_services(EFI_HANDLE image, ArcBootInfo *info);
+
+/* Entrada do kernel ligada à imagem (-DARC_KERNEL_ENTRY=<símbolo>). Sem ela o
+   loader imprime o resumo do handoff e volta ao firmware sem sair dos Boot Services. */
+#ifdef ARC_KERNEL_ENTRY
+void ARC_KERNEL_ENTRY(ArcBootInfo *info);
+#endif
+
+static void print(EFI_SYSTEM_TABLE *st, const CHAR16 *s) {
+    if (st && st->ConOut && st->ConOut->OutputString) {
+        st->ConOut->OutputString(st->ConOut, s);
+    }
+}
+
+/* Texto ASCII curto (até 79 caracteres) no console */
+static void print_ascii(EFI_SYSTEM_TABLE *st, const char *s) {
+    CHAR16 buf[80];
+    unsigned n = 0;
+    while (s[n] != 0 && n < 79) {
+        buf[n] = (CHAR16)s[n];
+        n++;
+    }
+    buf[n] = 0;
+    print(st, buf);
+}
+
+/* "<rótulo>0x<valor>" com o valor em hexadecimal, 16 dígitos */
+static void print_hex(EFI_SYSTEM_TABLE *st, const char *label, uint64_t value) {
+    char buf[19] = { '0', 'x' };
+    for (int i = 0; i < 16; i++) {
+        buf[2 + i] = "0123456789ABCDEF"[(value >> (60 - 4 * i)) & 0xF];
+    }
+    buf[18] = 0;
+    print_ascii(st, label);
+    print_ascii(st, buf);
+}
+
+/* Resumo do handoff: região ramdisk + arena e o mapa de memória convertido */
+static void print_boot_summary(EFI_SYSTEM_TABLE *st, const ArcBootInfo *info) {
+    const ArcMemRegion *regions = (const ArcMemRegion *)(uintptr_t)info->mem_regions_paddr;
+    uint64_t usable = 0, loader = 0;
+
+    for (uint32_t i = 0; i < info->mem_region_count; i++) {
+        if (regions[i].type == 1) {
+            usable += regions[i].length;
+        } else if (regions[i].type == ARC_MEM_TYPE_LOADER) {
+            loader += regions[i].length;
+        }
+    }
+    print_hex(st, "Ramdisk ", info->ramdisk_paddr);
+    print_hex(st, " bytes ", info->ramdisk_size);
+    print_hex(st, "\r\nArena   ", info->arena_paddr);
+    print_hex(st, " bytes ", info->arena_size);
+    print_hex(st, "\r\nMapa: regioes ", info->mem_region_count);
+    print_hex(st, " usavel ", usable);
+    print_hex(st, " loader ", loader);
+    print_ascii(st, "\r\n");
+}
+
+EFI_STATUS EFIAPI efi_main(EFI_HANDLE ImageHandle, EFI_SYSTEM_TABLE *SystemTable) {
     const CHAR16 msg[] = { 'A','r','c','a','n','O','S',' ', 'U','E','F','I',' ','B','o','o','t','l','o','a','d','e','r',0x0D,0x0A,0 };
-    if (SystemTable && SystemTable->ConOut && SystemTable->ConOut->OutputString) {
-        SystemTable->ConOut->OutputString(SystemTable->ConOut, (CHAR16*)msg);
+    const CHAR16 err[] = { 'A','l','l','o','c',' ','f','a','i','l','e','d',0x0D,0x0A,0 };
+    print(SystemTable, msg);
+
+    uefi_boot_services_init(SystemTable);
+
+    /* Aqui você carregaria o kernel ELF/PE (também como EfiLoaderData) */
+
+    /* Ramdisk + arena contíguos e alinhados a 2 MiB: o ZipArchiveLoader descompacta
+       direto neles, sem realocação, e o kernel os mapeia com páginas grandes. */
+    ArcBootInfo *info = uefi_prepare_boot_info(ARC_RAMDISK_BYTES, ARC_ARENA_BYTES);
+    if (info == 0) {
+        print(SystemTable, err);
+        return EFI_OUT_OF_RESOURCES;
+    }
+
+    /* Resumo com o mapa atual (o definitivo é lido de novo em ExitBootServices) */
+    if (!EFI_ERROR(uefi_snapshot_memory_map(info))) {
+        print_boot_summary(SystemTable, info);
+    }
+
+#ifdef ARC_KERNEL_ENTRY
+    /* Nenhuma alocação (nem saída no console) entre aqui e ExitBootServices */
+    EFI_STATUS status = uefi_exit_boot_services(ImageHandle, info);
+    if (EFI_ERROR(status)) {
+        return status;
+    }
+
+    ARC_KERNEL_ENTRY(info);
+    for (;;) {
+        __asm__ volatile("hlt"); /* O kernel não retorna; sem Boot Services não há para onde voltar */
     }
-    /* Aqui você chamaria serviços de boot e carregaria o kernel ELF/PE */
+#else
+    (void)ImageHandle;
+    print_ascii(SystemTable, "Nenhum kernel ligado: voltando ao firmware\r\n");
     return EFI_SUCCESS;
+#endif
 }
 
 /* For EDK2 the entry point name is different; this is minimal example. */
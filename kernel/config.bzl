@@ -16,6 +16,7 @@ def _load_kernel_config():
         "ENABLE_VIRTUAL_MEMORY": True,
         "ENABLED_DRIVERS": ["nvme", "sdmmc", "ethernet_mac", "wifi_80211"],
         "MEM_BASE_ADDR": "0x80000000",
+        "MAX_MEMORY_LIMIT_MB": 4096,
     }
 
 # Expor o dicionario de configuracao como uma constante
@@ -36,6 +37,12 @@ def arcanos_kernel_cflags(config):
     if "nvme" in config["ENABLED_DRIVERS"]:
         cflags.append("-DCONFIG_DRIVER_NVME")
 
+    # Limite usado pelo alocador de paginas (mm/page_alloc.h)
+    cflags.append("-DCONFIG_MAX_MEMORY_LIMIT_MB=%d" % config["MAX_MEMORY_LIMIT_MB"])
+
+    # Endereco fisico do kernel, mapeado pelas tabelas do boot (libbootloader/paging.h)
+    cflags.append("-DCONFIG_MEM_BASE_ADDR=%sull" % config["MEM_BASE_ADDR"])
+
     cflags.append("-DARC_ARCH=\"%s\"" % config["ARCH"])
     
     return cflags
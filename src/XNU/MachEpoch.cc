@@ -0,0 +1,127 @@
+//
+// Reclamação por épocas usada pelo registro de portas/tarefas Mach.
+// Arquivo: src/XNU/MachEpoch.cc
+//
+
+#include "MachEpoch.h"
+#include <thread>
+
+namespace arcanos::xnu::mach {
+
+// A partir deste número de objetos pendentes, retire() tenta liberar
+static constexpr size_t kReclaimThreshold = 64;
+
+namespace {
+
+// Slot de leitor da thread atual, devolvido quando a thread termina
+struct ThreadReader {
+    std::atomic<uint64_t>* epoch = nullptr;
+    std::atomic<bool>* in_use = nullptr;
+    unsigned depth = 0;
+
+    ~ThreadReader() {
+        if (in_use) {
+            in_use->store(false, std::memory_order_release);
+        }
+    }
+};
+
+thread_local ThreadReader tls_reader;
+
+} // namespace
+
+EpochDomain& EpochDomain::global() {
+    static EpochDomain domain;
+    return domain;
+}
+
+EpochDomain::~EpochDomain() {
+    for (const Retired& r : retired_) {
+        r.deleter(r.ptr);
+    }
+}
+
+EpochDomain::ReaderSlot* EpochDomain::acquireSlot() {
+    for (;;) {
+        for (ReaderSlot& s : readers_) {
+            bool expected = false;
+            if (!s.in_use.load(std::memory_order_relaxed) &&
+                s.in_use.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                return &s;
+            }
+        }
+        std::this_thread::yield(); // Mais de kMaxReaders threads lendo ao mesmo tempo
+    }
+}
+
+void EpochDomain::enter() {
+    if (tls_reader.depth++ > 0) {
+        return;
+    }
+    if (tls_reader.epoch == nullptr) {
+        ReaderSlot* slot = acquireSlot();
+        tls_reader.epoch = &slot->epoch;
+        tls_reader.in_use = &slot->in_use;
+    }
+
+    // Anuncia a época e confirma que ela não avançou antes do anúncio ficar
+    // visível; caso contrário um retire() concorrente poderia não nos ver.
+    uint64_t e = global_epoch_.load(std::memory_order_relaxed);
+    for (;;) {
+        tls_reader.epoch->store(e, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        uint64_t now = global_epoch_.load(std::memory_order_relaxed);
+        if (now == e) {
+            break;
+        }
+        e = now;
+    }
+}
+
+void EpochDomain::exit() {
+    if (--tls_reader.depth > 0) {
+        return;
+    }
+    tls_reader.epoch->store(0, std::memory_order_release);
+}
+
+void EpochDomain::reclaimLocked() {
+    uint64_t oldest = UINT64_MAX;
+    for (const ReaderSlot& s : readers_) {
+        uint64_t e = s.epoch.load(std::memory_order_acquire);
+        if (e != 0 && e < oldest) {
+            oldest = e;
+        }
+    }
+
+    size_t kept = 0;
+    for (const Retired& r : retired_) {
+        if (r.epoch < oldest) {
+            r.deleter(r.ptr);
+        } else {
+            retired_[kept++] = r;
+        }
+    }
+    retired_.resize(kept);
+}
+
+void EpochDomain::retire(void* ptr, void (*deleter)(void*)) {
+    // O objeto já foi desligado: leitores que anunciarem uma época posterior
+    // ao avanço abaixo não podem alcançá-lo.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    uint64_t epoch = global_epoch_.fetch_add(1, std::memory_order_seq_cst);
+
+    std::lock_guard<std::mutex> lock(retire_mutex_);
+    retired_.push_back({ptr, deleter, epoch});
+    if (retired_.size() >= kReclaimThreshold) {
+        reclaimLocked();
+    }
+}
+
+void EpochDomain::reclaim() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::lock_guard<std::mutex> lock(retire_mutex_);
+    reclaimLocked();
+}
+
+} // namespace arcanos::xnu::mach
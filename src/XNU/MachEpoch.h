@@ -0,0 +1,76 @@
+#ifndef ARCANOS_XNU_MACH_EPOCH_H
+#define ARCANOS_XNU_MACH_EPOCH_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace arcanos::xnu::mach {
+
+/**
+ * @brief Reclamação baseada em épocas para as estruturas do registro Mach.
+ * Leitores entram em uma seção crítica (Guard) sem travas; objetos removidos
+ * são entregues a retire() e só liberados quando nenhum leitor pode enxergá-los.
+ */
+class EpochDomain {
+public:
+    static constexpr size_t kMaxReaders = 256;
+
+    // Domínio único, compartilhado por todas as instâncias de XnuMachInterface
+    static EpochDomain& global();
+
+    EpochDomain(const EpochDomain&) = delete;
+    EpochDomain& operator=(const EpochDomain&) = delete;
+
+    // Seção de leitura. Aninhável; ponteiros lidos valem até o fim do Guard externo.
+    class Guard {
+    public:
+        Guard() { EpochDomain::global().enter(); }
+        ~Guard() { EpochDomain::global().exit(); }
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+    };
+
+    // Agenda a liberação de um objeto já desligado de todas as estruturas
+    void retire(void* ptr, void (*deleter)(void*));
+
+    template <typename T>
+    void retire(T* ptr) {
+        retire(ptr, [](void* p) { delete static_cast<T*>(p); });
+    }
+
+    // Libera o que nenhum leitor ativo pode mais referenciar
+    void reclaim();
+
+private:
+    struct alignas(64) ReaderSlot {
+        std::atomic<uint64_t> epoch{0}; // 0 = fora de seção crítica
+        std::atomic<bool> in_use{false};
+    };
+
+    struct Retired {
+        void* ptr;
+        void (*deleter)(void*);
+        uint64_t epoch;
+    };
+
+    EpochDomain() = default;
+    ~EpochDomain();
+
+    ReaderSlot* acquireSlot();
+    void enter();
+    void exit();
+    void reclaimLocked();
+
+    ReaderSlot readers_[kMaxReaders];
+    std::atomic<uint64_t> global_epoch_{1};
+
+    std::mutex retire_mutex_;
+    std::vector<Retired> retired_;
+};
+
+} // namespace arcanos::xnu::mach
+
+#endif // ARCANOS_XNU_MACH_EPOCH_H
@@ -0,0 +1,66 @@
+#ifndef ARCANOS_XNU_MACH_MESSAGE_H
+#define ARCANOS_XNU_MACH_MESSAGE_H
+
+#include "MachTypes.h"
+#include "MachOolBuffer.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+
+namespace arcanos::xnu::mach {
+
+/**
+ * @brief Mensagem Mach: cabeçalho, corpo inline pequeno e dados out-of-line.
+ * Corpos até kInlineMax bytes viajam dentro da própria mensagem (sem alocação).
+ * Dados maiores vão em 'ool', um MachOolBuffer cuja posse passa do emissor para
+ * o receptor sem cópia do conteúdo.
+ */
+struct MachMessage {
+    static constexpr size_t kInlineMax = 128;
+
+    mach_port_t remote_port = MACH_PORT_NULL; // Destino
+    mach_port_t local_port = MACH_PORT_NULL;  // Porta de resposta (opcional)
+    uint32_t msgh_id = 0;
+
+    uint32_t inline_size = 0;
+    uint8_t inline_data[kInlineMax];
+    MachOolBuffer ool;
+
+    // Copia o corpo para a área inline ou, se não couber, para um novo buffer 'ool'.
+    // Para payloads grandes prefira attachOol(), que não copia.
+    void setBody(const void* data, size_t size) {
+        if (size <= kInlineMax) {
+            std::memcpy(inline_data, data, size);
+            inline_size = static_cast<uint32_t>(size);
+            ool.reset();
+        } else {
+            inline_size = 0;
+            ool = MachOolBuffer::allocate(size);
+            if (ool) {
+                std::memcpy(ool.data(), data, size);
+            }
+        }
+    }
+
+    // Transfere a posse do buffer para a mensagem (sem cópia)
+    void attachOol(MachOolBuffer&& buffer) {
+        inline_size = 0;
+        ool = std::move(buffer);
+    }
+
+    // Retira o buffer out-of-line da mensagem recebida (sem cópia)
+    MachOolBuffer takeOol() { return std::move(ool); }
+
+    std::string body() const {
+        if (inline_size > 0) {
+            return std::string(reinterpret_cast<const char*>(inline_data), inline_size);
+        }
+        return std::string(reinterpret_cast<const char*>(ool.data()), ool.size());
+    }
+};
+
+} // namespace arcanos::xnu::mach
+
+#endif // ARCANOS_XNU_MACH_MESSAGE_H
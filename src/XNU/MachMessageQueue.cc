@@ -0,0 +1,294 @@
+//
+// Filas de mensagens das portas Mach.
+// Arquivo: src/XNU/MachMessageQueue.cc
+//
+
+#include "MachMessageQueue.h"
+#include <chrono>
+#include <thread>
+
+namespace arcanos::xnu::mach {
+
+// DROP_OLDEST: tentativas de abrir espaço antes de desistir com SEND_NO_BUFFER
+static constexpr int kDropOldestAttempts = 64;
+
+static size_t roundUpPow2(size_t n) {
+    size_t p = 2;
+    while (p < n) {
+        p <<= 1;
+    }
+    return p;
+}
+
+MachMessageQueue::MachMessageQueue(size_t limit)
+    : mask_(roundUpPow2(limit) - 1), cells_(new Cell[mask_ + 1]) {
+    for (size_t i = 0; i <= mask_; i++) {
+        cells_[i].seq.store(i, std::memory_order_relaxed);
+    }
+}
+
+// Anel de Vyukov: cell.seq == pos -> livre para o produtor da posição 'pos';
+// cell.seq == pos + 1 -> preenchida, pronta para o consumidor.
+bool MachMessageQueue::tryEnqueue(MachMessage& msg) {
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    for (;;) {
+        Cell& cell = cells_[pos & mask_];
+        size_t seq = cell.seq.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                cell.msg = std::move(msg);
+                cell.seq.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false; // Cheia
+        } else {
+            pos = enqueue_pos_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool MachMessageQueue::tryDequeue(MachMessage& out) {
+    size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    for (;;) {
+        Cell& cell = cells_[pos & mask_];
+        size_t seq = cell.seq.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+        if (diff == 0) {
+            if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                out = std::move(cell.msg);
+                cell.seq.store(pos + mask_ + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false; // Vazia
+        } else {
+            pos = dequeue_pos_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+// Lotes: conta quantos slots consecutivos a partir de 'pos' estão no estado
+// esperado e reserva todos de uma vez. Se o CAS vence, ninguém mais tocou em
+// posições >= pos, então os slots vistos continuam nossos.
+size_t MachMessageQueue::tryEnqueueBatch(MachMessage* msgs, size_t count) {
+    if (count == 0) {
+        return 0;
+    }
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    for (;;) {
+        size_t n = 0;
+        while (n < count && n <= mask_ &&
+               cells_[(pos + n) & mask_].seq.load(std::memory_order_acquire) == pos + n) {
+            n++;
+        }
+        if (n == 0) {
+            size_t seq = cells_[pos & mask_].seq.load(std::memory_order_acquire);
+            if (static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos) < 0) {
+                return 0; // Cheia
+            }
+            pos = enqueue_pos_.load(std::memory_order_relaxed);
+            continue;
+        }
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + n, std::memory_order_relaxed)) {
+            for (size_t i = 0; i < n; i++) {
+                Cell& cell = cells_[(pos + i) & mask_];
+                cell.msg = std::move(msgs[i]);
+                cell.seq.store(pos + i + 1, std::memory_order_release);
+            }
+            return n;
+        }
+    }
+}
+
+size_t MachMessageQueue::tryDequeueBatch(MachMessage* out, size_t max) {
+    if (max == 0) {
+        return 0;
+    }
+    size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    for (;;) {
+        size_t n = 0;
+        while (n < max && n <= mask_ &&
+               cells_[(pos + n) & mask_].seq.load(std::memory_order_acquire) == pos + n + 1) {
+            n++;
+        }
+        if (n == 0) {
+            size_t seq = cells_[pos & mask_].seq.load(std::memory_order_acquire);
+            if (static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1) < 0) {
+                return 0; // Vazia
+            }
+            pos = dequeue_pos_.load(std::memory_order_relaxed);
+            continue;
+        }
+        if (dequeue_pos_.compare_exchange_weak(pos, pos + n, std::memory_order_relaxed)) {
+            for (size_t i = 0; i < n; i++) {
+                Cell& cell = cells_[(pos + i) & mask_];
+                out[i] = std::move(cell.msg);
+                cell.seq.store(pos + i + mask_ + 1, std::memory_order_release);
+            }
+            return n;
+        }
+    }
+}
+
+static MachWaitQueue::Clock::time_point deadlineFor(mach_msg_timeout_t timeout_ms) {
+    if (timeout_ms == MACH_MSG_TIMEOUT_INFINITE) {
+        return MachWaitQueue::Clock::time_point::max();
+    }
+    return MachWaitQueue::Clock::now() + std::chrono::milliseconds(timeout_ms);
+}
+
+MachResult MachMessageQueue::send(MachMessage&& msg, MachSendPolicy policy, mach_msg_timeout_t timeout_ms) {
+    if (closed_.load(std::memory_order_acquire)) {
+        return MachResult::PORT_DEAD;
+    }
+
+    if (tryEnqueue(msg)) {
+        not_empty_.notifyOne();
+        return MachResult::SUCCESS;
+    }
+
+    switch (policy) {
+    case MachSendPolicy::FAIL:
+        return MachResult::SEND_NO_BUFFER;
+
+    case MachSendPolicy::DROP_OLDEST: {
+        // O slot liberado pode ser tomado por outro emissor, e a mensagem mais
+        // antiga pode estar sendo escrita por um emissor preemptado (tryDequeue
+        // falha): espera com pausa crescente, depois cede a CPU, e desiste
+        // depois de kDropOldestAttempts voltas.
+        MachMessage oldest;
+        for (int attempt = 0; !tryEnqueue(msg); attempt++) {
+            if (attempt == kDropOldestAttempts || closed_.load(std::memory_order_acquire)) {
+                return attempt == kDropOldestAttempts ? MachResult::SEND_NO_BUFFER : MachResult::PORT_DEAD;
+            }
+            if (tryDequeue(oldest)) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            if (attempt < 6) {
+                for (int i = 0; i < (1 << attempt); i++) {
+                    machCpuRelax();
+                }
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        not_empty_.notifyOne();
+        return MachResult::SUCCESS;
+    }
+
+    case MachSendPolicy::BLOCK:
+        break;
+    }
+
+    if (timeout_ms == MACH_MSG_TIMEOUT_NONE) {
+        return MachResult::SEND_TIMED_OUT;
+    }
+    auto deadline = deadlineFor(timeout_ms);
+
+    for (;;) {
+        uint32_t ticket = not_full_.prepareWait();
+        if (tryEnqueue(msg)) {
+            not_full_.cancelWait();
+            break;
+        }
+        if (closed_.load(std::memory_order_acquire)) {
+            not_full_.cancelWait();
+            return MachResult::PORT_DEAD;
+        }
+        if (!not_full_.wait(ticket, deadline)) {
+            if (tryEnqueue(msg)) {
+                break;
+            }
+            return MachResult::SEND_TIMED_OUT;
+        }
+    }
+    not_empty_.notifyOne();
+    return MachResult::SUCCESS;
+}
+
+MachResult MachMessageQueue::receive(MachMessage& out, mach_msg_timeout_t timeout_ms, bool handoff) {
+    if (tryDequeue(out)) {
+        not_full_.notifyOne();
+        return MachResult::SUCCESS;
+    }
+    if (closed_.load(std::memory_order_acquire)) {
+        return MachResult::PORT_DEAD;
+    }
+    if (timeout_ms == MACH_MSG_TIMEOUT_NONE) {
+        return MachResult::RCV_TIMED_OUT;
+    }
+    auto deadline = deadlineFor(timeout_ms);
+
+    for (;;) {
+        uint32_t ticket = not_empty_.prepareWait();
+        if (tryDequeue(out)) {
+            not_empty_.cancelWait();
+            break;
+        }
+        if (closed_.load(std::memory_order_acquire)) {
+            not_empty_.cancelWait();
+            return MachResult::PORT_DEAD;
+        }
+        if (!not_empty_.wait(ticket, deadline, handoff)) {
+            if (tryDequeue(out)) {
+                break;
+            }
+            return MachResult::RCV_TIMED_OUT;
+        }
+        handoff = false; // Cede a CPU só na primeira espera
+    }
+    not_full_.notifyOne();
+    return MachResult::SUCCESS;
+}
+
+size_t MachMessageQueue::sendBatch(MachMessage* msgs, size_t count) {
+    if (count == 0 || closed_.load(std::memory_order_acquire)) {
+        return 0;
+    }
+    size_t sent = 0;
+    while (sent < count) {
+        size_t n = tryEnqueueBatch(msgs + sent, count - sent);
+        if (n == 0) {
+            break;
+        }
+        sent += n;
+    }
+    if (sent > 0) {
+        not_empty_.notifyAll(); // Lote pode servir vários receptores
+    }
+    return sent;
+}
+
+size_t MachMessageQueue::receiveBatch(MachMessage* out, size_t max, mach_msg_timeout_t timeout_ms,
+                                      MachResult* result) {
+    *result = MachResult::SUCCESS;
+    if (max == 0) {
+        return 0;
+    }
+    size_t n = tryDequeueBatch(out, max);
+    if (n == 0) {
+        // Espera pela primeira mensagem pelo caminho normal e completa o lote
+        *result = receive(out[0], timeout_ms);
+        if (*result != MachResult::SUCCESS) {
+            return 0;
+        }
+        size_t more = tryDequeueBatch(out + 1, max - 1);
+        if (more > 0) {
+            not_full_.notifyAll();
+        }
+        return 1 + more;
+    }
+    not_full_.notifyAll();
+    return n;
+}
+
+void MachMessageQueue::close() {
+    closed_.store(true, std::memory_order_release);
+    not_empty_.notifyAll();
+    not_full_.notifyAll();
+}
+
+} // namespace arcanos::xnu::mach
@@ -0,0 +1,80 @@
+#ifndef ARCANOS_XNU_MACH_MESSAGE_QUEUE_H
+#define ARCANOS_XNU_MACH_MESSAGE_QUEUE_H
+
+#include "MachMessage.h"
+#include "MachWaitQueue.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace arcanos::xnu::mach {
+
+/**
+ * @brief Fila limitada de mensagens de uma porta Mach.
+ *
+ * Anel com número de sequência por slot: envios de vários produtores e
+ * recebimentos não usam travas. As MachWaitQueue só entram em cena quando
+ * alguém precisa dormir (receptor com fila vazia ou emissor BLOCK com fila cheia).
+ */
+class MachMessageQueue {
+public:
+    static constexpr size_t kDefaultLimit = 64;
+
+    // A capacidade é arredondada para potência de 2
+    explicit MachMessageQueue(size_t limit = kDefaultLimit);
+    MachMessageQueue(const MachMessageQueue&) = delete;
+    MachMessageQueue& operator=(const MachMessageQueue&) = delete;
+
+    // Enfileira (movendo 'msg') conforme a política para fila cheia
+    MachResult send(MachMessage&& msg, MachSendPolicy policy, mach_msg_timeout_t timeout_ms);
+
+    // Retira a mensagem mais antiga, esperando até timeout_ms (0 = poll).
+    // 'handoff': o chamador acabou de acordar quem vai responder (ver MachWaitQueue::wait).
+    MachResult receive(MachMessage& out, mach_msg_timeout_t timeout_ms, bool handoff = false);
+
+    // Enfileira até 'count' mensagens de 'msgs' (movidas, em ordem) reservando os
+    // slots com um único CAS. Não bloqueia; retorna quantas entraram.
+    size_t sendBatch(MachMessage* msgs, size_t count);
+
+    // Retira até 'max' mensagens com um único CAS. Se a fila estiver vazia, espera
+    // pela primeira até timeout_ms. Retorna quantas foram recebidas (0 = timeout
+    // ou porta morta; ver 'result').
+    size_t receiveBatch(MachMessage* out, size_t max, mach_msg_timeout_t timeout_ms, MachResult* result);
+
+    // Marca a fila como morta e acorda todos os que esperam nela
+    void close();
+
+    size_t capacity() const { return mask_ + 1; }
+    uint64_t droppedCount() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    struct Cell {
+        std::atomic<size_t> seq;
+        MachMessage msg;
+    };
+
+    bool tryEnqueue(MachMessage& msg);
+    bool tryDequeue(MachMessage& out);
+    size_t tryEnqueueBatch(MachMessage* msgs, size_t count);
+    size_t tryDequeueBatch(MachMessage* out, size_t max);
+
+    const size_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+
+    alignas(64) std::atomic<size_t> enqueue_pos_{0};
+    alignas(64) std::atomic<size_t> dequeue_pos_{0};
+
+    alignas(64) MachWaitQueue not_empty_; // Receptores esperando mensagem
+    alignas(64) MachWaitQueue not_full_;  // Emissores BLOCK esperando espaço
+    std::atomic<bool> closed_{false};
+    std::atomic<uint64_t> dropped_{0};
+};
+
+// Autoteste e benchmark de vazão 1:1 / N:1 / N:M e por tamanho de lote (MachMessageQueue_test.cc)
+int queue_run_selftest();
+void queue_run_benchmark(unsigned max_threads);
+
+} // namespace arcanos::xnu::mach
+
+#endif // ARCANOS_XNU_MACH_MESSAGE_QUEUE_H
@@ -0,0 +1,70 @@
+//
+// Buffers out-of-line das mensagens Mach.
+// Arquivo: src/XNU/MachOolBuffer.cc
+//
+
+#include "MachOolBuffer.h"
+#include <cstdlib>
+#include <new>
+#include <sys/mman.h>
+
+namespace arcanos::xnu::mach {
+
+MachOolBuffer MachOolBuffer::create(size_t size, bool shared) {
+    size_t mapped = (size + kPageSize - 1) & ~(kPageSize - 1);
+    if (mapped == 0) {
+        mapped = kPageSize;
+    }
+
+    void* mem;
+    if (shared) {
+        mem = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (mem == MAP_FAILED) {
+            return MachOolBuffer();
+        }
+    } else {
+        mem = std::aligned_alloc(kPageSize, mapped);
+        if (mem == nullptr) {
+            return MachOolBuffer();
+        }
+    }
+
+    Block* block = new (std::nothrow) Block;
+    if (block == nullptr) {
+        if (shared) {
+            munmap(mem, mapped);
+        } else {
+            std::free(mem);
+        }
+        return MachOolBuffer();
+    }
+    block->data = static_cast<uint8_t*>(mem);
+    block->size = size;
+    block->mapped = mapped;
+    block->shared = shared;
+    return MachOolBuffer(block);
+}
+
+MachOolBuffer MachOolBuffer::allocate(size_t size) {
+    return create(size, false);
+}
+
+MachOolBuffer MachOolBuffer::allocateShared(size_t size) {
+    return create(size, true);
+}
+
+void MachOolBuffer::reset() {
+    Block* block = block_;
+    block_ = nullptr;
+    if (block == nullptr || block->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
+    if (block->shared) {
+        munmap(block->data, block->mapped);
+    } else {
+        std::free(block->data);
+    }
+    delete block;
+}
+
+} // namespace arcanos::xnu::mach
@@ -0,0 +1,90 @@
+#ifndef ARCANOS_XNU_MACH_OOL_BUFFER_H
+#define ARCANOS_XNU_MACH_OOL_BUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace arcanos::xnu::mach {
+
+/**
+ * @brief Buffer out-of-line de uma mensagem Mach (referência contada, alinhado a página).
+ *
+ * É um handle: copiar soma uma referência, mover transfere a posse. Anexado a uma
+ * MachMessage, o buffer viaja do emissor ao receptor sem que o conteúdo seja
+ * copiado, então o custo do envio não depende do tamanho.
+ */
+class MachOolBuffer {
+public:
+    static constexpr size_t kPageSize = 4096;
+
+    MachOolBuffer() = default;
+    ~MachOolBuffer() { reset(); }
+
+    MachOolBuffer(const MachOolBuffer& other) : block_(other.block_) {
+        if (block_) {
+            block_->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    MachOolBuffer(MachOolBuffer&& other) noexcept : block_(other.block_) { other.block_ = nullptr; }
+
+    MachOolBuffer& operator=(const MachOolBuffer& other) {
+        if (this != &other) {
+            MachOolBuffer copy(other);
+            swap(copy);
+        }
+        return *this;
+    }
+    MachOolBuffer& operator=(MachOolBuffer&& other) noexcept {
+        if (this != &other) {
+            reset();
+            block_ = other.block_;
+            other.block_ = nullptr;
+        }
+        return *this;
+    }
+
+    // Buffer privado alinhado a página (tamanho arredondado para páginas)
+    static MachOolBuffer allocate(size_t size);
+
+    // Região de memória compartilhada (mmap MAP_SHARED): continua visível para
+    // processos filhos, como a memória de tarefas Mach compartilhando um objeto VM.
+    static MachOolBuffer allocateShared(size_t size);
+
+    uint8_t* data() const { return block_ ? block_->data : nullptr; }
+    size_t size() const { return block_ ? block_->size : 0; }
+    bool empty() const { return block_ == nullptr; }
+    explicit operator bool() const { return block_ != nullptr; }
+
+    // Verdadeiro quando este handle é o único dono (pode escrever sem corrida)
+    bool unique() const { return block_ && block_->refs.load(std::memory_order_acquire) == 1; }
+
+    void reset();
+    void swap(MachOolBuffer& other) noexcept {
+        Block* b = block_;
+        block_ = other.block_;
+        other.block_ = b;
+    }
+
+private:
+    struct Block {
+        std::atomic<uint32_t> refs{1};
+        uint8_t* data;
+        size_t size;     // Tamanho pedido
+        size_t mapped;   // Tamanho reservado (múltiplo de página)
+        bool shared;
+    };
+
+    explicit MachOolBuffer(Block* block) : block_(block) {}
+    static MachOolBuffer create(size_t size, bool shared);
+
+    Block* block_ = nullptr;
+};
+
+// Autoteste e benchmark do envio sem cópia por uma porta (MachOolBuffer_test.cc)
+int ool_run_selftest();
+void ool_run_benchmark();
+
+} // namespace arcanos::xnu::mach
+
+#endif // ARCANOS_XNU_MACH_OOL_BUFFER_H
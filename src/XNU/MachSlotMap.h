@@ -0,0 +1,242 @@
+#ifndef ARCANOS_XNU_MACH_SLOT_MAP_H
+#define ARCANOS_XNU_MACH_SLOT_MAP_H
+
+#include "MachEpoch.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace arcanos::xnu::mach {
+
+// Número de shards dos mapas de handles (tarefas e portas)
+constexpr size_t kRegistryShards = 16;
+
+// Finalizador do murmur3: espalha ids sequenciais por todos os shards
+inline uint32_t registryHash(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x85ebca6bu;
+    x ^= x >> 13;
+    x *= 0xc2b2ae35u;
+    x ^= x >> 16;
+    return x;
+}
+
+/**
+ * @brief Mapa de slots com geração para handles de tarefas e portas.
+ *
+ * Um handle de 32 bits codifica (geração << kIndexBits) | índice. A busca é um
+ * acesso direto ao slot mais a comparação da geração: um handle antigo de um
+ * slot já reaproveitado é detectado em vez de apontar para o novo objeto.
+ * A geração nunca é 0, logo o handle 0 (MACH_PORT_NULL) nunca é válido.
+ *
+ * O mapa é dividido em kRegistryShards shards, cada um com trava, fila livre e
+ * blocos próprios: os bits baixos do índice escolhem o
+ * shard. Cada thread insere no seu shard "de casa" (e passa ao seguinte se ele
+ * encher), e remove trava só o shard do handle, então escritas de threads
+ * diferentes raramente disputam a mesma trava. Os blocos nunca se movem:
+ * buscas não travam (dentro de um EpochDomain::Guard).
+ *
+ * Limite da geração: são 12 bits (kGenerationMask = 4095). Um handle antigo só
+ * volta a resolver se o seu slot for reaproveitado 4095 vezes enquanto alguém
+ * ainda guarda o handle. Como cada shard reaproveita slots em ordem FIFO e só
+ * com pelo menos kMinFree slots na fila livre, isso exige mais de
+ * 4095 * kMinFree (~1M) liberações no mesmo shard nesse intervalo.
+ */
+template <typename T>
+class MachSlotMap {
+public:
+    static constexpr uint32_t kIndexBits = 20;                // Até ~1M objetos vivos
+    static constexpr uint32_t kIndexMask = (1u << kIndexBits) - 1;
+    static constexpr uint32_t kGenerationMask = (1u << (32 - kIndexBits)) - 1;
+
+    MachSlotMap() = default;
+    ~MachSlotMap() {
+        for (Shard& shard : shards_) {
+            for (auto& chunk : shard.chunks) {
+                delete[] chunk.load(std::memory_order_relaxed);
+            }
+        }
+    }
+    MachSlotMap(const MachSlotMap&) = delete;
+    MachSlotMap& operator=(const MachSlotMap&) = delete;
+
+    // Guarda 'value' e devolve o handle, ou 0 se o mapa estiver cheio
+    uint32_t insert(T* value) {
+        uint32_t home = homeShard();
+        for (uint32_t i = 0; i < kShards; i++) {
+            uint32_t s = (home + i) & (kShards - 1);
+            uint32_t handle = insertInto(s, value);
+            if (handle != 0) {
+                return handle;
+            }
+        }
+        return 0;
+    }
+
+    // Busca sem travas. Chamar dentro de um EpochDomain::Guard.
+    T* find(uint32_t handle) const {
+        uint32_t index = handle & kIndexMask;
+        uint32_t local = index >> kShardBits;
+        const Slot* chunk = shards_[index & (kShards - 1)].chunks[local >> kChunkBits].load(std::memory_order_acquire);
+        if (chunk == nullptr) {
+            return nullptr;
+        }
+        const Slot& s = chunk[local & (kChunkSize - 1)];
+        uint32_t expected = ((handle >> kIndexBits) << 1) | 1u;
+        if (s.state.load(std::memory_order_acquire) != expected) {
+            return nullptr;
+        }
+        T* value = s.value.load(std::memory_order_acquire);
+        // Confirma que o slot não foi liberado/reaproveitado entre as duas leituras
+        if (s.state.load(std::memory_order_acquire) != expected) {
+            return nullptr;
+        }
+        return value;
+    }
+
+    // Libera o handle e devolve o objeto (a ser aposentado pelo chamador), ou nullptr
+    T* remove(uint32_t handle) {
+        uint32_t index = handle & kIndexMask;
+        uint32_t local = index >> kShardBits;
+        Shard& shard = shards_[index & (kShards - 1)];
+        std::lock_guard<std::mutex> lock(shard.lock);
+        if (local >= shard.high_water) {
+            return nullptr;
+        }
+        Slot& s = slot(shard, local);
+        uint32_t state = s.state.load(std::memory_order_relaxed);
+        if (state != (((handle >> kIndexBits) << 1) | 1u)) {
+            return nullptr; // Handle antigo ou inválido
+        }
+
+        T* value = s.value.load(std::memory_order_relaxed);
+        s.state.store(state & ~1u, std::memory_order_release); // Mantém a geração
+        s.value.store(nullptr, std::memory_order_relaxed);
+
+        s.next_free = 0;
+        if (shard.free_count == 0) {
+            shard.free_head = local;
+        } else {
+            slot(shard, shard.free_tail).next_free = local;
+        }
+        shard.free_tail = local;
+        shard.free_count++;
+        shard.live--;
+        return value;
+    }
+
+    // Visita todos os pares (handle, objeto). Chamar dentro de um EpochDomain::Guard.
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        for (uint32_t s = 0; s < kShards; s++) {
+            for (uint32_t c = 0; c < kChunksPerShard; c++) {
+                const Slot* chunk = shards_[s].chunks[c].load(std::memory_order_acquire);
+                if (chunk == nullptr) {
+                    break; // Blocos de um shard são alocados em ordem
+                }
+                for (uint32_t i = 0; i < kChunkSize; i++) {
+                    uint32_t state = chunk[i].state.load(std::memory_order_acquire);
+                    T* value = chunk[i].value.load(std::memory_order_acquire);
+                    if ((state & 1u) && value != nullptr) {
+                        uint32_t index = ((c << kChunkBits | i) << kShardBits) | s;
+                        fn(((state >> 1) << kIndexBits) | index, value);
+                    }
+                }
+            }
+        }
+    }
+
+    size_t size() const {
+        size_t live = 0;
+        for (const Shard& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.lock);
+            live += shard.live;
+        }
+        return live;
+    }
+
+private:
+    static constexpr uint32_t kShards = kRegistryShards;
+    static constexpr uint32_t kShardBits = 4;
+    static_assert((1u << kShardBits) == kShards, "kShardBits segue kRegistryShards");
+    static constexpr uint32_t kLocalLimit = 1u << (kIndexBits - kShardBits); // Slots por shard
+    static constexpr uint32_t kChunkBits = 10;
+    static constexpr uint32_t kChunkSize = 1u << kChunkBits;
+    static constexpr uint32_t kChunksPerShard = kLocalLimit / kChunkSize;
+    static constexpr uint32_t kMinFree = 256;
+
+    struct Slot {
+        std::atomic<uint32_t> state{0}; // (geração << 1) | vivo
+        std::atomic<T*> value{nullptr};
+        uint32_t next_free = 0;         // Fila livre (protegida pela trava do shard)
+    };
+
+    struct alignas(64) Shard {
+        mutable std::mutex lock;        // Escritas neste shard
+        uint32_t high_water = 0;        // Slots já usados ao menos uma vez
+        uint32_t free_head = 0;
+        uint32_t free_tail = 0;
+        uint32_t free_count = 0;
+        size_t live = 0;
+        std::atomic<Slot*> chunks[kChunksPerShard] = {};
+    };
+
+    static Slot& slot(Shard& shard, uint32_t local) {
+        return shard.chunks[local >> kChunkBits].load(std::memory_order_relaxed)[local & (kChunkSize - 1)];
+    }
+
+    // Shard de casa da thread atual: threads diferentes começam em shards diferentes
+    static uint32_t homeShard() {
+        static std::atomic<uint32_t> next_thread{0};
+        thread_local uint32_t home = registryHash(next_thread.fetch_add(1, std::memory_order_relaxed) + 1);
+        return home & (kShards - 1);
+    }
+
+    uint32_t insertInto(uint32_t s, T* value) {
+        Shard& shard = shards_[s];
+        std::lock_guard<std::mutex> lock(shard.lock);
+        uint32_t local;
+        // Reaproveita slots em ordem FIFO e só com folga na fila livre: cada slot
+        // passa por muitos outros antes de voltar, adiando a volta da geração.
+        if (shard.free_count > kMinFree || shard.high_water >= kLocalLimit) {
+            if (shard.free_count == 0) {
+                return 0; // Shard cheio
+            }
+            local = shard.free_head;
+            shard.free_head = slot(shard, local).next_free;
+            shard.free_count--;
+        } else {
+            local = shard.high_water;
+            Slot* chunk = shard.chunks[local >> kChunkBits].load(std::memory_order_relaxed);
+            if (chunk == nullptr) {
+                chunk = new Slot[kChunkSize];
+                shard.chunks[local >> kChunkBits].store(chunk, std::memory_order_release);
+            }
+            shard.high_water++;
+        }
+
+        Slot& sl = slot(shard, local);
+        uint32_t gen = (sl.state.load(std::memory_order_relaxed) >> 1) + 1;
+        gen &= kGenerationMask;
+        if (gen == 0) {
+            gen = 1;
+        }
+        sl.value.store(value, std::memory_order_relaxed);
+        sl.state.store((gen << 1) | 1u, std::memory_order_release);
+        shard.live++;
+        return (gen << kIndexBits) | (local << kShardBits) | s;
+    }
+
+    Shard shards_[kShards];
+};
+
+// Autoteste e benchmarks do mapa de slots (MachSlotMap_test.cc): insert/remove
+// e buscas concorrentes contra std::map
+int slot_map_run_selftest();
+void slot_map_run_benchmark(unsigned max_threads);
+void registry_run_benchmark(unsigned max_threads);
+
+} // namespace arcanos::xnu::mach
+
+#endif // ARCANOS_XNU_MACH_SLOT_MAP_H
@@ -0,0 +1,41 @@
+#ifndef ARCANOS_XNU_MACH_TYPES_H
+#define ARCANOS_XNU_MACH_TYPES_H
+
+#include <cstdint>
+
+namespace arcanos::xnu::mach {
+
+// Tipos de dados fundamentais do Mach Kernel (simulados)
+using mach_port_t = unsigned int;
+using mach_task_t = unsigned int;
+using mach_msg_timeout_t = uint32_t; // Milissegundos
+
+constexpr mach_port_t MACH_PORT_NULL = 0;
+
+// Timeouts de envio/recebimento
+constexpr mach_msg_timeout_t MACH_MSG_TIMEOUT_NONE = 0;              // Não bloqueia (poll)
+constexpr mach_msg_timeout_t MACH_MSG_TIMEOUT_INFINITE = UINT32_MAX; // Bloqueia sem limite
+
+// Códigos de Retorno XNU/Mach (simulados)
+enum class MachResult {
+    SUCCESS,
+    INVALID_ARGUMENT,
+    PORT_NOT_FOUND,
+    NO_MEMORY,
+    SEND_NO_BUFFER,   // Fila cheia com MachSendPolicy::FAIL
+    SEND_TIMED_OUT,
+    RCV_TIMED_OUT,    // Também retornado por poll sem mensagem
+    PORT_DEAD         // A porta foi destruída enquanto a operação esperava
+};
+
+// Comportamento de envio com a fila da porta cheia
+enum class MachSendPolicy {
+    FAIL,        // Retorna SEND_NO_BUFFER
+    BLOCK,       // Espera espaço (até o timeout)
+    DROP_OLDEST  // Descarta a mensagem mais antiga da fila (SEND_NO_BUFFER se
+                 // outros emissores tomarem o espaço várias vezes seguidas)
+};
+
+} // namespace arcanos::xnu::mach
+
+#endif // ARCANOS_XNU_MACH_TYPES_H
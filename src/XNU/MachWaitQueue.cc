@@ -0,0 +1,130 @@
+//
+// Espera/notificação das portas Mach.
+// Arquivo: src/XNU/MachWaitQueue.cc
+//
+
+#include "MachWaitQueue.h"
+#include <climits>
+#include <thread>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+namespace arcanos::xnu::mach {
+
+// Iterações de espera ativa antes de dormir (só com mais de um núcleo)
+static constexpr int kSpinIterations = 4000;
+// Vezes que o chamador cede a CPU ao par no caminho de hand-off
+static constexpr int kHandoffYields = 16;
+
+static bool multiCore() {
+    static const bool multi = std::thread::hardware_concurrency() > 1;
+    return multi;
+}
+
+#if defined(__linux__)
+static void futexWait(std::atomic<uint32_t>* addr, uint32_t expected, const struct timespec* timeout) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAIT_PRIVATE, expected, timeout, nullptr, 0);
+}
+
+static void futexWake(std::atomic<uint32_t>* addr, int count) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+}
+#endif
+
+uint32_t MachWaitQueue::prepareWait() {
+    waiters_.fetch_add(1, std::memory_order_relaxed);
+    // O contador precisa estar visível antes da nova checagem da condição
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return seq_.load(std::memory_order_acquire);
+}
+
+void MachWaitQueue::cancelWait() {
+    waiters_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+bool MachWaitQueue::wait(uint32_t ticket, Clock::time_point deadline, bool handoff) {
+    bool notified = false;
+
+    if (handoff) {
+        for (int i = 0; i < kHandoffYields && !notified; i++) {
+#if defined(__linux__)
+            sched_yield();
+#else
+            std::this_thread::yield();
+#endif
+            notified = seq_.load(std::memory_order_acquire) != ticket;
+        }
+    }
+    if (!notified && multiCore()) {
+        for (int i = 0; i < kSpinIterations; i++) {
+            if (seq_.load(std::memory_order_acquire) != ticket) {
+                notified = true;
+                break;
+            }
+            machCpuRelax();
+        }
+    }
+
+    while (!notified) {
+        if (seq_.load(std::memory_order_acquire) != ticket) {
+            notified = true;
+            break;
+        }
+        auto now = Clock::now();
+        if (now >= deadline) {
+            break;
+        }
+
+#if defined(__linux__)
+        struct timespec ts;
+        const struct timespec* tsp = nullptr;
+        if (deadline != Clock::time_point::max()) {
+            auto left = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - now).count();
+            ts.tv_sec = static_cast<time_t>(left / 1000000000);
+            ts.tv_nsec = static_cast<long>(left % 1000000000);
+            tsp = &ts;
+        }
+        sleepers_.fetch_add(1, std::memory_order_seq_cst);
+        futexWait(&seq_, ticket, tsp);
+        sleepers_.fetch_sub(1, std::memory_order_relaxed);
+#else
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+#endif
+    }
+
+    waiters_.fetch_sub(1, std::memory_order_relaxed);
+    return notified;
+}
+
+bool MachWaitQueue::notify(int count) {
+    // A condição foi publicada antes deste ponto (ver prepareWait)
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters_.load(std::memory_order_relaxed) == 0) {
+        return false;
+    }
+    seq_.fetch_add(1, std::memory_order_seq_cst);
+#if defined(__linux__)
+    if (sleepers_.load(std::memory_order_seq_cst) > 0) {
+        futexWake(&seq_, count);
+    }
+#else
+    (void)count;
+#endif
+    return true;
+}
+
+bool MachWaitQueue::notifyOne() {
+    return notify(1);
+}
+
+void MachWaitQueue::notifyAll() {
+    notify(INT_MAX);
+}
+
+} // namespace arcanos::xnu::mach
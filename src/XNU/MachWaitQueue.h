@@ -0,0 +1,61 @@
+#ifndef ARCANOS_XNU_MACH_WAIT_QUEUE_H
+#define ARCANOS_XNU_MACH_WAIT_QUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace arcanos::xnu::mach {
+
+// Dica de espera ativa para a CPU (laços de polling)
+static inline void machCpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ volatile("yield");
+#endif
+}
+
+/**
+ * @brief Espera/notificação das portas Mach (substituto em espaço de usuário
+ * para a wait queue do scheduler, sobre futex no Linux).
+ *
+ * Protocolo: quem vai dormir chama prepareWait(), testa a condição de novo e
+ * então wait() (ou cancelWait() se a condição já vale). Quem muda a condição
+ * chama notifyOne()/notifyAll() depois de publicá-la. Notificar sem ninguém
+ * esperando custa só uma leitura.
+ */
+class MachWaitQueue {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    MachWaitQueue() = default;
+    MachWaitQueue(const MachWaitQueue&) = delete;
+    MachWaitQueue& operator=(const MachWaitQueue&) = delete;
+
+    // Registra o chamador como esperando e devolve o ticket para wait()
+    uint32_t prepareWait();
+
+    // Desiste de esperar (a condição já era verdadeira na nova checagem)
+    void cancelWait();
+
+    // Espera uma notificação posterior ao ticket ou o prazo. Retorna false em timeout.
+    // 'handoff': o chamador acabou de acordar o par (RPC) e cede a CPU a ele
+    // antes de girar/dormir, como a troca direta do Mach.
+    bool wait(uint32_t ticket, Clock::time_point deadline, bool handoff = false);
+
+    // Acorda um/todos os que esperam. Retorna true se havia alguém esperando.
+    bool notifyOne();
+    void notifyAll();
+
+private:
+    bool notify(int count);
+
+    std::atomic<uint32_t> seq_{0};      // Palavra do futex: muda a cada notificação
+    std::atomic<uint32_t> waiters_{0};  // Entre prepareWait() e o fim de wait()
+    std::atomic<uint32_t> sleepers_{0}; // Dentro do futex (precisam de syscall para acordar)
+};
+
+} // namespace arcanos::xnu::mach
+
+#endif // ARCANOS_XNU_MACH_WAIT_QUEUE_H
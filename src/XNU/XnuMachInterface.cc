@@ -5,76 +5,296 @@
 
 #include "XnuMachInterface.h"
 #include <sstream>
+#include <vector>
+#include <algorithm>
 
 namespace arcanos::xnu::mach {
 
+XnuMachInterface::~XnuMachInterface() {
+    // Sem leitores concorrentes neste ponto: libera direto
+    port_to_task_map_.forEach([](mach_port_t, PortRecord* port) { releasePort(port); });
+    active_tasks_.forEach([](mach_task_t, TaskRecord* task) { delete task; });
+}
+
 mach_task_t XnuMachInterface::createTask(const std::string& process_name) {
-    mach_task_t new_task = next_task_id_++;
-    active_tasks_[new_task] = process_name;
+    TaskRecord* record = new TaskRecord;
+    record->name = process_name;
+    mach_task_t new_task = active_tasks_.insert(record);
+    if (new_task == 0) {
+        delete record;
+        std::cerr << "[XNU] Erro: Limite de tarefas atingido." << std::endl;
+        return 0;
+    }
     
-    std::cout << "[XNU] Task " << new_task << " ('" << process_name << "') criada." << std::endl;
+    if (logging_.load(std::memory_order_relaxed)) {
+        std::cout << "[XNU] Task " << new_task << " ('" << process_name << "') criada." << std::endl;
+    }
     return new_task;
 }
 
-mach_port_t XnuMachInterface::allocatePort(mach_task_t task_id) {
-    if (active_tasks_.find(task_id) == active_tasks_.end()) {
+void XnuMachInterface::releasePort(PortRecord* port) {
+    if (port->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete port;
+    }
+}
+
+void XnuMachInterface::destroyPort(PortRecord* port) {
+    port->queue.close();
+    EpochDomain::global().retire(port, [](void* p) { releasePort(static_cast<PortRecord*>(p)); });
+}
+
+mach_port_t XnuMachInterface::allocatePort(mach_task_t task_id, size_t queue_limit) {
+    EpochDomain::Guard guard;
+    TaskRecord* task = active_tasks_.find(task_id);
+    if (task == nullptr) {
         std::cerr << "[XNU] Erro: Tentativa de alocar porta para Task " << task_id << " inexistente." << std::endl;
         return 0;
     }
     
-    mach_port_t new_port = next_port_id_++;
-    port_to_task_map_[new_port] = task_id;
+    mach_port_t new_port;
+    {
+        // Com a trava da tarefa: ou a porta entra na lista antes de terminateTask
+        // esvaziá-la, ou a tarefa já aparece como encerrada.
+        std::lock_guard<std::mutex> lock(task->lock);
+        if (task->dead) {
+            std::cerr << "[XNU] Erro: Tentativa de alocar porta para Task " << task_id << " inexistente." << std::endl;
+            return 0;
+        }
+        PortRecord* record = new PortRecord(task_id, queue_limit);
+        new_port = port_to_task_map_.insert(record);
+        if (new_port == 0) {
+            delete record;
+            std::cerr << "[XNU] Erro: Limite de portas atingido." << std::endl;
+            return 0;
+        }
+        task->ports.push_back(new_port);
+    }
     
-    std::cout << "[XNU] Porta " << new_port << " alocada para Task " << task_id << "." << std::endl;
+    if (logging_.load(std::memory_order_relaxed)) {
+        std::cout << "[XNU] Porta " << new_port << " alocada para Task " << task_id << "." << std::endl;
+    }
     return new_port;
 }
 
 MachResult XnuMachInterface::sendMessage(mach_port_t destination_port, const std::string& message) {
-    if (port_to_task_map_.find(destination_port) == port_to_task_map_.end()) {
+    EpochDomain::Guard guard;
+    PortRecord* port = port_to_task_map_.find(destination_port);
+    if (port == nullptr) {
         std::cerr << "[XNU] Erro: Falha no envio. Porta " << destination_port << " não encontrada." << std::endl;
         return MachResult::PORT_NOT_FOUND;
     }
     
-    mach_task_t target_task = port_to_task_map_[destination_port];
-    std::string task_name = active_tasks_[target_task];
+    MachMessage msg;
+    msg.remote_port = destination_port;
+    msg.setBody(message.data(), message.size());
+    MachResult result = port->queue.send(std::move(msg), MachSendPolicy::FAIL, MACH_MSG_TIMEOUT_NONE);
+    if (result != MachResult::SUCCESS) {
+        std::cerr << "[XNU] Erro: Falha no envio. Fila da Porta " << destination_port << " cheia." << std::endl;
+        return result;
+    }
 
-    std::cout << "[XNU] Mensagem Mach ('" << message << "') enviada para a Porta " 
-              << destination_port << " (Task: " << task_name << ")." << std::endl;
+    mach_task_t target_task = port->owner;
+    const TaskRecord* task = active_tasks_.find(target_task);
 
-    // Em um kernel real, o scheduler seria notificado aqui.
+    if (logging_.load(std::memory_order_relaxed)) {
+        std::cout << "[XNU] Mensagem Mach ('" << message << "') enviada para a Porta " 
+                  << destination_port << " (Task: " << (task ? task->name.c_str() : "UNKNOWN_TASK") << ")." << std::endl;
+    }
+
+    // O receptor bloqueado na porta já foi acordado pela fila (MachWaitQueue).
     return MachResult::SUCCESS;
 }
 
+MachResult XnuMachInterface::sendMessage(mach_port_t destination_port, MachMessage&& msg,
+                                         MachSendPolicy policy, mach_msg_timeout_t timeout_ms) {
+    PortRecord* port;
+    {
+        EpochDomain::Guard guard;
+        port = port_to_task_map_.find(destination_port);
+        if (port == nullptr) {
+            return MachResult::PORT_NOT_FOUND;
+        }
+        if (policy != MachSendPolicy::BLOCK || timeout_ms == MACH_MSG_TIMEOUT_NONE) {
+            msg.remote_port = destination_port;
+            return port->queue.send(std::move(msg), policy, timeout_ms);
+        }
+        // Vai poder dormir: segura a porta por referência, não pelo Guard
+        port->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    msg.remote_port = destination_port;
+    MachResult result = port->queue.send(std::move(msg), policy, timeout_ms);
+    releasePort(port);
+    return result;
+}
+
+MachResult XnuMachInterface::receiveOn(mach_port_t port_id, MachMessage& out,
+                                       mach_msg_timeout_t timeout_ms, bool handoff) {
+    PortRecord* port;
+    {
+        EpochDomain::Guard guard;
+        port = port_to_task_map_.find(port_id);
+        if (port == nullptr) {
+            return MachResult::PORT_NOT_FOUND;
+        }
+        if (timeout_ms == MACH_MSG_TIMEOUT_NONE) {
+            return port->queue.receive(out, timeout_ms);
+        }
+        port->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    MachResult result = port->queue.receive(out, timeout_ms, handoff);
+    releasePort(port);
+    return result;
+}
+
+MachResult XnuMachInterface::receiveMessage(mach_port_t port_id, MachMessage& out,
+                                            mach_msg_timeout_t timeout_ms) {
+    return receiveOn(port_id, out, timeout_ms, false);
+}
+
+MachResult XnuMachInterface::sendReceive(mach_port_t destination_port, MachMessage&& request,
+                                         mach_port_t reply_port, MachMessage& reply,
+                                         mach_msg_timeout_t timeout_ms) {
+    request.local_port = reply_port;
+    MachResult result = sendMessage(destination_port, std::move(request), MachSendPolicy::BLOCK, timeout_ms);
+    if (result != MachResult::SUCCESS) {
+        return result;
+    }
+    return receiveOn(reply_port, reply, timeout_ms, true);
+}
+
+MachResult XnuMachInterface::replyAndReceive(MachMessage&& reply, mach_port_t receive_port,
+                                             MachMessage& next_request, mach_msg_timeout_t timeout_ms) {
+    mach_port_t reply_port = reply.remote_port;
+    // Pedido sem porta de resposta (mensagem de mão única): nada a responder
+    if (reply_port != MACH_PORT_NULL) {
+        MachResult sent = sendMessage(reply_port, std::move(reply), MachSendPolicy::FAIL, MACH_MSG_TIMEOUT_NONE);
+        if (sent != MachResult::SUCCESS) {
+            // O servidor decide: descartar (cliente já foi embora) e seguir com
+            // receiveMessage, ou tentar de novo. next_request fica intacto.
+            return sent;
+        }
+    }
+    return receiveOn(receive_port, next_request, timeout_ms, true);
+}
+
+size_t XnuMachInterface::sendMessages(MachMessage* msgs, size_t count, MachResult* results) {
+    // Cache das últimas portas resolvidas no lote (ids repetidos não voltam ao registro)
+    constexpr size_t kPortCache = 8;
+    mach_port_t cached_id[kPortCache] = {};
+    PortRecord* cached_port[kPortCache] = {};
+    size_t cache_next = 0;
+
+    EpochDomain::Guard guard;
+    size_t sent = 0;
+    size_t i = 0;
+    while (i < count) {
+        mach_port_t dest = msgs[i].remote_port;
+        size_t run = 1;
+        while (i + run < count && msgs[i + run].remote_port == dest) {
+            run++;
+        }
+
+        PortRecord* port = nullptr;
+        for (size_t c = 0; c < kPortCache; c++) {
+            if (cached_id[c] == dest && cached_port[c] != nullptr) {
+                port = cached_port[c];
+                break;
+            }
+        }
+        if (port == nullptr && dest != MACH_PORT_NULL) {
+            port = port_to_task_map_.find(dest);
+            cached_id[cache_next] = dest;
+            cached_port[cache_next] = port;
+            cache_next = (cache_next + 1) % kPortCache;
+        }
+
+        size_t n = port ? port->queue.sendBatch(msgs + i, run) : 0;
+        if (results != nullptr) {
+            for (size_t k = 0; k < run; k++) {
+                results[i + k] = k < n ? MachResult::SUCCESS
+                               : port ? MachResult::SEND_NO_BUFFER
+                                      : MachResult::PORT_NOT_FOUND;
+            }
+        }
+        sent += n;
+        i += run;
+    }
+    return sent;
+}
+
+size_t XnuMachInterface::receiveMessages(mach_port_t port_id, MachMessage* out, size_t max,
+                                         mach_msg_timeout_t timeout_ms, MachResult* result) {
+    MachResult local;
+    MachResult* res = result ? result : &local;
+
+    PortRecord* port;
+    {
+        EpochDomain::Guard guard;
+        port = port_to_task_map_.find(port_id);
+        if (port == nullptr) {
+            *res = MachResult::PORT_NOT_FOUND;
+            return 0;
+        }
+        if (timeout_ms == MACH_MSG_TIMEOUT_NONE) {
+            return port->queue.receiveBatch(out, max, timeout_ms, res);
+        }
+        port->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    size_t n = port->queue.receiveBatch(out, max, timeout_ms, res);
+    releasePort(port);
+    return n;
+}
+
 MachResult XnuMachInterface::terminateTask(mach_task_t task_id) {
-    if (active_tasks_.erase(task_id) == 0) {
+    TaskRecord* task = active_tasks_.remove(task_id);
+    if (task == nullptr) {
         std::cerr << "[XNU] Erro: Tentativa de encerrar Task " << task_id << " inexistente." << std::endl;
         return MachResult::INVALID_ARGUMENT;
     }
+    std::vector<mach_port_t> owned;
+    {
+        // Depois disso allocatePort recusa a tarefa: a lista não cresce mais
+        std::lock_guard<std::mutex> lock(task->lock);
+        task->dead = true;
+        owned.swap(task->ports);
+    }
     
-    // Remove todas as portas associadas a esta tarefa
-    for (auto it = port_to_task_map_.begin(); it != port_to_task_map_.end(); ) {
-        if (it->second == task_id) {
-            std::cout << "[XNU] Porta " << it->first << " liberada." << std::endl;
-            it = port_to_task_map_.erase(it);
-        } else {
-            ++it;
+    // Remove apenas as portas associadas a esta tarefa
+    for (mach_port_t port : owned) {
+        if (PortRecord* record = port_to_task_map_.remove(port)) {
+            destroyPort(record);
         }
     }
+    EpochDomain::global().retire(task);
     
-    std::cout << "[XNU] Task " << task_id << " encerrada com sucesso." << std::endl;
+    if (logging_.load(std::memory_order_relaxed)) {
+        std::cout << "[XNU] Task " << task_id << " encerrada com sucesso (" << owned.size()
+                  << " portas liberadas)." << std::endl;
+    }
     return MachResult::SUCCESS;
 }
 
 void XnuMachInterface::printPortRegistry() const {
+    EpochDomain::Guard guard;
+    std::vector<std::pair<mach_port_t, mach_task_t>> ports;
+    port_to_task_map_.forEach([&](mach_port_t port, const PortRecord* record) {
+        ports.emplace_back(port, record->owner);
+    });
+    std::sort(ports.begin(), ports.end());
+
     std::cout << "\n--- XNU Mach Port Registry ---" << std::endl;
-    if (port_to_task_map_.empty()) {
+    if (ports.empty()) {
         std::cout << "Nenhuma porta ativa." << std::endl;
         return;
     }
-    for (const auto& pair : port_to_task_map_) {
+    for (const auto& pair : ports) {
         mach_port_t port = pair.first;
         mach_task_t task = pair.second;
-        std::string task_name = active_tasks_.count(task) ? active_tasks_.at(task) : "UNKNOWN_TASK";
+        const TaskRecord* record = active_tasks_.find(task);
+        std::string task_name = record ? record->name : "UNKNOWN_TASK";
         std::cout << "Porta ID: " << port << " -> Task ID: " << task << " (" << task_name << ")" << std::endl;
     }
     std::cout << "------------------------------" << std::endl;
@@ -2,37 +2,77 @@
 #define ARCANOS_XNU_MACH_INTERFACE_H
 
 #include <string>
-#include <map>
+#include <vector>
+#include <atomic>
+#include <mutex>
 #include <iostream>
+#include "MachTypes.h"
+#include "MachMessage.h"
+#include "MachMessageQueue.h"
+#include "MachSlotMap.h"
 
 namespace arcanos::xnu::mach {
 
-// Tipos de dados fundamentais do Mach Kernel (simulados)
-using mach_port_t = unsigned int;
-using mach_task_t = unsigned int;
-
-// Códigos de Retorno XNU/Mach (simulados)
-enum class MachResult {
-    SUCCESS,
-    INVALID_ARGUMENT,
-    PORT_NOT_FOUND,
-    NO_MEMORY
-};
-
 /**
  * @brief Gerencia tarefas (processos) e portas de comunicação no subsistema Mach.
  * Simula a interface XNU para IPC e controle de tarefas.
+ * Seguro para uso concorrente: buscas de portas/tarefas não travam.
  */
 class XnuMachInterface {
 public:
+    XnuMachInterface() = default;
+    ~XnuMachInterface();
+    XnuMachInterface(const XnuMachInterface&) = delete;
+    XnuMachInterface& operator=(const XnuMachInterface&) = delete;
+
     // Cria uma nova "tarefa" (processo)
     mach_task_t createTask(const std::string& process_name);
     
-    // Aloca uma nova porta de comunicação para uma tarefa
-    mach_port_t allocatePort(mach_task_t task_id);
+    // Aloca uma nova porta de comunicação para uma tarefa.
+    // 'queue_limit' é o número máximo de mensagens pendentes na porta.
+    mach_port_t allocatePort(mach_task_t task_id, size_t queue_limit = MachMessageQueue::kDefaultLimit);
     
     // Envia uma mensagem para uma porta Mach (Comunicação Interprocessos)
     MachResult sendMessage(mach_port_t destination_port, const std::string& message);
+
+    // Envia 'msg' (movida) para a fila da porta. Com a fila cheia aplica 'policy';
+    // BLOCK espera até timeout_ms.
+    MachResult sendMessage(mach_port_t destination_port, MachMessage&& msg,
+                           MachSendPolicy policy = MachSendPolicy::FAIL,
+                           mach_msg_timeout_t timeout_ms = MACH_MSG_TIMEOUT_NONE);
+
+    // Recebe a próxima mensagem da porta: bloqueia (MACH_MSG_TIMEOUT_INFINITE),
+    // faz poll (MACH_MSG_TIMEOUT_NONE) ou espera até timeout_ms.
+    MachResult receiveMessage(mach_port_t port, MachMessage& out,
+                              mach_msg_timeout_t timeout_ms = MACH_MSG_TIMEOUT_INFINITE);
+
+
+    // RPC (cliente): envia 'request' com local_port = reply_port e espera a resposta
+    // em reply_port. Depois de acordar o servidor, cede a CPU a ele (hand-off).
+    MachResult sendReceive(mach_port_t destination_port, MachMessage&& request,
+                           mach_port_t reply_port, MachMessage& reply,
+                           mach_msg_timeout_t timeout_ms = MACH_MSG_TIMEOUT_INFINITE);
+
+    // RPC (servidor): responde para reply.remote_port e já espera o próximo
+    // pedido em receive_port, com o mesmo hand-off de sendReceive. Se o envio
+    // da resposta falhar (PORT_NOT_FOUND, SEND_NO_BUFFER), retorna esse erro
+    // sem receber; com reply.remote_port == MACH_PORT_NULL só recebe.
+    MachResult replyAndReceive(MachMessage&& reply, mach_port_t receive_port, MachMessage& next_request,
+                               mach_msg_timeout_t timeout_ms = MACH_MSG_TIMEOUT_INFINITE);
+
+    // Envio vetorial (estilo mach_msg_vector): cada msgs[i].remote_port é o destino.
+    // Mensagens consecutivas para a mesma porta entram na fila com uma única
+    // reserva; a resolução das portas é feita uma vez por porta no lote. Não
+    // bloqueia (política FAIL), não aloca e não gera log por mensagem.
+    // 'results' (opcional) recebe o resultado de cada mensagem. Retorna quantas foram enviadas.
+    size_t sendMessages(MachMessage* msgs, size_t count, MachResult* results = nullptr);
+
+    // Recebe até 'max' mensagens da porta de uma vez. Espera pela primeira conforme
+    // timeout_ms (como receiveMessage). Retorna quantas foram recebidas; 'result'
+    // (opcional) explica um retorno 0.
+    size_t receiveMessages(mach_port_t port, MachMessage* out, size_t max,
+                           mach_msg_timeout_t timeout_ms = MACH_MSG_TIMEOUT_INFINITE,
+                           MachResult* result = nullptr);
     
     // Encerra uma tarefa específica
     MachResult terminateTask(mach_task_t task_id);
@@ -40,14 +80,47 @@ public:
     // Mapeamento de portas para tarefas (simulação de registro)
     void printPortRegistry() const;
 
+    // Liga/desliga o log informativo (criação, alocação, envio, encerramento).
+    // Erros continuam indo para std::cerr.
+    void setLoggingEnabled(bool enabled) { logging_.store(enabled, std::memory_order_relaxed); }
+
 private:
-    std::map<mach_task_t, std::string> active_tasks_;
-    std::map<mach_port_t, mach_task_t> port_to_task_map_;
-    mach_task_t next_task_id_ = 100;
-    mach_port_t next_port_id_ = 200;
+    struct TaskRecord {
+        std::string name;
+        std::mutex lock;                 // Protege 'dead' e 'ports'
+        bool dead = false;
+        std::vector<mach_port_t> ports;  // Portas da tarefa: encerrar custa O(portas próprias)
+    };
+
+    struct PortRecord {
+        PortRecord(mach_task_t task, size_t queue_limit) : owner(task), queue(queue_limit) {}
+        mach_task_t owner;
+        MachMessageQueue queue;
+        // Uma referência do registro + uma por operação bloqueada fora do Guard
+        std::atomic<uint32_t> refs{1};
+    };
+
+    // Solta uma referência; a última libera a porta
+    static void releasePort(PortRecord* port);
+    // Acorda quem espera na porta (já fora do registro) e a aposenta
+    static void destroyPort(PortRecord* port);
+    // Recebe em port_id (segurando a porta por referência se for esperar)
+    MachResult receiveOn(mach_port_t port_id, MachMessage& out, mach_msg_timeout_t timeout_ms, bool handoff);
+
+    // Handles de tarefa/porta são (geração, índice) nestes mapas: reaproveitáveis,
+    // e um handle de objeto já destruído nunca resolve para outro objeto.
+    MachSlotMap<TaskRecord> active_tasks_;
+    MachSlotMap<PortRecord> port_to_task_map_;
+    std::atomic<bool> logging_{true};
 
 };
 
+// Autoteste e benchmark de ida e volta do RPC e autoteste de terminateTask
+// (XnuMachInterface_test.cc)
+int mach_rpc_run_selftest();
+void mach_rpc_run_benchmark();
+int mach_task_run_selftest();
+
 } // namespace arcanos::xnu::mach
 
 #endif // ARCANOS_XNU_MACH_INTERFACE_H
@@ -0,0 +1,138 @@
+//
+// Dispositivos de bloco usados pelo caminho de flash do Fastboot.
+// Arquivo: src/android/fastboot/block_device.cc
+//
+
+#include "block_device.h"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <linux/falloc.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+
+namespace arcanos::fastboot {
+
+bool BlockDevice::writeZeroes(uint64_t offset, uint64_t len) {
+    static const uint8_t zeros[64 * 1024] = {};
+    while (len > 0) {
+        size_t n = static_cast<size_t>(std::min<uint64_t>(len, sizeof(zeros)));
+        if (!write(offset, zeros, n)) {
+            return false;
+        }
+        offset += n;
+        len -= n;
+    }
+    return true;
+}
+
+std::string BlockDevice::deviceId() const {
+    // Sem informação de hardware: cada instância é um dispositivo à parte
+    char id[32];
+    std::snprintf(id, sizeof(id), "mem:%p", static_cast<const void*>(this));
+    return id;
+}
+
+// Disco inteiro que contém 'dev' (sda para sda3, nvme0n1 para nvme0n1p2), via sysfs
+static std::string wholeDiskId(dev_t dev) {
+    char link[64];
+    std::snprintf(link, sizeof(link), "/sys/dev/block/%u:%u", major(dev), minor(dev));
+    char resolved[PATH_MAX];
+    if (realpath(link, resolved) == nullptr) {
+        // tmpfs, overlay e afins não têm nó em sysfs
+        char id[32];
+        std::snprintf(id, sizeof(id), "dev:%u:%u", major(dev), minor(dev));
+        return id;
+    }
+    std::string path(resolved);
+    if (access((path + "/partition").c_str(), F_OK) == 0) {
+        path.erase(path.rfind('/'));
+    }
+    return path.substr(path.rfind('/') + 1);
+}
+
+FileBlockDevice::FileBlockDevice(const std::string& path)
+    : fd_(-1), is_block_(false) {
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    struct stat st;
+    if (fd_ >= 0 && fstat(fd_, &st) == 0) {
+        is_block_ = S_ISBLK(st.st_mode);
+        // Nó de bloco: o próprio disco; arquivo de imagem: o disco do sistema de arquivos
+        device_id_ = wholeDiskId(is_block_ ? st.st_rdev : st.st_dev);
+    }
+}
+
+FileBlockDevice::~FileBlockDevice() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+bool FileBlockDevice::write(uint64_t offset, const void* data, size_t len) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    while (len > 0) {
+        ssize_t n = ::pwrite(fd_, p, len, static_cast<off_t>(offset));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        p += n;
+        offset += static_cast<uint64_t>(n);
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool FileBlockDevice::flush() {
+    return ::fdatasync(fd_) == 0;
+}
+
+bool FileBlockDevice::writeZeroes(uint64_t offset, uint64_t len) {
+    if (len == 0) {
+        return true;
+    }
+    if (is_block_) {
+        // O kernel exige faixas alinhadas ao setor; o resto cai na escrita comum
+        if ((offset | len) % 512 == 0) {
+            uint64_t range[2] = { offset, len };
+            if (ioctl(fd_, BLKZEROOUT, range) == 0) {
+                return true;
+            }
+        }
+        return BlockDevice::writeZeroes(offset, len);
+    }
+
+    // Arquivo: zera sem alocar blocos (ZERO_RANGE também estende o tamanho)
+    if (fallocate(fd_, FALLOC_FL_ZERO_RANGE, static_cast<off_t>(offset), static_cast<off_t>(len)) == 0) {
+        return true;
+    }
+    struct stat st;
+    if (fstat(fd_, &st) == 0 &&
+        fallocate(fd_, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                  static_cast<off_t>(offset), static_cast<off_t>(len)) == 0) {
+        uint64_t end = offset + len;
+        if (end <= static_cast<uint64_t>(st.st_size) || ftruncate(fd_, static_cast<off_t>(end)) == 0) {
+            return true;
+        }
+    }
+    return BlockDevice::writeZeroes(offset, len);
+}
+
+uint64_t FileBlockDevice::size() const {
+    if (is_block_) {
+        uint64_t bytes = 0;
+        return ioctl(fd_, BLKGETSIZE64, &bytes) == 0 ? bytes : 0;
+    }
+    // Arquivo de imagem: cresce conforme a escrita
+    return UINT64_MAX;
+}
+
+} // namespace arcanos::fastboot
@@ -0,0 +1,54 @@
+#ifndef ARCANOS_FASTBOOT_BLOCK_DEVICE_H
+#define ARCANOS_FASTBOOT_BLOCK_DEVICE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace arcanos::fastboot {
+
+/**
+ * @brief Destino de escrita de uma partição (dispositivo de bloco ou arquivo).
+ */
+class BlockDevice {
+public:
+    virtual ~BlockDevice() = default;
+
+    virtual bool write(uint64_t offset, const void* data, size_t len) = 0;
+    virtual bool flush() = 0;
+    virtual uint64_t size() const = 0;
+
+    // Zera a faixa. A implementação padrão grava zeros; dispositivos reais
+    // usam a operação nativa (BLKZEROOUT, buraco no arquivo) sem transferir dados.
+    virtual bool writeZeroes(uint64_t offset, uint64_t len);
+
+    // Identifica o armazenamento físico: partições com o mesmo id disputam a
+    // mesma fila de I/O e são gravadas em sequência pelo flashall
+    virtual std::string deviceId() const;
+};
+
+// Partição acessada por caminho: nó de bloco (/dev/...) ou arquivo de imagem
+class FileBlockDevice : public BlockDevice {
+public:
+    explicit FileBlockDevice(const std::string& path);
+    ~FileBlockDevice() override;
+    FileBlockDevice(const FileBlockDevice&) = delete;
+    FileBlockDevice& operator=(const FileBlockDevice&) = delete;
+
+    bool isOpen() const { return fd_ >= 0; }
+
+    bool write(uint64_t offset, const void* data, size_t len) override;
+    bool flush() override;
+    uint64_t size() const override;
+    bool writeZeroes(uint64_t offset, uint64_t len) override;
+    std::string deviceId() const override { return device_id_; }
+
+private:
+    int fd_;
+    bool is_block_;
+    std::string device_id_;
+};
+
+} // namespace arcanos::fastboot
+
+#endif // ARCANOS_FASTBOOT_BLOCK_DEVICE_H
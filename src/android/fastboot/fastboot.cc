@@ -4,10 +4,55 @@
 //
 
 #include "fastboot.h"
+#include "sparse_image.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <fstream>
 #include <iostream> // Para simular logging em C++
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace arcanos::fastboot {
 
+namespace {
+
+// Repassa as escritas para a partição e registra até onde ela foi alterada,
+// para que um flash rejeitado possa apagar o que já foi gravado
+class ExtentTrackingDevice : public BlockDevice {
+public:
+    explicit ExtentTrackingDevice(BlockDevice& device) : device_(device) {}
+
+    bool write(uint64_t offset, const void* data, size_t len) override {
+        touch(offset, len);
+        return device_.write(offset, data, len);
+    }
+    bool writeZeroes(uint64_t offset, uint64_t len) override {
+        touch(offset, len);
+        return device_.writeZeroes(offset, len);
+    }
+    bool flush() override { return device_.flush(); }
+    uint64_t size() const override { return device_.size(); }
+    std::string deviceId() const override { return device_.deviceId(); }
+
+    // Fim da maior faixa gravada (0 = nada foi escrito)
+    uint64_t writtenEnd() const { return end_; }
+
+private:
+    void touch(uint64_t offset, uint64_t len) {
+        if (len > 0 && offset + len > end_) {
+            end_ = offset + len;
+        }
+    }
+
+    BlockDevice& device_;
+    uint64_t end_ = 0; // Escritas vêm só da thread de escrita do pipeline
+};
+
+} // namespace
+
 FastbootService::FastbootService() : usb_ready_(false) {
     std::cout << "FastbootService: Serviço inicializado." << std::endl;
 }
@@ -32,36 +77,300 @@ FastbootStatus FastbootService::initializeUsbConnection() {
         return FastbootStatus::USB_FAIL;
     }
     
+    if (!transport_) {
+        transport_.reset(new SimulatedUsbTransport());
+    }
     usb_ready_ = true;
     std::cout << "FastbootService: Conexão USB estabelecida." << std::endl;
     return FastbootStatus::OK;
 }
 
+void FastbootService::setTransport(std::unique_ptr<FastbootTransport> transport) {
+    transport_ = std::move(transport);
+    usb_ready_ = transport_ != nullptr;
+}
+
+void FastbootService::registerPartition(const std::string& name, std::shared_ptr<BlockDevice> device) {
+    partitions_[name] = std::move(device);
+}
+
 FastbootStatus FastbootService::sendUsbData(const std::string& data) {
     if (!usb_ready_) return FastbootStatus::USB_FAIL;
-    std::cout << "FastbootService: Enviando: " << data << std::endl;
-    return FastbootStatus::OK;
+    return transport_->writeString(data) ? FastbootStatus::OK : FastbootStatus::USB_FAIL;
 }
 
 FastbootStatus FastbootService::receiveUsbData(std::string& data_out) {
     if (!usb_ready_) return FastbootStatus::USB_FAIL;
-    // Simula uma resposta de status de Fastboot
-    data_out = "INFO: OKAY [1.0s] - Comando concluído.";
+    // Pacotes de resposta do Fastboot têm no máximo 64 bytes
+    char buf[64];
+    ssize_t n = transport_->read(buf, sizeof(buf));
+    if (n < 0) return FastbootStatus::USB_FAIL;
+    data_out.assign(buf, static_cast<size_t>(n));
     std::cout << "FastbootService: Recebendo: " << data_out << std::endl;
     return FastbootStatus::OK;
 }
 
+FastbootStatus FastbootService::flashStream(const std::string& partition, uint64_t size,
+                                            const std::string& expected_sha256, std::string& response_out) {
+    if (!isUsbConnected()) {
+        response_out = "ERROR: USB não conectado.";
+        return FastbootStatus::USB_FAIL;
+    }
+    auto it = partitions_.find(partition);
+    if (it == partitions_.end()) {
+        response_out = "FAIL: Partição desconhecida: " + partition;
+        sendUsbData(response_out);
+        return FastbootStatus::INVALID_ARGUMENT;
+    }
+    if (size > kMaxDownloadSize) {
+        response_out = "FAIL: Imagem acima de 4 GiB; divida em partes esparsas (max-download-size).";
+        sendUsbData(response_out);
+        return FastbootStatus::INVALID_ARGUMENT;
+    }
+    if (size > it->second->size()) {
+        response_out = "FAIL: Imagem maior que a partição.";
+        sendUsbData(response_out);
+        return FastbootStatus::INVALID_ARGUMENT;
+    }
+
+    // Libera o host para enviar os dados
+    char data_reply[32];
+    std::snprintf(data_reply, sizeof(data_reply), "DATA%08llx", static_cast<unsigned long long>(size));
+    if (sendUsbData(data_reply) != FastbootStatus::OK) {
+        response_out = "ERROR: Falha no envio USB.";
+        return FastbootStatus::USB_FAIL;
+    }
+
+    std::string error;
+    if (!writeImage(partition, *it->second, *transport_, size, expected_sha256, error)) {
+        response_out = "FAIL: " + error;
+        sendUsbData(response_out);
+        return FastbootStatus::COMMAND_FAIL;
+    }
+
+    response_out = "OKAY";
+    sendUsbData(response_out);
+    return FastbootStatus::OK;
+}
+
+bool FastbootService::writeImage(const std::string& partition, BlockDevice& device, FastbootTransport& source,
+                                 uint64_t size, const std::string& expected_sha256, std::string& error) {
+    FlashPipeline pipeline(pipeline_config_);
+    // Download comprimido é expandido no pipeline; imagens esparsas são
+    // aplicadas chunk a chunk; as demais, gravadas cruas
+    ExtentTrackingDevice tracked(device);
+    AutoImageWriter writer(tracked, pipeline_config_.decompress_threads);
+    bool ok = pipeline.run(source, size, writer, error);
+    {
+        std::lock_guard<std::mutex> lock(stats_lock_);
+        last_flash_stats_ = pipeline.stats();
+    }
+    std::cout << "FastbootService: flash " << partition << ": " << pipeline.stats().format() << std::endl;
+
+    // O digest só é conhecido depois do último bloco, quando os dados já estão
+    // na partição: imagem incompleta ou com digest errado é apagada, para que
+    // nada não verificado fique gravado
+    if (ok && !expected_sha256.empty() && expected_sha256 != pipeline.digestHex()) {
+        error = "A verificação de assinatura falhou.";
+        ok = false;
+    }
+    if (!ok) {
+        if (tracked.writtenEnd() > 0 &&
+            !(device.writeZeroes(0, tracked.writtenEnd()) && device.flush())) {
+            error += " Não foi possível apagar a partição " + partition + ".";
+        }
+        return false;
+    }
+
+    std::cout << "FastbootService: " << partition << " gravada (" << size << " bytes, sha256 "
+              << pipeline.digestHex() << ")." << std::endl;
+    return true;
+}
+
+FastbootStatus FastbootService::flashAll(const std::vector<FlashManifestEntry>& entries,
+                                         std::vector<FlashAllResult>& results) {
+    for (const FlashManifestEntry& entry : entries) {
+        if (partitions_.find(entry.partition) == partitions_.end()) {
+            results.clear();
+            return FastbootStatus::INVALID_ARGUMENT; // Nada é gravado se o manifesto está errado
+        }
+    }
+
+    auto device_of = [this](const FlashManifestEntry& entry) {
+        return partitions_.at(entry.partition)->deviceId();
+    };
+    auto flash_one = [this](const FlashManifestEntry& entry, std::string& error) {
+        int fd = ::open(entry.image_path.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+            error = "não foi possível abrir " + entry.image_path;
+            return false;
+        }
+        // A imagem local entra no mesmo pipeline usado pelo USB
+        FdTransport source(fd);
+        return writeImage(entry.partition, *partitions_.at(entry.partition), source,
+                          static_cast<uint64_t>(st.st_size), entry.expected_sha256, error);
+    };
+
+    results = FlashScheduler::run(entries, device_of, flash_one);
+    for (const FlashAllResult& r : results) {
+        if (!r.ok) {
+            return FastbootStatus::COMMAND_FAIL;
+        }
+    }
+    return FastbootStatus::OK;
+}
+
+LatencyHistogram& FastbootService::latencyFor(const std::string& command) {
+    // O nome vem do host: só comandos conhecidos ganham histograma próprio,
+    // senão cada string diferente faria o map crescer sem limite
+    static const char* const kKnownCommands[] = {
+        "getvar", "download", "flash", "flashall", "erase", "boot", "continue",
+        "reboot", "reboot-bootloader", "set_active", "oem",
+    };
+    const char* key = kOtherCommands;
+    for (const char* known : kKnownCommands) {
+        if (command == known) {
+            key = known;
+            break;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(stats_lock_);
+    std::unique_ptr<LatencyHistogram>& h = latency_[key];
+    if (!h) {
+        h.reset(new LatencyHistogram());
+    }
+    return *h;
+}
+
+bool FastbootService::getVar(const std::string& name, std::string& value_out) {
+    std::lock_guard<std::mutex> lock(stats_lock_);
+    if (name == "flash-stats") {
+        value_out = last_flash_stats_.format();
+        return true;
+    }
+    if (name == "download-compression") {
+        value_out = "lz4"; // Frames LZ4 com blocos independentes
+        return true;
+    }
+    if (name == "max-download-size") {
+        char hex[24];
+        std::snprintf(hex, sizeof(hex), "0x%llx", static_cast<unsigned long long>(kMaxDownloadSize));
+        value_out = hex;
+        return true;
+    }
+    if (name == "latency") {
+        value_out.clear();
+        for (const auto& entry : latency_) {
+            if (!value_out.empty()) {
+                value_out += "; ";
+            }
+            value_out += entry.first + ": " + entry.second->summary();
+        }
+        return true;
+    }
+    if (name.compare(0, 8, "latency:") == 0) {
+        auto it = latency_.find(name.substr(8));
+        if (it == latency_.end()) {
+            return false;
+        }
+        value_out = it->second->summary();
+        return true;
+    }
+    return false;
+}
 
 FastbootStatus FastbootService::executeCommand(
     const std::string& command,
     const std::string& argument,
     std::string& response_out
+) {
+    // Histogramas ficam estáveis (o map só cresce), então a referência vale após o comando
+    LatencyHistogram& histogram = latencyFor(command);
+    auto start = std::chrono::steady_clock::now();
+    FastbootStatus status = dispatchCommand(command, argument, response_out);
+    histogram.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count()));
+    return status;
+}
+
+FastbootStatus FastbootService::dispatchCommand(
+    const std::string& command,
+    const std::string& argument,
+    std::string& response_out
 ) {
     if (!isUsbConnected()) {
         response_out = "ERROR: USB não conectado.";
         return FastbootStatus::USB_FAIL;
     }
 
+    if (command == "getvar") {
+        std::string value;
+        if (!getVar(argument, value)) {
+            response_out = "FAIL: Variável desconhecida: " + argument;
+            sendUsbData(response_out);
+            return FastbootStatus::INVALID_ARGUMENT;
+        }
+        response_out = "OKAY" + value;
+        sendUsbData(response_out);
+        return FastbootStatus::OK;
+    }
+
+    if (command == "flashall") {
+        std::ifstream file(argument);
+        std::stringstream text;
+        text << file.rdbuf();
+        std::vector<FlashManifestEntry> entries;
+        std::string error;
+        if (!file || !parseFlashManifest(text.str(), entries, error)) {
+            response_out = "FAIL: Manifesto inválido: " + (error.empty() ? argument : error);
+            sendUsbData(response_out);
+            return FastbootStatus::INVALID_ARGUMENT;
+        }
+
+        std::vector<FlashAllResult> results;
+        FastbootStatus status = flashAll(entries, results);
+        if (status == FastbootStatus::INVALID_ARGUMENT) {
+            response_out = "FAIL: Manifesto cita partição desconhecida.";
+        } else if (status != FastbootStatus::OK) {
+            response_out = "FAIL:";
+            for (const FlashAllResult& r : results) {
+                if (!r.ok) {
+                    response_out += " " + r.partition + " (" + r.error + ")";
+                }
+            }
+        } else {
+            response_out = "OKAY";
+        }
+        sendUsbData(response_out);
+        return status;
+    }
+
+    if (command == "flash") {
+        // Streaming: "<partição>:<tamanho hex>[:<sha256>]"
+        size_t colon = argument.find(':');
+        if (colon != std::string::npos) {
+            std::string partition = argument.substr(0, colon);
+            std::string rest = argument.substr(colon + 1);
+            size_t colon2 = rest.find(':');
+            std::string size_hex = rest.substr(0, colon2);
+            std::string digest = colon2 == std::string::npos ? "" : rest.substr(colon2 + 1);
+
+            char* end = nullptr;
+            unsigned long long size = std::strtoull(size_hex.c_str(), &end, 16);
+            if (size_hex.empty() || *end != '\0') {
+                response_out = "FAIL: Tamanho inválido.";
+                sendUsbData(response_out);
+                return FastbootStatus::INVALID_ARGUMENT;
+            }
+            return flashStream(partition, size, digest, response_out);
+        }
+    }
+
     std::string full_command = command + " " + argument;
 
     // 1. Enviar o comando
@@ -1,8 +1,16 @@
 #ifndef ARCANOS_FASTBOOT_FASTBOOT_H
 #define ARCANOS_FASTBOOT_FASTBOOT_H
 
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
+#include "block_device.h"
+#include "flash_pipeline.h"
+#include "flash_scheduler.h"
+#include "latency_histogram.h"
+#include "transport.h"
 
 namespace arcanos::fastboot {
 
@@ -29,6 +37,15 @@ public:
     bool isUsbConnected() const;
     FastbootStatus initializeUsbConnection();
 
+    // Substitui o USB por outro transporte (socket local ou loopback nos testes)
+    void setTransport(std::unique_ptr<FastbootTransport> transport);
+
+    // Associa um nome de partição ao dispositivo onde ela é gravada
+    void registerPartition(const std::string& name, std::shared_ptr<BlockDevice> device);
+
+    // Tamanho dos blocos e número de buffers do pipeline de flash
+    void setPipelineConfig(const FlashPipelineConfig& config) { pipeline_config_ = config; }
+
     /**
      * @brief Envia um comando Fastboot para o dispositivo (simulado,
      * pois o comando é geralmente enviado DE FORA do dispositivo).
@@ -36,8 +53,24 @@ public:
      * No contexto do Arcanos, isso simula a execução de uma operação
      * interna do Fastboot.
      *
+     * "flash" com argumento "<partição>:<tamanho hex>[:<sha256>]" recebe a imagem
+     * em streaming pelo transporte (resposta DATA, dados, OKAY/FAIL) e a grava
+     * sem armazená-la inteira na memória. Imagens esparsas do Android são
+     * reconhecidas pelo magic e expandidas direto na partição. O host pode
+     * enviar a imagem dentro de frames LZ4 (download comprimido, anunciado em
+     * "getvar download-compression"); o tamanho e o sha256 se referem então
+     * aos bytes comprimidos transferidos. Se a gravação falhar ou o sha256 não
+     * conferir, a faixa já gravada da partição é zerada antes do FAIL.
+     * Tamanhos acima de kMaxDownloadSize não cabem nos 8 dígitos da resposta
+     * DATA e recebem FAIL antes da fase de dados; o host deve dividir a imagem
+     * em imagens esparsas (splitSparseImage) com "getvar max-download-size".
+     *
+     * "flashall" com o caminho de um manifesto grava as imagens listadas (veja flashAll()).
+     *
+     * "getvar" responde "OKAY<valor>" para as variáveis de getVar().
+     *
      * @param command O comando Fastboot a ser executado (ex: "flash", "reboot").
-     * @param argument O argumento associado (ex: "bootloader", "boot").
+     * @param argument O argumento associado (ex: "bootloader", "boot", "system:40000000").
      * @param response_out Saída da resposta do Fastboot (Status e Mensagem).
      * @return O status da operação.
      */
@@ -54,15 +87,70 @@ public:
      */
     FastbootStatus enterFastbootMode();
 
+    // Maior download por "flash": a resposta DATA tem 8 dígitos hex de tamanho
+    static constexpr uint64_t kMaxDownloadSize = 0xFFFFFFFFull;
+
+    /**
+     * @brief Recebe 'size' bytes pelo transporte e grava na partição, em pipeline.
+     * @param expected_sha256 Digest esperado em hex (vazio = não conferir).
+     * Digest diferente apaga (zera) o que foi gravado e retorna COMMAND_FAIL;
+     * 'size' acima de kMaxDownloadSize retorna INVALID_ARGUMENT sem fase de dados.
+     */
+    FastbootStatus flashStream(const std::string& partition, uint64_t size,
+                               const std::string& expected_sha256, std::string& response_out);
+
+    /**
+     * @brief Grava várias partições a partir de imagens locais, em paralelo por dispositivo.
+     *
+     * Partições no mesmo armazenamento (BlockDevice::deviceId) são gravadas em
+     * sequência; armazenamentos diferentes, ao mesmo tempo. Se o manifesto cita
+     * uma partição desconhecida, nada é gravado.
+     * @param results Resultado de cada entrada, na ordem do manifesto.
+     */
+    FastbootStatus flashAll(const std::vector<FlashManifestEntry>& entries,
+                            std::vector<FlashAllResult>& results);
+
+    /**
+     * @brief Consulta uma variável de diagnóstico.
+     *
+     * "flash-stats": bytes, vazão e esperas por estágio do último flash.
+     * "download-compression": formatos de download comprimido aceitos.
+     * "max-download-size": maior imagem aceita por "flash", em hex (0x...).
+     * "latency": histograma de latência de todos os comandos.
+     * "latency:<comando>": histograma de um comando; comandos desconhecidos
+     * são somados em "latency:other".
+     * @return false se a variável não existe.
+     */
+    bool getVar(const std::string& name, std::string& value_out);
+
 private:
     // Estado interno (simulação)
     bool usb_ready_;
+    std::unique_ptr<FastbootTransport> transport_;
+    std::map<std::string, std::shared_ptr<BlockDevice>> partitions_;
+    FlashPipelineConfig pipeline_config_;
+
+    // Instrumentação (consultada via getvar)
+    std::mutex stats_lock_;
+    FlashPipelineStats last_flash_stats_;
+    std::map<std::string, std::unique_ptr<LatencyHistogram>> latency_;
+    static constexpr const char* kOtherCommands = "other"; // Balde dos comandos desconhecidos
+
+    FastbootStatus dispatchCommand(const std::string& command, const std::string& argument,
+                                   std::string& response_out);
+    LatencyHistogram& latencyFor(const std::string& command);
+    bool writeImage(const std::string& partition, BlockDevice& device, FastbootTransport& source,
+                    uint64_t size, const std::string& expected_sha256, std::string& error);
 
     // Funções de baixo nível (simulação)
     FastbootStatus sendUsbData(const std::string& data);
     FastbootStatus receiveUsbData(std::string& data_out);
 };
 
+// Autoteste e benchmark do flash por loopback (fastboot_test.cc)
+int fastboot_run_selftest();
+void fastboot_run_benchmark(uint64_t bytes = 1ull << 30);
+
 } // namespace arcanos::fastboot
 
 #endif // ARCANOS_FASTBOOT_FASTBOOT_H
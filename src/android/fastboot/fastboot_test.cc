@@ -0,0 +1,233 @@
+//
+// Autoteste e benchmark do serviço Fastboot: flash em streaming por um transporte loopback.
+// Arquivo: src/android/fastboot/fastboot_test.cc
+//
+
+#include "fastboot.h"
+#include "sha256.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+
+namespace arcanos::fastboot {
+
+namespace {
+
+constexpr size_t kTestPartition = 4 * 1024 * 1024;
+constexpr uint8_t kUnwritten = 0xAA; // Conteúdo da partição antes do flash
+
+// Partição em memória
+class MemoryBlockDevice : public BlockDevice {
+public:
+    explicit MemoryBlockDevice(size_t size) : data(size, kUnwritten) {}
+
+    bool write(uint64_t offset, const void* src, size_t len) override {
+        if (offset + len > data.size()) {
+            return false;
+        }
+        std::memcpy(data.data() + offset, src, len);
+        return true;
+    }
+    bool flush() override { return true; }
+    uint64_t size() const override { return data.size(); }
+
+    std::vector<uint8_t> data;
+};
+
+// Lado do host: envia "flash <argumento>" e, se o dispositivo pedir (DATA),
+// transmite 'payload'. Retorna a resposta final (OKAY/FAIL...).
+std::string hostFlash(FastbootService& service, LoopbackTransport& host, const std::string& argument,
+                      const std::vector<uint8_t>& payload, FastbootStatus& status) {
+    std::string response;
+    std::thread device([&] { status = service.executeCommand("flash", argument, response); });
+    char reply[256];
+    ssize_t n = host.read(reply, 4);
+    if (n == 4 && std::memcmp(reply, "DATA", 4) == 0 && host.readFully(reply, 8)) {
+        host.writeAll(payload.data(), payload.size());
+        n = 0;
+    }
+    device.join();
+    // A resposta final já está inteira no transporte
+    ssize_t m = host.read(reply + n, sizeof(reply) - static_cast<size_t>(n));
+    return std::string(reply, static_cast<size_t>(n + (m > 0 ? m : 0)));
+}
+
+// Lado do host para comandos repassados ao USB simulado: lê o comando e responde OKAY
+FastbootStatus hostCommand(FastbootService& service, LoopbackTransport& host, const std::string& command) {
+    std::string response;
+    FastbootStatus status;
+    std::thread device([&] { status = service.executeCommand(command, "", response); });
+    char buf[256];
+    host.read(buf, sizeof(buf));
+    host.writeString("OKAY");
+    device.join();
+    return status;
+}
+
+// Partição que descarta os dados: mede só transporte, pipeline e hash
+class NullBlockDevice : public BlockDevice {
+public:
+    bool write(uint64_t, const void*, size_t) override { return true; }
+    bool flush() override { return true; }
+    uint64_t size() const override { return UINT64_MAX; }
+};
+
+std::string flashArgument(const char* partition, size_t size, const std::string& digest) {
+    char arg[160];
+    std::snprintf(arg, sizeof(arg), "%s:%zx%s%s", partition, size, digest.empty() ? "" : ":", digest.c_str());
+    return arg;
+}
+
+} // namespace
+
+/**
+ * @brief Grava imagens pelo comando "flash" com o host em um LoopbackTransport:
+ * imagem íntegra, sha256 errado (a faixa gravada deve ser apagada), tamanho
+ * inválido, partição desconhecida e imagem acima de 4 GiB (todos com FAIL
+ * enviado ao host, sem fase de dados), "getvar max-download-size" e o
+ * balde único de latência para comandos desconhecidos.
+ * @return 0 se o teste for bem-sucedido, 1 caso contrário.
+ */
+int fastboot_run_selftest() {
+    std::printf("--- ARCANOS FASTBOOT: SELF-TEST ---\n");
+
+    auto ends = LoopbackTransport::createPair(1024 * 1024);
+    std::unique_ptr<LoopbackTransport> host = std::move(ends.second);
+    FastbootService service;
+    service.setTransport(std::move(ends.first));
+    auto system = std::make_shared<MemoryBlockDevice>(kTestPartition);
+    service.registerPartition("system", system);
+    FlashPipelineConfig config;
+    config.chunk_size = 64 * 1024; // Vários blocos em trânsito
+    service.setPipelineConfig(config);
+
+    std::vector<uint8_t> image(3 * 1024 * 1024 + 123);
+    for (size_t i = 0; i < image.size(); i++) {
+        image[i] = static_cast<uint8_t>(i * 131 + 7);
+    }
+    Sha256 sha;
+    sha.update(image.data(), image.size());
+    std::string digest = sha.finishHex();
+    FastbootStatus status;
+
+    // 1. Imagem íntegra: OKAY e conteúdo gravado
+    std::string reply = hostFlash(service, *host, flashArgument("system", image.size(), digest), image, status);
+    if (status != FastbootStatus::OK || reply != "OKAY" ||
+        std::memcmp(system->data.data(), image.data(), image.size()) != 0) {
+        std::printf("TEST FAILED: Flash integro respondeu '%s'.\n", reply.c_str());
+        return 1;
+    }
+
+    // 2. Digest errado: FAIL e a faixa gravada fica zerada (o resto, intacto)
+    std::fill(system->data.begin(), system->data.end(), kUnwritten);
+    std::string wrong = digest;
+    wrong[0] = wrong[0] == '0' ? '1' : '0';
+    reply = hostFlash(service, *host, flashArgument("system", image.size(), wrong), image, status);
+    if (status != FastbootStatus::COMMAND_FAIL || reply.compare(0, 4, "FAIL") != 0) {
+        std::printf("TEST FAILED: Digest errado respondeu '%s'.\n", reply.c_str());
+        return 1;
+    }
+    for (size_t i = 0; i < system->data.size(); i++) {
+        if (system->data[i] != (i < image.size() ? 0 : kUnwritten)) {
+            std::printf("TEST FAILED: Byte %zu da particao nao foi apagado apos o FAIL.\n", i);
+            return 1;
+        }
+    }
+
+    // 3. Tamanho inválido: FAIL chega ao host, sem fase de dados
+    reply = hostFlash(service, *host, "system:zz", {}, status);
+    if (status != FastbootStatus::INVALID_ARGUMENT || reply != "FAIL: Tamanho inválido.") {
+        std::printf("TEST FAILED: Tamanho invalido respondeu '%s'.\n", reply.c_str());
+        return 1;
+    }
+
+    // 4. Partição desconhecida
+    reply = hostFlash(service, *host, flashArgument("vendor", 16, ""), {}, status);
+    if (status != FastbootStatus::INVALID_ARGUMENT || reply.compare(0, 4, "FAIL") != 0) {
+        std::printf("TEST FAILED: Particao desconhecida respondeu '%s'.\n", reply.c_str());
+        return 1;
+    }
+
+    // 5. Acima de 4 GiB o tamanho não cabe na resposta DATA: FAIL antes dos dados
+    service.registerPartition("null", std::make_shared<NullBlockDevice>());
+    reply = hostFlash(service, *host, flashArgument("null", size_t(1) << 32, ""), {}, status);
+    std::string value;
+    if (status != FastbootStatus::INVALID_ARGUMENT || reply.compare(0, 4, "FAIL") != 0 ||
+        !service.getVar("max-download-size", value) || value != "0xffffffff") {
+        std::printf("TEST FAILED: Imagem de 4 GiB respondeu '%s' (max-download-size '%s').\n",
+                    reply.c_str(), value.c_str());
+        return 1;
+    }
+
+    // 6. Comandos desconhecidos dividem um único histograma de latência
+    for (int i = 0; i < 50; i++) {
+        hostCommand(service, *host, "cmd" + std::to_string(i));
+    }
+    if (!service.getVar("latency:other", value) || value.compare(0, 5, "n=50 ") != 0 ||
+        service.getVar("latency:cmd7", value) || !service.getVar("latency:flash", value)) {
+        std::printf("TEST FAILED: Latencia de comandos desconhecidos: '%s'.\n", value.c_str());
+        return 1;
+    }
+
+    std::printf("--- ARCANOS FASTBOOT: TESTE BEM-SUCEDIDO ---\n");
+    return 0;
+}
+
+/**
+ * @brief Mede o flash de ponta a ponta de 'bytes' bytes (1 GiB por padrão)
+ * por um LoopbackTransport, com a partição descartando os dados. Mostra a
+ * vazão total e os contadores por estágio ("getvar flash-stats").
+ */
+void fastboot_run_benchmark(uint64_t bytes) {
+    std::printf("--- ARCANOS FASTBOOT: BENCHMARK ---\n");
+
+    auto ends = LoopbackTransport::createPair(8 * 1024 * 1024);
+    std::unique_ptr<LoopbackTransport> host = std::move(ends.second);
+    FastbootService service;
+    service.setTransport(std::move(ends.first));
+    service.registerPartition("system", std::make_shared<NullBlockDevice>());
+
+    char arg[64];
+    std::snprintf(arg, sizeof(arg), "system:%llx", static_cast<unsigned long long>(bytes));
+    std::string response;
+    auto t0 = std::chrono::steady_clock::now();
+    std::thread device([&] { service.executeCommand("flash", arg, response); });
+
+    char data_reply[12];
+    host->readFully(data_reply, sizeof(data_reply));
+    std::vector<uint8_t> block(1024 * 1024, 0x5A);
+    for (uint64_t left = bytes; left > 0;) {
+        size_t n = static_cast<size_t>(std::min<uint64_t>(left, block.size()));
+        if (!host->writeAll(block.data(), n)) {
+            break;
+        }
+        left -= n;
+    }
+    char status[4];
+    host->readFully(status, sizeof(status));
+    device.join();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    std::string stats;
+    service.getVar("flash-stats", stats);
+    std::printf("FASTBOOT_BENCH: %llu MiB em %.2f s: %.1f MB/s (%s)\n",
+                static_cast<unsigned long long>(bytes >> 20), secs, secs > 0 ? bytes / secs / 1e6 : 0.0,
+                response.c_str());
+    std::printf("FASTBOOT_BENCH: %s\n", stats.c_str());
+}
+
+} // namespace arcanos::fastboot
+
+// Opcional: Função main simulada para execução direta do teste
+/*
+int main() {
+    if (arcanos::fastboot::fastboot_run_selftest() != 0) {
+        return 1;
+    }
+    arcanos::fastboot::fastboot_run_benchmark(1ull << 30);
+    return 0;
+}
+*/
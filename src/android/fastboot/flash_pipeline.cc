@@ -0,0 +1,202 @@
+//
+// Pipeline de flash em streaming do Fastboot.
+// Arquivo: src/android/fastboot/flash_pipeline.cc
+//
+
+#include "flash_pipeline.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+namespace arcanos::fastboot {
+
+// Marca de fim de fluxo nas filas entre estágios
+static constexpr size_t kEndOfStream = SIZE_MAX;
+
+static uint64_t nowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+std::string FlashPipelineStats::format() const {
+    char line[256];
+    auto stage = [](const FlashStageStats& s, char* out, size_t len) {
+        std::snprintf(out, len, "%.1fMB/s,stalls=%llu/%.1fms", s.busyMBps(),
+                      static_cast<unsigned long long>(s.stalls), s.stall_ns / 1e6);
+    };
+    char recv_str[64], verify_str[64], write_str[64];
+    stage(receive, recv_str, sizeof(recv_str));
+    stage(verify, verify_str, sizeof(verify_str));
+    stage(write, write_str, sizeof(write_str));
+    std::snprintf(line, sizeof(line), "bytes=%llu receive=%s verify=%s write=%s total=%.1fMB/s",
+                  static_cast<unsigned long long>(receive.bytes), recv_str, verify_str, write_str, totalMBps());
+    return line;
+}
+
+bool RawImageWriter::write(const uint8_t* data, size_t len) {
+    if (offset_ + len > device_.size()) {
+        return false; // Imagem maior que a partição
+    }
+    if (!device_.write(offset_, data, len)) {
+        return false;
+    }
+    offset_ += len;
+    return true;
+}
+
+bool RawImageWriter::finish() {
+    return device_.flush();
+}
+
+void FlashPipeline::ChunkQueue::push(size_t index) {
+    std::lock_guard<std::mutex> lock(lock_);
+    items_.push_back(index);
+    ready_.notify_one();
+}
+
+bool FlashPipeline::ChunkQueue::pop(size_t& index, FlashStageStats& stage) {
+    std::unique_lock<std::mutex> lock(lock_);
+    if (items_.empty() && !aborted_) {
+        uint64_t start = nowNs();
+        ready_.wait(lock, [&] { return !items_.empty() || aborted_; });
+        stage.stalls++;
+        stage.stall_ns += nowNs() - start;
+    }
+    if (aborted_) {
+        return false;
+    }
+    index = items_.front();
+    items_.pop_front();
+    return true;
+}
+
+void FlashPipeline::ChunkQueue::abort() {
+    std::lock_guard<std::mutex> lock(lock_);
+    aborted_ = true;
+    ready_.notify_all();
+}
+
+void FlashPipeline::ChunkQueue::reset() {
+    std::lock_guard<std::mutex> lock(lock_);
+    items_.clear();
+    aborted_ = false;
+}
+
+FlashPipeline::FlashPipeline(const FlashPipelineConfig& config) : config_(config) {
+    config_.buffers = std::max<size_t>(config_.buffers, 2);
+    config_.chunk_size = std::max<size_t>(config_.chunk_size, 4096);
+}
+
+void FlashPipeline::fail(const std::string& message) {
+    {
+        std::lock_guard<std::mutex> lock(error_lock_);
+        if (!failed_) {
+            failed_ = true;
+            error_ = message;
+        }
+    }
+    free_.abort();
+    to_verify_.abort();
+    to_write_.abort();
+}
+
+bool FlashPipeline::run(FastbootTransport& source, uint64_t total, ImageWriter& sink, std::string& error) {
+    if (chunks_.size() != config_.buffers) {
+        chunks_.assign(config_.buffers, Chunk());
+        for (Chunk& c : chunks_) {
+            c.data.resize(config_.chunk_size);
+        }
+    }
+    free_.reset();
+    to_verify_.reset();
+    to_write_.reset();
+    failed_ = false;
+    error_.clear();
+    digest_hex_.clear();
+    stats_ = FlashPipelineStats();
+    uint64_t run_start = nowNs();
+    for (size_t i = 0; i < chunks_.size(); i++) {
+        free_.push(i);
+    }
+
+    Sha256 sha;
+
+    // Estágio 2: verificação (hash incremental de cada bloco, em ordem)
+    std::thread verifier([&] {
+        FlashStageStats& st = stats_.verify;
+        size_t index;
+        while (to_verify_.pop(index, st)) {
+            if (index == kEndOfStream) {
+                digest_hex_ = sha.finishHex();
+                to_write_.push(kEndOfStream);
+                return;
+            }
+            uint64_t start = nowNs();
+            sha.update(chunks_[index].data.data(), chunks_[index].len);
+            st.busy_ns += nowNs() - start;
+            st.bytes += chunks_[index].len;
+            to_write_.push(index);
+        }
+    });
+
+    // Estágio 3: escrita no dispositivo
+    std::thread writer([&] {
+        FlashStageStats& st = stats_.write;
+        size_t index;
+        while (to_write_.pop(index, st)) {
+            uint64_t start = nowNs();
+            if (index == kEndOfStream) {
+                // O flush final conta como tempo de escrita
+                if (!sink.finish()) {
+                    fail(sink.errorMessage());
+                }
+                st.busy_ns += nowNs() - start;
+                return;
+            }
+            if (!sink.write(chunks_[index].data.data(), chunks_[index].len)) {
+                fail(sink.errorMessage());
+                return;
+            }
+            st.busy_ns += nowNs() - start;
+            st.bytes += chunks_[index].len;
+            free_.push(index);
+        }
+    });
+
+    // Estágio 1: recepção (nesta thread)
+    FlashStageStats& recv = stats_.receive;
+    uint64_t remaining = total;
+    while (remaining > 0) {
+        size_t index;
+        if (!free_.pop(index, recv)) {
+            break; // Outro estágio falhou
+        }
+        Chunk& c = chunks_[index];
+        c.len = static_cast<size_t>(std::min<uint64_t>(remaining, c.data.size()));
+        uint64_t start = nowNs();
+        if (!source.readFully(c.data.data(), c.len)) {
+            fail("transporte encerrado antes do fim da imagem");
+            break;
+        }
+        recv.busy_ns += nowNs() - start;
+        recv.bytes += c.len;
+        remaining -= c.len;
+        to_verify_.push(index);
+    }
+    if (remaining == 0) {
+        to_verify_.push(kEndOfStream);
+    }
+
+    verifier.join();
+    writer.join();
+    stats_.total_ns = nowNs() - run_start;
+
+    if (failed_) {
+        error = error_;
+        return false;
+    }
+    return true;
+}
+
+} // namespace arcanos::fastboot
@@ -0,0 +1,129 @@
+#ifndef ARCANOS_FASTBOOT_FLASH_PIPELINE_H
+#define ARCANOS_FASTBOOT_FLASH_PIPELINE_H
+
+#include "block_device.h"
+#include "sha256.h"
+#include "transport.h"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace arcanos::fastboot {
+
+/**
+ * @brief Consome a imagem em ordem e aplica no dispositivo de bloco.
+ */
+class ImageWriter {
+public:
+    virtual ~ImageWriter() = default;
+    virtual bool write(const uint8_t* data, size_t len) = 0;
+    // Chamado depois do último bloco (valida o fim da imagem e faz flush)
+    virtual bool finish() = 0;
+    // Motivo da última falha de write()/finish()
+    virtual std::string errorMessage() const { return "falha de escrita no dispositivo"; }
+};
+
+// Imagem crua: bytes gravados em sequência a partir do início da partição
+class RawImageWriter : public ImageWriter {
+public:
+    explicit RawImageWriter(BlockDevice& device) : device_(device) {}
+    bool write(const uint8_t* data, size_t len) override;
+    bool finish() override;
+
+private:
+    BlockDevice& device_;
+    uint64_t offset_ = 0;
+};
+
+// Contadores de um estágio do pipeline em uma execução
+struct FlashStageStats {
+    uint64_t bytes = 0;    // Bytes processados pelo estágio
+    uint64_t busy_ns = 0;  // Tempo fazendo trabalho (leitura, hash, escrita)
+    uint64_t stall_ns = 0; // Tempo esperando o estágio vizinho
+    uint64_t stalls = 0;   // Quantas vezes precisou esperar
+
+    // Vazão enquanto ocupado, em MB/s (0 se não houve trabalho)
+    double busyMBps() const { return busy_ns ? bytes * 1e3 / busy_ns : 0.0; }
+};
+
+struct FlashPipelineStats {
+    FlashStageStats receive; // Espera = nenhum buffer livre (verificação/escrita lentas)
+    FlashStageStats verify;  // Espera = nada recebido ainda (transporte lento)
+    FlashStageStats write;   // Espera = nada verificado ainda
+    uint64_t total_ns = 0;
+
+    double totalMBps() const { return total_ns ? receive.bytes * 1e3 / total_ns : 0.0; }
+
+    // Uma linha "receive=... verify=... write=... total=..." para logs e getvar
+    std::string format() const;
+};
+
+struct FlashPipelineConfig {
+    size_t chunk_size = 1024 * 1024; // Tamanho de cada bloco em trânsito
+    size_t buffers = 3;              // 2 = buffer duplo, 3 = triplo
+    size_t decompress_threads = 0;   // Download comprimido: 0 = todos os núcleos
+};
+
+/**
+ * @brief Pipeline de flash em streaming: receber (transporte) -> verificar (SHA-256)
+ * -> escrever (ImageWriter), cada estágio em sua thread.
+ *
+ * Com três buffers, receber o bloco N+1, verificar o N e escrever o N-1
+ * acontecem ao mesmo tempo, e a imagem nunca fica inteira na memória.
+ */
+class FlashPipeline {
+public:
+    explicit FlashPipeline(const FlashPipelineConfig& config = FlashPipelineConfig());
+
+    // Recebe 'total' bytes de 'source' e aplica em 'sink'. Em falha, 'error' explica.
+    bool run(FastbootTransport& source, uint64_t total, ImageWriter& sink, std::string& error);
+
+    // SHA-256 (hex) dos bytes recebidos na última execução
+    const std::string& digestHex() const { return digest_hex_; }
+
+    // Contadores por estágio da última execução
+    const FlashPipelineStats& stats() const { return stats_; }
+
+private:
+    struct Chunk {
+        std::vector<uint8_t> data;
+        size_t len = 0;
+    };
+
+    // Fila de índices de buffers entre dois estágios
+    class ChunkQueue {
+    public:
+        void push(size_t index);
+        // false quando abortada; esperas são contadas em 'stage'
+        bool pop(size_t& index, FlashStageStats& stage);
+        void abort();
+        void reset();
+    private:
+        std::mutex lock_;
+        std::condition_variable ready_;
+        std::deque<size_t> items_;
+        bool aborted_ = false;
+    };
+
+    void fail(const std::string& message);
+
+    FlashPipelineConfig config_;
+    std::vector<Chunk> chunks_;
+    ChunkQueue free_;
+    ChunkQueue to_verify_;
+    ChunkQueue to_write_;
+
+    std::mutex error_lock_;
+    std::string error_;
+    bool failed_ = false;
+    std::string digest_hex_;
+    FlashPipelineStats stats_;
+};
+
+} // namespace arcanos::fastboot
+
+#endif // ARCANOS_FASTBOOT_FLASH_PIPELINE_H
@@ -0,0 +1,72 @@
+//
+// Agendamento do flashall por dispositivo de armazenamento.
+// Arquivo: src/android/fastboot/flash_scheduler.cc
+//
+
+#include "flash_scheduler.h"
+#include <map>
+#include <sstream>
+#include <thread>
+
+namespace arcanos::fastboot {
+
+bool parseFlashManifest(const std::string& text, std::vector<FlashManifestEntry>& entries,
+                        std::string& error) {
+    entries.clear();
+    std::istringstream in(text);
+    std::string line;
+    for (int line_no = 1; std::getline(in, line); line_no++) {
+        std::istringstream fields(line);
+        FlashManifestEntry entry;
+        if (!(fields >> entry.partition) || entry.partition[0] == '#') {
+            continue;
+        }
+        std::string extra;
+        if (!(fields >> entry.image_path) || ((fields >> entry.expected_sha256) && (fields >> extra))) {
+            error = "linha " + std::to_string(line_no) + " do manifesto inválida";
+            return false;
+        }
+        entries.push_back(entry);
+    }
+    return true;
+}
+
+std::vector<FlashAllResult> FlashScheduler::run(const std::vector<FlashManifestEntry>& entries,
+                                                const DeviceOf& device_of, const FlashOne& flash) {
+    std::vector<FlashAllResult> results(entries.size());
+
+    // Fila por dispositivo, na ordem em que aparecem no manifesto
+    std::map<std::string, size_t> queue_of;
+    std::vector<std::vector<size_t>> queues;
+    for (size_t i = 0; i < entries.size(); i++) {
+        results[i].partition = entries[i].partition;
+        results[i].device_id = device_of(entries[i]);
+        auto it = queue_of.find(results[i].device_id);
+        if (it == queue_of.end()) {
+            it = queue_of.emplace(results[i].device_id, queues.size()).first;
+            queues.emplace_back();
+        }
+        queues[it->second].push_back(i);
+    }
+
+    // Cada thread só escreve nos resultados das suas próprias entradas
+    auto drain = [&](const std::vector<size_t>& queue) {
+        for (size_t i : queue) {
+            results[i].ok = flash(entries[i], results[i].error);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t q = 1; q < queues.size(); q++) {
+        workers.emplace_back(drain, std::cref(queues[q]));
+    }
+    if (!queues.empty()) {
+        drain(queues[0]); // A primeira fila roda na thread chamadora
+    }
+    for (std::thread& t : workers) {
+        t.join();
+    }
+    return results;
+}
+
+} // namespace arcanos::fastboot
@@ -0,0 +1,55 @@
+#ifndef ARCANOS_FASTBOOT_FLASH_SCHEDULER_H
+#define ARCANOS_FASTBOOT_FLASH_SCHEDULER_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace arcanos::fastboot {
+
+// Uma linha do manifesto do flashall
+struct FlashManifestEntry {
+    std::string partition;
+    std::string image_path;
+    std::string expected_sha256; // Vazio = não conferir
+};
+
+struct FlashAllResult {
+    std::string partition;
+    std::string device_id;
+    bool ok = false;
+    std::string error;
+};
+
+/**
+ * @brief Lê um manifesto: uma entrada por linha, "<partição> <imagem> [sha256]".
+ * Linhas vazias e iniciadas por '#' são ignoradas.
+ */
+bool parseFlashManifest(const std::string& text, std::vector<FlashManifestEntry>& entries,
+                        std::string& error);
+
+/**
+ * @brief Executa um lote de flashes com uma fila por dispositivo de armazenamento.
+ *
+ * Entradas do mesmo dispositivo rodam em sequência, na ordem do manifesto
+ * (escritas grandes e sequenciais, sem disputa pela mesma fila de I/O);
+ * dispositivos diferentes rodam em paralelo, uma thread cada. O tempo total
+ * tende ao do dispositivo com mais trabalho.
+ */
+class FlashScheduler {
+public:
+    using DeviceOf = std::function<std::string(const FlashManifestEntry&)>;
+    using FlashOne = std::function<bool(const FlashManifestEntry&, std::string& error)>;
+
+    // Uma falha não interrompe as demais entradas; os resultados seguem a ordem do manifesto
+    static std::vector<FlashAllResult> run(const std::vector<FlashManifestEntry>& entries,
+                                           const DeviceOf& device_of, const FlashOne& flash);
+};
+
+// Autoteste do flashall com partições em memória (flash_scheduler_test.cc)
+int flash_scheduler_run_selftest(const char* work_dir);
+
+} // namespace arcanos::fastboot
+
+#endif // ARCANOS_FASTBOOT_FLASH_SCHEDULER_H
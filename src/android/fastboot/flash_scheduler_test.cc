@@ -0,0 +1,248 @@
+//
+// Autoteste do flashall: manifesto, fila por dispositivo e resultados por entrada.
+// Arquivo: src/android/fastboot/flash_scheduler_test.cc
+//
+
+#include "fastboot.h"
+#include "sha256.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
+
+namespace arcanos::fastboot {
+
+namespace {
+
+constexpr size_t kImageSize = 512 * 1024;
+constexpr size_t kPartitionSize = 1024 * 1024;
+constexpr uint8_t kUnwritten = 0xAA; // Conteúdo da partição antes do flash
+
+// Registro das escritas de um armazenamento: qual partição escreveu, em ordem
+struct DeviceTrace {
+    std::mutex lock;
+    std::vector<std::string> writes;
+    std::atomic<int> active{0};      // Escritas em andamento neste armazenamento
+    std::atomic<int> max_active{0};
+};
+
+std::atomic<int> g_active{0};      // Escritas em andamento em todos os armazenamentos
+std::atomic<int> g_max_active{0};
+
+void raiseMax(std::atomic<int>& max, int value) {
+    int seen = max.load();
+    while (value > seen && !max.compare_exchange_weak(seen, value)) {
+    }
+}
+
+// Partição em memória com deviceId escolhido; cada escrita demora um pouco
+// para que filas de armazenamentos diferentes se sobreponham no tempo
+class TracedBlockDevice : public BlockDevice {
+public:
+    TracedBlockDevice(const std::string& partition, const std::string& device_id,
+                      std::shared_ptr<DeviceTrace> trace)
+        : data(kPartitionSize, kUnwritten), partition_(partition), device_id_(device_id),
+          trace_(std::move(trace)) {}
+
+    bool write(uint64_t offset, const void* src, size_t len) override {
+        if (offset + len > data.size()) {
+            return false;
+        }
+        raiseMax(trace_->max_active, ++trace_->active);
+        raiseMax(g_max_active, ++g_active);
+        {
+            std::lock_guard<std::mutex> lock(trace_->lock);
+            trace_->writes.push_back(partition_);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        std::memcpy(data.data() + offset, src, len);
+        --g_active;
+        --trace_->active;
+        return true;
+    }
+    bool flush() override { return true; }
+    uint64_t size() const override { return data.size(); }
+    std::string deviceId() const override { return device_id_; }
+
+    std::vector<uint8_t> data;
+
+private:
+    std::string partition_;
+    std::string device_id_;
+    std::shared_ptr<DeviceTrace> trace_;
+};
+
+bool writeFile(const std::string& path, const std::string& bytes) {
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    bool ok = fd >= 0 && write(fd, bytes.data(), bytes.size()) == static_cast<ssize_t>(bytes.size());
+    if (fd >= 0) {
+        close(fd);
+    }
+    return ok;
+}
+
+// Nenhuma escrita registrada nos dois armazenamentos
+bool tracesEmpty(const std::shared_ptr<DeviceTrace>& a, const std::shared_ptr<DeviceTrace>& b) {
+    return a->writes.empty() && b->writes.empty();
+}
+
+// 'writes' deve ser 'order' em blocos contíguos: sem alternar entre partições
+bool serialInOrder(const std::vector<std::string>& writes, const std::vector<std::string>& order) {
+    size_t next = 0;
+    for (size_t i = 0; i < writes.size(); i++) {
+        if (i == 0 || writes[i] != writes[i - 1]) {
+            if (next == order.size() || writes[i] != order[next]) {
+                return false;
+            }
+            next++;
+        }
+    }
+    return next == order.size();
+}
+
+} // namespace
+
+/**
+ * @brief Grava um manifesto com partições em dois armazenamentos (deviceId
+ * "emmc0" e "ufs1"), intercaladas no manifesto. Confere que as partições do
+ * mesmo armazenamento são gravadas uma de cada vez, na ordem do manifesto, que
+ * os dois armazenamentos se sobrepõem no tempo, que os resultados voltam na
+ * ordem do manifesto (inclusive com uma entrada falhando no meio), que uma
+ * partição desconhecida rejeita o manifesto sem gravar nada e que uma linha
+ * inválida responde FAIL ao "flashall".
+ * @param work_dir Diretório para as imagens e os manifestos.
+ * @return 0 se o teste for bem-sucedido, 1 caso contrário.
+ */
+int flash_scheduler_run_selftest(const char* work_dir) {
+    std::printf("--- ARCANOS FLASH SCHEDULER: SELF-TEST ---\n");
+
+    auto emmc = std::make_shared<DeviceTrace>();
+    auto ufs = std::make_shared<DeviceTrace>();
+    const char* const kNames[] = { "boot", "modem", "system", "userdata", "vendor" };
+    const char* const kDevices[] = { "emmc0", "ufs1", "emmc0", "ufs1", "emmc0" };
+
+    auto ends = LoopbackTransport::createPair(1024 * 1024);
+    std::unique_ptr<LoopbackTransport> host = std::move(ends.second);
+    FastbootService service;
+    service.setTransport(std::move(ends.first));
+    FlashPipelineConfig config;
+    config.chunk_size = 64 * 1024; // Várias escritas por imagem
+    service.setPipelineConfig(config);
+
+    std::string dir(work_dir);
+    std::vector<std::shared_ptr<TracedBlockDevice>> devices;
+    std::vector<std::string> images;
+    std::string manifest = "# particao imagem [sha256]\n\n";
+    for (size_t p = 0; p < 5; p++) {
+        bool on_emmc = std::strcmp(kDevices[p], "emmc0") == 0;
+        devices.push_back(std::make_shared<TracedBlockDevice>(kNames[p], kDevices[p], on_emmc ? emmc : ufs));
+        service.registerPartition(kNames[p], devices[p]);
+
+        std::string image(kImageSize, '\0');
+        for (size_t i = 0; i < image.size(); i++) {
+            image[i] = static_cast<char>(i * 131 + p * 17 + 7);
+        }
+        std::string path = dir + "/selftest_flash_" + kNames[p] + ".img";
+        if (!writeFile(path, image)) {
+            std::printf("TEST FAILED: Nao foi possivel criar %s.\n", path.c_str());
+            return 1;
+        }
+        Sha256 sha;
+        sha.update(image.data(), image.size());
+        manifest += std::string(kNames[p]) + " " + path + " " + sha.finishHex() + "\n";
+        images.push_back(image);
+    }
+
+    // 1. Manifesto lido na ordem, comentário e linha vazia ignorados
+    std::vector<FlashManifestEntry> entries;
+    std::string error;
+    if (!parseFlashManifest(manifest, entries, error) || entries.size() != 5 ||
+        entries[3].partition != "userdata" || entries[3].expected_sha256.size() != 64) {
+        std::printf("TEST FAILED: Manifesto valido nao foi lido: %s\n", error.c_str());
+        return 1;
+    }
+
+    // 2. Mesmo armazenamento em sequência e na ordem; armazenamentos diferentes ao mesmo tempo
+    std::vector<FlashAllResult> results;
+    if (service.flashAll(entries, results) != FastbootStatus::OK) {
+        std::printf("TEST FAILED: flashAll do manifesto valido falhou.\n");
+        return 1;
+    }
+    if (emmc->max_active != 1 || ufs->max_active != 1 ||
+        !serialInOrder(emmc->writes, { "boot", "system", "vendor" }) ||
+        !serialInOrder(ufs->writes, { "modem", "userdata" })) {
+        std::printf("TEST FAILED: Particoes do mesmo armazenamento nao foram gravadas em sequencia.\n");
+        return 1;
+    }
+    if (g_max_active < 2) {
+        std::printf("TEST FAILED: Armazenamentos diferentes nao foram gravados em paralelo.\n");
+        return 1;
+    }
+    for (size_t p = 0; p < 5; p++) {
+        if (results.size() != 5 || results[p].partition != kNames[p] || results[p].device_id != kDevices[p] ||
+            !results[p].ok || std::memcmp(devices[p]->data.data(), images[p].data(), kImageSize) != 0) {
+            std::printf("TEST FAILED: Resultado/conteudo da entrada %zu (%s).\n", p, kNames[p]);
+            return 1;
+        }
+    }
+
+    // 3. Uma entrada falha no meio: as outras seguem e os resultados ficam na ordem
+    entries[2].expected_sha256[0] = entries[2].expected_sha256[0] == '0' ? '1' : '0';
+    if (service.flashAll(entries, results) != FastbootStatus::COMMAND_FAIL || results.size() != 5) {
+        std::printf("TEST FAILED: Entrada com sha256 errado nao retornou COMMAND_FAIL.\n");
+        return 1;
+    }
+    for (size_t p = 0; p < 5; p++) {
+        if (results[p].partition != kNames[p] || results[p].ok != (p != 2)) {
+            std::printf("TEST FAILED: Resultado da entrada %zu fora de ordem ou errado.\n", p);
+            return 1;
+        }
+    }
+
+    // 4. Partição desconhecida: o manifesto inteiro é rejeitado antes de gravar
+    emmc->writes.clear();
+    ufs->writes.clear();
+    entries[2].expected_sha256 = "";
+    entries.push_back({ "recovery", entries[0].image_path, "" });
+    if (service.flashAll(entries, results) != FastbootStatus::INVALID_ARGUMENT || !results.empty() ||
+        !tracesEmpty(emmc, ufs)) {
+        std::printf("TEST FAILED: Particao desconhecida nao rejeitou o manifesto inteiro.\n");
+        return 1;
+    }
+
+    // 5. Uma linha inválida: "flashall" responde FAIL e nada é gravado
+    std::string manifest_path = dir + "/selftest_flash_manifest.txt";
+    if (!writeFile(manifest_path, manifest + "vendor_boot a.img b c\n")) {
+        std::printf("TEST FAILED: Nao foi possivel criar %s.\n", manifest_path.c_str());
+        return 1;
+    }
+    std::string response;
+    FastbootStatus status = service.executeCommand("flashall", manifest_path, response);
+    char reply[256];
+    ssize_t n = host->read(reply, sizeof(reply));
+    if (status != FastbootStatus::INVALID_ARGUMENT || n < 4 || std::memcmp(reply, "FAIL", 4) != 0 ||
+        response.find("linha 8") == std::string::npos || !tracesEmpty(emmc, ufs)) {
+        std::printf("TEST FAILED: Linha invalida respondeu '%s'.\n", response.c_str());
+        return 1;
+    }
+
+    for (const char* name : kNames) {
+        unlink((dir + "/selftest_flash_" + name + ".img").c_str());
+    }
+    unlink(manifest_path.c_str());
+    std::printf("--- ARCANOS FLASH SCHEDULER: TESTE BEM-SUCEDIDO ---\n");
+    return 0;
+}
+
+} // namespace arcanos::fastboot
+
+// Opcional: Função main simulada para execução direta do teste
+/*
+int main() {
+    return arcanos::fastboot::flash_scheduler_run_selftest("/tmp");
+}
+*/
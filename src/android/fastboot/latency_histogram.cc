@@ -0,0 +1,72 @@
+//
+// Histograma de latência dos comandos Fastboot.
+// Arquivo: src/android/fastboot/latency_histogram.cc
+//
+
+#include "latency_histogram.h"
+#include <cstdio>
+
+namespace arcanos::fastboot {
+
+void LatencyHistogram::record(uint64_t ns) {
+    uint64_t us = ns / 1000;
+    size_t bucket = 0;
+    while (us != 0 && bucket < kBuckets - 1) {
+        us >>= 1;
+        bucket++;
+    }
+    buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_ns_.fetch_add(ns, std::memory_order_relaxed);
+
+    uint64_t prev = max_ns_.load(std::memory_order_relaxed);
+    while (ns > prev && !max_ns_.compare_exchange_weak(prev, ns, std::memory_order_relaxed)) {
+    }
+}
+
+void LatencyHistogram::reset() {
+    for (auto& b : buckets_) {
+        b.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    sum_ns_.store(0, std::memory_order_relaxed);
+    max_ns_.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::meanNs() const {
+    uint64_t n = count();
+    return n ? sum_ns_.load(std::memory_order_relaxed) / n : 0;
+}
+
+uint64_t LatencyHistogram::percentileUs(double p) const {
+    uint64_t n = count();
+    if (n == 0) {
+        return 0;
+    }
+    // Posição (1-based) da amostra do percentil
+    uint64_t rank = static_cast<uint64_t>(p / 100.0 * n + 0.5);
+    if (rank == 0) {
+        rank = 1;
+    }
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; i++) {
+        seen += buckets_[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            return uint64_t(1) << i;
+        }
+    }
+    return uint64_t(1) << (kBuckets - 1);
+}
+
+std::string LatencyHistogram::summary() const {
+    char line[128];
+    std::snprintf(line, sizeof(line), "n=%llu mean=%lluus p50<=%lluus p99<=%lluus max=%lluus",
+                  static_cast<unsigned long long>(count()),
+                  static_cast<unsigned long long>(meanNs() / 1000),
+                  static_cast<unsigned long long>(percentileUs(50)),
+                  static_cast<unsigned long long>(percentileUs(99)),
+                  static_cast<unsigned long long>(maxNs() / 1000));
+    return line;
+}
+
+} // namespace arcanos::fastboot
@@ -0,0 +1,43 @@
+#ifndef ARCANOS_FASTBOOT_LATENCY_HISTOGRAM_H
+#define ARCANOS_FASTBOOT_LATENCY_HISTOGRAM_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace arcanos::fastboot {
+
+/**
+ * @brief Histograma de latência com baldes em potências de 2 de microssegundos.
+ *
+ * Balde i conta amostras em [2^(i-1), 2^i) µs (o 0 fica com < 1 µs); o
+ * último acumula tudo acima de ~34 min. record() é lock-free.
+ */
+class LatencyHistogram {
+public:
+    static constexpr size_t kBuckets = 32;
+
+    void record(uint64_t ns);
+    void reset();
+
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+    uint64_t maxNs() const { return max_ns_.load(std::memory_order_relaxed); }
+    uint64_t meanNs() const;
+
+    // Limite superior (µs) do balde que contém o percentil 'p' (0-100)
+    uint64_t percentileUs(double p) const;
+
+    // "n=... mean=...us p50<=...us p99<=...us max=...us"
+    std::string summary() const;
+
+private:
+    std::atomic<uint64_t> buckets_[kBuckets] = {};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_ns_{0};
+    std::atomic<uint64_t> max_ns_{0};
+};
+
+} // namespace arcanos::fastboot
+
+#endif // ARCANOS_FASTBOOT_LATENCY_HISTOGRAM_H
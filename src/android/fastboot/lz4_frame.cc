@@ -0,0 +1,500 @@
+//
+// Modo de download comprimido (frames LZ4) do Fastboot.
+// Arquivo: src/android/fastboot/lz4_frame.cc
+//
+
+#include "lz4_frame.h"
+#include <algorithm>
+#include <cstring>
+
+namespace arcanos::fastboot {
+
+// ---------------------------------------------------------------------------
+// xxHash32
+// ---------------------------------------------------------------------------
+
+static constexpr uint32_t kPrime1 = 2654435761u;
+static constexpr uint32_t kPrime2 = 2246822519u;
+static constexpr uint32_t kPrime3 = 3266489917u;
+static constexpr uint32_t kPrime4 = 668265263u;
+static constexpr uint32_t kPrime5 = 374761393u;
+
+static inline uint32_t rotl32(uint32_t x, int r) {
+    return (x << r) | (x >> (32 - r));
+}
+
+static inline uint32_t read32(const uint8_t* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v)); // Formato little-endian, como o host
+    return v;
+}
+
+static inline uint32_t xxhRound(uint32_t acc, uint32_t input) {
+    acc += input * kPrime2;
+    return rotl32(acc, 13) * kPrime1;
+}
+
+void Xxh32State::reset(uint32_t seed) {
+    seed_ = seed;
+    v_[0] = seed + kPrime1 + kPrime2;
+    v_[1] = seed + kPrime2;
+    v_[2] = seed;
+    v_[3] = seed - kPrime1;
+    total_ = 0;
+    buffered_ = 0;
+}
+
+void Xxh32State::update(const void* data, size_t len) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    total_ += len;
+    if (buffered_ + len < sizeof(buffer_)) {
+        std::memcpy(buffer_ + buffered_, p, len);
+        buffered_ += len;
+        return;
+    }
+    if (buffered_ > 0) {
+        size_t n = sizeof(buffer_) - buffered_;
+        std::memcpy(buffer_ + buffered_, p, n);
+        for (int i = 0; i < 4; i++) {
+            v_[i] = xxhRound(v_[i], read32(buffer_ + i * 4));
+        }
+        p += n;
+        len -= n;
+        buffered_ = 0;
+    }
+    while (len >= 16) {
+        for (int i = 0; i < 4; i++) {
+            v_[i] = xxhRound(v_[i], read32(p + i * 4));
+        }
+        p += 16;
+        len -= 16;
+    }
+    std::memcpy(buffer_, p, len);
+    buffered_ = len;
+}
+
+uint32_t Xxh32State::digest() const {
+    uint32_t h;
+    if (total_ >= 16) {
+        h = rotl32(v_[0], 1) + rotl32(v_[1], 7) + rotl32(v_[2], 12) + rotl32(v_[3], 18);
+    } else {
+        h = seed_ + kPrime5;
+    }
+    h += static_cast<uint32_t>(total_);
+
+    const uint8_t* p = buffer_;
+    size_t len = buffered_;
+    while (len >= 4) {
+        h += read32(p) * kPrime3;
+        h = rotl32(h, 17) * kPrime4;
+        p += 4;
+        len -= 4;
+    }
+    while (len > 0) {
+        h += *p++ * kPrime5;
+        h = rotl32(h, 11) * kPrime1;
+        len--;
+    }
+    h ^= h >> 15;
+    h *= kPrime2;
+    h ^= h >> 13;
+    h *= kPrime3;
+    h ^= h >> 16;
+    return h;
+}
+
+uint32_t xxh32(const void* data, size_t len, uint32_t seed) {
+    Xxh32State state(seed);
+    state.update(data, len);
+    return state.digest();
+}
+
+// ---------------------------------------------------------------------------
+// Bloco LZ4
+// ---------------------------------------------------------------------------
+
+bool lz4DecompressBlock(const uint8_t* src, size_t src_len, uint8_t* dst, size_t dst_capacity,
+                        size_t& out_len) {
+    const uint8_t* ip = src;
+    const uint8_t* const iend = src + src_len;
+    uint8_t* op = dst;
+    uint8_t* const oend = dst + dst_capacity;
+
+    while (ip < iend) {
+        unsigned token = *ip++;
+
+        // Literais
+        size_t lit = token >> 4;
+        if (lit == 15) {
+            unsigned b;
+            do {
+                if (ip >= iend) {
+                    return false;
+                }
+                b = *ip++;
+                lit += b;
+            } while (b == 255);
+        }
+        if (lit > static_cast<size_t>(iend - ip) || lit > static_cast<size_t>(oend - op)) {
+            return false;
+        }
+        std::memcpy(op, ip, lit);
+        ip += lit;
+        op += lit;
+        if (ip == iend) {
+            break; // A última sequência só tem literais
+        }
+
+        // Cópia de trecho anterior
+        if (iend - ip < 2) {
+            return false;
+        }
+        size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > static_cast<size_t>(op - dst)) {
+            return false;
+        }
+        size_t match = token & 15;
+        if (match == 15) {
+            unsigned b;
+            do {
+                if (ip >= iend) {
+                    return false;
+                }
+                b = *ip++;
+                match += b;
+            } while (b == 255);
+        }
+        match += 4;
+        if (match > static_cast<size_t>(oend - op)) {
+            return false;
+        }
+        const uint8_t* from = op - offset;
+        if (offset >= match) {
+            std::memcpy(op, from, match);
+            op += match;
+        } else {
+            // Sobreposição (ex.: offset 1 repete um byte): copia em passos de 'offset'
+            while (match > 0) {
+                size_t n = std::min(match, offset);
+                std::memcpy(op, from, n);
+                op += n;
+                match -= n;
+            }
+        }
+    }
+    out_len = static_cast<size_t>(op - dst);
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Lz4FrameWriter
+// ---------------------------------------------------------------------------
+
+Lz4FrameWriter::Lz4FrameWriter(std::unique_ptr<ImageWriter> inner, size_t threads)
+    : inner_(std::move(inner)) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    // Dois blocos por thread: um sendo descomprimido, outro já recebido esperando vez
+    jobs_.resize(std::max<size_t>(threads * 2, 2));
+    for (size_t i = 0; i < threads; i++) {
+        workers_.emplace_back(&Lz4FrameWriter::workerLoop, this);
+    }
+}
+
+Lz4FrameWriter::~Lz4FrameWriter() {
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        stopping_ = true;
+    }
+    work_ready_.notify_all();
+    for (std::thread& t : workers_) {
+        t.join();
+    }
+}
+
+std::string Lz4FrameWriter::errorMessage() const {
+    return inner_failed_ ? inner_->errorMessage() : error_;
+}
+
+bool Lz4FrameWriter::invalid(const char* message) {
+    error_ = std::string("download comprimido inválido: ") + message;
+    return false;
+}
+
+void Lz4FrameWriter::workerLoop() {
+    for (;;) {
+        Job* job;
+        {
+            std::unique_lock<std::mutex> lock(lock_);
+            work_ready_.wait(lock, [&] { return stopping_ || !pending_.empty(); });
+            if (stopping_) {
+                return;
+            }
+            job = pending_.front();
+            pending_.pop_front();
+        }
+
+        bool ok;
+        if (job->stored) {
+            job->out.swap(job->in);
+            job->out_len = job->out.size();
+            ok = true;
+        } else {
+            job->out.resize(max_block_);
+            ok = lz4DecompressBlock(job->in.data(), job->in.size(), job->out.data(), job->out.size(),
+                                    job->out_len);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            job->ok = ok;
+            job->done = true;
+        }
+        job_done_.notify_all();
+    }
+}
+
+bool Lz4FrameWriter::emitOldest() {
+    Job& job = jobs_[emitted_ % jobs_.size()];
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        job_done_.wait(lock, [&] { return job.done; });
+        job.done = false;
+    }
+    emitted_++;
+    if (!job.ok) {
+        return invalid("bloco LZ4 corrompido");
+    }
+    if (content_checksum_) {
+        content_hash_.update(job.out.data(), job.out_len);
+    }
+    out_bytes_ += job.out_len;
+    if (!inner_->write(job.out.data(), job.out_len)) {
+        inner_failed_ = true;
+        return false;
+    }
+    return true;
+}
+
+bool Lz4FrameWriter::drain() {
+    while (emitted_ < submitted_) {
+        if (!emitOldest()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Lz4FrameWriter::submitBlock() {
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        pending_.push_back(current_);
+    }
+    work_ready_.notify_one();
+    current_ = nullptr;
+    submitted_++;
+
+    // Repassa o que já ficou pronto, sem esperar
+    while (emitted_ < submitted_) {
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            if (!jobs_[emitted_ % jobs_.size()].done) {
+                break;
+            }
+        }
+        if (!emitOldest()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Lz4FrameWriter::onDescriptor() {
+    uint8_t flg = field_[0];
+    uint8_t bd = field_[1];
+    if ((flg >> 6) != 1 || (flg & 0x02) || (bd & 0x8F)) {
+        return invalid("versão ou bits reservados do frame");
+    }
+    if (!(flg & 0x20)) {
+        return invalid("blocos encadeados não são suportados (use blocos independentes)");
+    }
+    if (flg & 0x01) {
+        return invalid("dicionário não é suportado");
+    }
+    uint8_t hc = static_cast<uint8_t>(xxh32(field_.data(), field_.size() - 1, 0) >> 8);
+    if (hc != field_.back()) {
+        return invalid("checksum do cabeçalho");
+    }
+    unsigned block_id = (bd >> 4) & 7;
+    if (block_id < 4) {
+        return invalid("tamanho máximo de bloco");
+    }
+    max_block_ = size_t(1) << (8 + 2 * block_id); // 64 KiB, 256 KiB, 1 MiB, 4 MiB
+    block_checksum_ = (flg & 0x10) != 0;
+    content_checksum_ = (flg & 0x04) != 0;
+    content_hash_.reset();
+    frame_started_ = true;
+    return true;
+}
+
+bool Lz4FrameWriter::write(const uint8_t* data, size_t len) {
+    while (len > 0) {
+        if (state_ == State::Skip) {
+            size_t n = static_cast<size_t>(std::min<uint64_t>(skip_left_, len));
+            skip_left_ -= n;
+            data += n;
+            len -= n;
+            if (skip_left_ == 0) {
+                state_ = State::Magic;
+                need_ = 4;
+            }
+            continue;
+        }
+
+        if (state_ == State::BlockData) {
+            // Copia direto para o buffer do bloco
+            size_t n = std::min(need_ - current_->in.size(), len);
+            current_->in.insert(current_->in.end(), data, data + n);
+            data += n;
+            len -= n;
+            if (current_->in.size() < need_) {
+                continue;
+            }
+            if (block_checksum_) {
+                state_ = State::BlockChecksum;
+                need_ = 4;
+            } else {
+                if (!submitBlock()) {
+                    return false;
+                }
+                state_ = State::BlockSize;
+                need_ = 4;
+            }
+            continue;
+        }
+
+        size_t n = std::min(need_ - field_.size(), len);
+        field_.insert(field_.end(), data, data + n);
+        data += n;
+        len -= n;
+        if (field_.size() < need_) {
+            continue;
+        }
+
+        switch (state_) {
+        case State::Magic: {
+            uint32_t magic = read32(field_.data());
+            field_.clear();
+            if (magic == kLz4FrameMagic) {
+                state_ = State::Descriptor;
+                need_ = 2;
+            } else if ((magic & 0xFFFFFFF0u) == 0x184D2A50u) {
+                state_ = State::SkipSize;
+                need_ = 4;
+            } else {
+                return invalid("magic de frame desconhecido");
+            }
+            break;
+        }
+        case State::Descriptor: {
+            // FLG e BD definem quantos campos opcionais vêm antes do checksum
+            size_t full = 2 + ((field_[0] & 0x08) ? 8 : 0) + ((field_[0] & 0x01) ? 4 : 0) + 1;
+            if (need_ < full) {
+                need_ = full;
+                break;
+            }
+            if (!onDescriptor()) {
+                return false;
+            }
+            field_.clear();
+            state_ = State::BlockSize;
+            need_ = 4;
+            break;
+        }
+        case State::SkipSize:
+            skip_left_ = read32(field_.data());
+            field_.clear();
+            state_ = skip_left_ ? State::Skip : State::Magic;
+            need_ = 4;
+            break;
+        case State::BlockSize: {
+            uint32_t word = read32(field_.data());
+            field_.clear();
+            if (word == 0) {
+                // Fim do frame: o checksum de conteúdo exige tudo emitido
+                if (!drain()) {
+                    return false;
+                }
+                state_ = content_checksum_ ? State::ContentChecksum : State::Magic;
+                need_ = 4;
+                break;
+            }
+            size_t size = word & 0x7FFFFFFFu;
+            if (size > max_block_) {
+                return invalid("bloco maior que o máximo do frame");
+            }
+            if (submitted_ - emitted_ == jobs_.size() && !emitOldest()) {
+                return false; // Janela cheia: espera o bloco mais antigo
+            }
+            current_ = &jobs_[submitted_ % jobs_.size()];
+            current_->in.clear();
+            current_->in.reserve(max_block_);
+            current_->stored = (word & 0x80000000u) != 0;
+            state_ = State::BlockData;
+            need_ = size;
+            if (size == 0) {
+                if (!submitBlock()) {
+                    return false;
+                }
+                state_ = State::BlockSize;
+                need_ = 4;
+            }
+            break;
+        }
+        case State::BlockChecksum: {
+            uint32_t expected = read32(field_.data());
+            field_.clear();
+            if (xxh32(current_->in.data(), current_->in.size(), 0) != expected) {
+                return invalid("checksum de bloco");
+            }
+            if (!submitBlock()) {
+                return false;
+            }
+            state_ = State::BlockSize;
+            need_ = 4;
+            break;
+        }
+        case State::ContentChecksum: {
+            uint32_t expected = read32(field_.data());
+            field_.clear();
+            if (content_hash_.digest() != expected) {
+                return invalid("checksum do conteúdo");
+            }
+            state_ = State::Magic;
+            need_ = 4;
+            break;
+        }
+        default:
+            break;
+        }
+    }
+    return true;
+}
+
+bool Lz4FrameWriter::finish() {
+    if (!frame_started_ || state_ != State::Magic || !field_.empty()) {
+        return invalid("frame truncado");
+    }
+    if (!drain()) {
+        return false;
+    }
+    if (!inner_->finish()) {
+        inner_failed_ = true;
+        return false;
+    }
+    return true;
+}
+
+} // namespace arcanos::fastboot
@@ -0,0 +1,121 @@
+#ifndef ARCANOS_FASTBOOT_LZ4_FRAME_H
+#define ARCANOS_FASTBOOT_LZ4_FRAME_H
+
+#include "flash_pipeline.h"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace arcanos::fastboot {
+
+constexpr uint32_t kLz4FrameMagic = 0x184D2204;
+
+// xxHash32, usado nos checksums do formato de frame LZ4
+uint32_t xxh32(const void* data, size_t len, uint32_t seed);
+
+class Xxh32State {
+public:
+    explicit Xxh32State(uint32_t seed = 0) { reset(seed); }
+    void reset(uint32_t seed = 0);
+    void update(const void* data, size_t len);
+    uint32_t digest() const;
+
+private:
+    uint32_t v_[4];
+    uint32_t seed_;
+    uint64_t total_;
+    uint8_t buffer_[16];
+    size_t buffered_;
+};
+
+// Descomprime um bloco LZ4 (formato de bloco, sem cabeçalho). false se corrompido.
+bool lz4DecompressBlock(const uint8_t* src, size_t src_len, uint8_t* dst, size_t dst_capacity,
+                        size_t& out_len);
+
+/**
+ * @brief Modo de download comprimido: descomprime frames LZ4 e repassa a imagem
+ * expandida, em ordem, para outro ImageWriter.
+ *
+ * Blocos independentes (o padrão do lz4) são descomprimidos em paralelo por
+ * um conjunto de threads, enquanto o pipeline continua recebendo; a
+ * thread de escrita só bloqueia quando a janela de blocos em voo enche.
+ * Frames concatenados e frames "skippable" são aceitos; blocos encadeados
+ * (lz4 -BD) não. Checksums de cabeçalho, bloco e conteúdo são conferidos.
+ */
+class Lz4FrameWriter : public ImageWriter {
+public:
+    // threads = 0 usa todos os núcleos
+    Lz4FrameWriter(std::unique_ptr<ImageWriter> inner, size_t threads = 0);
+    ~Lz4FrameWriter() override;
+    Lz4FrameWriter(const Lz4FrameWriter&) = delete;
+    Lz4FrameWriter& operator=(const Lz4FrameWriter&) = delete;
+
+    bool write(const uint8_t* data, size_t len) override;
+    bool finish() override;
+    std::string errorMessage() const override;
+
+    // Bytes entregues ao escritor interno (imagem expandida)
+    uint64_t decompressedBytes() const { return out_bytes_; }
+
+private:
+    enum class State { Magic, Descriptor, BlockSize, BlockData, BlockChecksum, ContentChecksum, SkipSize, Skip };
+
+    struct Job {
+        std::vector<uint8_t> in;
+        std::vector<uint8_t> out;
+        size_t out_len = 0;
+        bool stored = false;   // Bloco gravado sem compressão
+        bool ok = false;
+        bool done = false;
+    };
+
+    bool invalid(const char* message);
+    bool onDescriptor();
+    bool submitBlock();
+    bool emitOldest();
+    bool drain();
+    void workerLoop();
+
+    std::unique_ptr<ImageWriter> inner_;
+    std::string error_;
+    bool inner_failed_ = false;
+
+    // Parser do frame (acumula campos que chegam divididos entre blocos)
+    State state_ = State::Magic;
+    std::vector<uint8_t> field_;
+    size_t need_ = 4;
+    uint64_t skip_left_ = 0;
+    bool block_checksum_ = false;
+    bool content_checksum_ = false;
+    size_t max_block_ = 0;
+    bool frame_started_ = false;
+    Xxh32State content_hash_;
+    uint64_t out_bytes_ = 0;
+
+    // Janela circular de blocos: emitidos em ordem de submissão
+    std::vector<Job> jobs_;
+    uint64_t submitted_ = 0;
+    uint64_t emitted_ = 0;
+    Job* current_ = nullptr; // Bloco sendo recebido
+
+    std::mutex lock_;
+    std::condition_variable work_ready_;
+    std::condition_variable job_done_;
+    std::deque<Job*> pending_;
+    bool stopping_ = false;
+    std::vector<std::thread> workers_;
+};
+
+// Autoteste e benchmark do download comprimido (lz4_frame_test.cc)
+int lz4_run_selftest();
+void lz4_run_benchmark(unsigned max_threads, double link_mbps = 40.0);
+
+} // namespace arcanos::fastboot
+
+#endif // ARCANOS_FASTBOOT_LZ4_FRAME_H
@@ -0,0 +1,33 @@
+#ifndef ARCANOS_FASTBOOT_SHA256_H
+#define ARCANOS_FASTBOOT_SHA256_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace arcanos::fastboot {
+
+// SHA-256 incremental (verificação das imagens recebidas, bloco a bloco)
+class Sha256 {
+public:
+    Sha256() { reset(); }
+
+    void reset();
+    void update(const void* data, size_t len);
+    void finish(uint8_t digest[32]);
+
+    // Digest em hexadecimal minúsculo (finaliza o contexto)
+    std::string finishHex();
+
+private:
+    void transform(const uint8_t block[64]);
+
+    uint32_t state_[8];
+    uint64_t total_;
+    uint8_t buffer_[64];
+    size_t buffered_;
+};
+
+} // namespace arcanos::fastboot
+
+#endif // ARCANOS_FASTBOOT_SHA256_H
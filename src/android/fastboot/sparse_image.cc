@@ -0,0 +1,588 @@
+//
+// Imagens esparsas do Android no caminho de flash do Fastboot.
+// Arquivo: src/android/fastboot/sparse_image.cc
+//
+// Os cabeçalhos são lidos com memcpy: o formato é little-endian, assim
+// como todas as arquiteturas suportadas pelo Arcanos.
+//
+
+#include "sparse_image.h"
+#include "lz4_frame.h"
+#include <algorithm>
+#include <cstring>
+
+namespace arcanos::fastboot {
+
+// ---------------------------------------------------------------------------
+// CRC-32
+// ---------------------------------------------------------------------------
+
+static const uint32_t* crcTable() {
+    static uint32_t table[256];
+    static bool ready = [] {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            table[i] = c;
+        }
+        return true;
+    }();
+    (void)ready;
+    return table;
+}
+
+uint32_t sparseCrc32(uint32_t crc, const void* data, size_t len) {
+    const uint32_t* table = crcTable();
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    uint32_t c = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        c = table[(c ^ p[i]) & 0xff] ^ (c >> 8);
+    }
+    return ~c;
+}
+
+// Multiplicação matriz x vetor em GF(2) (técnica do crc32_combine do zlib)
+static uint32_t gf2Times(const uint32_t* mat, uint32_t vec) {
+    uint32_t sum = 0;
+    for (int i = 0; vec != 0; i++, vec >>= 1) {
+        if (vec & 1) {
+            sum ^= mat[i];
+        }
+    }
+    return sum;
+}
+
+static void gf2Square(uint32_t* square, const uint32_t* mat) {
+    for (int n = 0; n < 32; n++) {
+        square[n] = gf2Times(mat, mat[n]);
+    }
+}
+
+// CRC depois de 'len' bytes zero, em O(log len): DONT_CARE e FILL zero de
+// gigabytes entram no CRC sem percorrer os bytes
+static uint32_t crc32Zeros(uint32_t crc, uint64_t len) {
+    if (len == 0) {
+        return crc;
+    }
+    uint32_t odd[32];  // Operador para potências ímpares de 2 bits
+    uint32_t even[32]; // ... e pares
+    odd[0] = 0xEDB88320u;
+    for (int n = 1; n < 32; n++) {
+        odd[n] = 1u << (n - 1);
+    }
+    gf2Square(even, odd); // 2 bits
+    gf2Square(odd, even); // 4 bits
+
+    uint32_t reg = ~crc;
+    do {
+        gf2Square(even, odd); // 1 byte na primeira volta
+        if (len & 1) {
+            reg = gf2Times(even, reg);
+        }
+        len >>= 1;
+        if (len == 0) {
+            break;
+        }
+        gf2Square(odd, even);
+        if (len & 1) {
+            reg = gf2Times(odd, reg);
+        }
+        len >>= 1;
+    } while (len != 0);
+    return ~reg;
+}
+
+// ---------------------------------------------------------------------------
+// SparseImageWriter
+// ---------------------------------------------------------------------------
+
+bool SparseImageWriter::invalid(const char* message) {
+    error_ = std::string("imagem esparsa inválida: ") + message;
+    return false;
+}
+
+void SparseImageWriter::crcZeros(uint64_t len) {
+    crc_ = crc32Zeros(crc_, len);
+}
+
+bool SparseImageWriter::onFileHeader() {
+    std::memcpy(&header_, staging_, sizeof(header_));
+    staged_ = 0;
+    if (header_.magic != kSparseMagic || header_.major_version != 1) {
+        return invalid("cabeçalho desconhecido");
+    }
+    if (header_.file_hdr_sz < sizeof(SparseHeader) || header_.chunk_hdr_sz < sizeof(SparseChunkHeader)) {
+        return invalid("tamanho de cabeçalho inválido");
+    }
+    if (header_.blk_sz == 0 || header_.blk_sz % 4 != 0) {
+        return invalid("tamanho de bloco inválido");
+    }
+    if (expandedSize() > device_.size()) {
+        error_ = "imagem esparsa maior que a partição";
+        return false;
+    }
+    skip_ = header_.file_hdr_sz - sizeof(SparseHeader);
+    state_ = header_.total_chunks == 0 ? State::Done : State::ChunkHeader;
+    return true;
+}
+
+bool SparseImageWriter::onChunkHeader() {
+    std::memcpy(&chunk_, staging_, sizeof(chunk_));
+    staged_ = 0;
+    skip_ = header_.chunk_hdr_sz - sizeof(SparseChunkHeader);
+    if (chunk_.total_sz < header_.chunk_hdr_sz) {
+        return invalid("chunk menor que o cabeçalho");
+    }
+    uint64_t data_sz = chunk_.total_sz - header_.chunk_hdr_sz;
+    uint64_t bytes = static_cast<uint64_t>(chunk_.chunk_sz) * header_.blk_sz;
+
+    if (chunk_.chunk_type != kSparseChunkCrc32) {
+        if (static_cast<uint64_t>(blocks_done_) + chunk_.chunk_sz > header_.total_blks) {
+            return invalid("chunk além do fim da imagem");
+        }
+        blocks_done_ += chunk_.chunk_sz;
+    }
+
+    switch (chunk_.chunk_type) {
+    case kSparseChunkRaw:
+        if (data_sz != bytes) {
+            return invalid("tamanho de chunk RAW incoerente");
+        }
+        raw_left_ = bytes;
+        state_ = State::RawData;
+        break;
+    case kSparseChunkFill:
+        if (data_sz != 4) {
+            return invalid("tamanho de chunk FILL incoerente");
+        }
+        state_ = State::FillValue;
+        return true;
+    case kSparseChunkDontCare:
+        if (data_sz != 0) {
+            return invalid("chunk DONT_CARE com dados");
+        }
+        // Sem I/O: o que já está na partição é mantido
+        crcZeros(bytes);
+        offset_ += bytes;
+        break;
+    case kSparseChunkCrc32:
+        if (data_sz != 4) {
+            return invalid("tamanho de chunk CRC32 incoerente");
+        }
+        state_ = State::CrcValue;
+        return true;
+    default:
+        return invalid("tipo de chunk desconhecido");
+    }
+
+    if (state_ != State::RawData || raw_left_ == 0) {
+        chunks_done_++;
+        state_ = chunks_done_ == header_.total_chunks ? State::Done : State::ChunkHeader;
+    }
+    return true;
+}
+
+bool SparseImageWriter::applyFill(uint32_t value) {
+    uint64_t len = static_cast<uint64_t>(chunk_.chunk_sz) * header_.blk_sz;
+    if (value == 0) {
+        if (!device_.writeZeroes(offset_, len)) {
+            error_ = "falha ao zerar a faixa no dispositivo";
+            return false;
+        }
+        crcZeros(len);
+        offset_ += len;
+        return true;
+    }
+
+    // Padrão não nulo: grava a partir de um buffer preenchido uma única vez
+    static constexpr size_t kPatternBytes = 64 * 1024;
+    std::vector<uint32_t> pattern(kPatternBytes / sizeof(uint32_t), value);
+    while (len > 0) {
+        size_t n = static_cast<size_t>(std::min<uint64_t>(len, kPatternBytes));
+        if (!device_.write(offset_, pattern.data(), n)) {
+            error_ = "falha de escrita no dispositivo";
+            return false;
+        }
+        crc_ = sparseCrc32(crc_, pattern.data(), n);
+        offset_ += n;
+        len -= n;
+    }
+    return true;
+}
+
+bool SparseImageWriter::write(const uint8_t* data, size_t len) {
+    while (len > 0) {
+        if (skip_ > 0) {
+            size_t n = std::min(skip_, len);
+            skip_ -= n;
+            data += n;
+            len -= n;
+            continue;
+        }
+
+        if (state_ == State::RawData) {
+            size_t n = static_cast<size_t>(std::min<uint64_t>(raw_left_, len));
+            if (!device_.write(offset_, data, n)) {
+                error_ = "falha de escrita no dispositivo";
+                return false;
+            }
+            crc_ = sparseCrc32(crc_, data, n);
+            offset_ += n;
+            raw_left_ -= n;
+            data += n;
+            len -= n;
+            if (raw_left_ == 0) {
+                chunks_done_++;
+                state_ = chunks_done_ == header_.total_chunks ? State::Done : State::ChunkHeader;
+            }
+            continue;
+        }
+
+        if (state_ == State::Done) {
+            return invalid("dados após o último chunk");
+        }
+
+        // Cabeçalhos e valores de 4 bytes podem chegar divididos entre blocos
+        size_t need = state_ == State::FileHeader  ? sizeof(SparseHeader)
+                    : state_ == State::ChunkHeader ? sizeof(SparseChunkHeader)
+                                                   : sizeof(uint32_t);
+        size_t n = std::min(need - staged_, len);
+        std::memcpy(staging_ + staged_, data, n);
+        staged_ += n;
+        data += n;
+        len -= n;
+        if (staged_ < need) {
+            break;
+        }
+
+        switch (state_) {
+        case State::FileHeader:
+            if (!onFileHeader()) {
+                return false;
+            }
+            break;
+        case State::ChunkHeader:
+            if (!onChunkHeader()) {
+                return false;
+            }
+            break;
+        case State::FillValue:
+        case State::CrcValue: {
+            uint32_t value;
+            std::memcpy(&value, staging_, sizeof(value));
+            staged_ = 0;
+            if (state_ == State::FillValue) {
+                if (!applyFill(value)) {
+                    return false;
+                }
+            } else if (value != crc_) {
+                return invalid("CRC32 não confere");
+            }
+            chunks_done_++;
+            state_ = chunks_done_ == header_.total_chunks ? State::Done : State::ChunkHeader;
+            break;
+        }
+        default:
+            break;
+        }
+    }
+    return true;
+}
+
+bool SparseImageWriter::finish() {
+    if (state_ != State::Done || skip_ > 0) {
+        return invalid("imagem truncada");
+    }
+    if (blocks_done_ != header_.total_blks) {
+        return invalid("chunks não cobrem a imagem inteira");
+    }
+    if (!device_.flush()) {
+        error_ = "falha ao finalizar a escrita da imagem";
+        return false;
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// AutoImageWriter
+// ---------------------------------------------------------------------------
+
+bool AutoImageWriter::write(const uint8_t* data, size_t len) {
+    if (!impl_) {
+        uint32_t magic = 0;
+        if (len >= sizeof(magic)) {
+            std::memcpy(&magic, data, sizeof(magic));
+        }
+        if (magic == kLz4FrameMagic) {
+            if (!allow_lz4_) {
+                // Descompressão em cascata multiplicaria a expansão sem benefício
+                error_ = "frame LZ4 aninhado em outro frame LZ4";
+                return false;
+            }
+            std::unique_ptr<ImageWriter> inner(new AutoImageWriter(device_, decompress_threads_, false));
+            impl_.reset(new Lz4FrameWriter(std::move(inner), decompress_threads_));
+        } else if (magic == kSparseMagic) {
+            impl_.reset(new SparseImageWriter(device_));
+        } else {
+            impl_.reset(new RawImageWriter(device_));
+        }
+    }
+    return impl_->write(data, len);
+}
+
+bool AutoImageWriter::finish() {
+    if (!impl_) {
+        impl_.reset(new RawImageWriter(device_)); // Imagem vazia
+    }
+    return impl_->finish();
+}
+
+std::string AutoImageWriter::errorMessage() const {
+    if (!error_.empty()) {
+        return error_;
+    }
+    return impl_ ? impl_->errorMessage() : ImageWriter::errorMessage();
+}
+
+// ---------------------------------------------------------------------------
+// Divisão no host
+// ---------------------------------------------------------------------------
+
+namespace {
+
+struct SplitChunk {
+    uint16_t type;          // RAW ou FILL (DONT_CARE vira lacuna)
+    uint32_t start;         // Primeiro bloco
+    uint32_t blocks;
+    const uint8_t* data;    // RAW: conteúdo
+    uint32_t fill;          // FILL: padrão
+};
+
+bool parseSparse(const uint8_t* image, size_t len, uint32_t& blk_sz, uint32_t& total_blks,
+                 std::vector<SplitChunk>& chunks, std::string& error) {
+    SparseHeader hdr;
+    std::memcpy(&hdr, image, sizeof(hdr));
+    if (hdr.major_version != 1 || hdr.file_hdr_sz < sizeof(SparseHeader) ||
+        hdr.chunk_hdr_sz < sizeof(SparseChunkHeader) || hdr.blk_sz == 0 || hdr.blk_sz % 4 != 0) {
+        error = "cabeçalho esparso inválido";
+        return false;
+    }
+    blk_sz = hdr.blk_sz;
+    total_blks = hdr.total_blks;
+
+    size_t pos = hdr.file_hdr_sz;
+    uint64_t block = 0;
+    for (uint32_t i = 0; i < hdr.total_chunks; i++) {
+        SparseChunkHeader ch;
+        if (pos + hdr.chunk_hdr_sz > len) {
+            error = "imagem esparsa truncada";
+            return false;
+        }
+        std::memcpy(&ch, image + pos, sizeof(ch));
+        if (ch.total_sz < hdr.chunk_hdr_sz || pos + ch.total_sz > len) {
+            error = "chunk esparso inválido";
+            return false;
+        }
+        const uint8_t* payload = image + pos + hdr.chunk_hdr_sz;
+        uint64_t data_sz = ch.total_sz - hdr.chunk_hdr_sz;
+        uint64_t bytes = static_cast<uint64_t>(ch.chunk_sz) * blk_sz;
+        if (ch.chunk_type != kSparseChunkCrc32 && block + ch.chunk_sz > total_blks) {
+            error = "chunk além do fim da imagem";
+            return false;
+        }
+
+        switch (ch.chunk_type) {
+        case kSparseChunkRaw:
+            if (data_sz != bytes) {
+                error = "tamanho de chunk RAW incoerente";
+                return false;
+            }
+            chunks.push_back({ kSparseChunkRaw, static_cast<uint32_t>(block), ch.chunk_sz, payload, 0 });
+            break;
+        case kSparseChunkFill: {
+            if (data_sz != 4) {
+                error = "tamanho de chunk FILL incoerente";
+                return false;
+            }
+            uint32_t fill;
+            std::memcpy(&fill, payload, sizeof(fill));
+            chunks.push_back({ kSparseChunkFill, static_cast<uint32_t>(block), ch.chunk_sz, nullptr, fill });
+            break;
+        }
+        case kSparseChunkDontCare:
+        case kSparseChunkCrc32:
+            break;
+        default:
+            error = "tipo de chunk desconhecido";
+            return false;
+        }
+        if (ch.chunk_type != kSparseChunkCrc32) {
+            block += ch.chunk_sz;
+        }
+        pos += ch.total_sz;
+    }
+    return true;
+}
+
+// Bloco formado por um único padrão de 4 bytes repetido?
+bool uniformBlock(const uint8_t* block, uint32_t blk_sz, uint32_t& fill) {
+    std::memcpy(&fill, block, sizeof(fill));
+    for (uint32_t i = 4; i < blk_sz; i += 4) {
+        if (std::memcmp(block, block + i, 4) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void parseRaw(const uint8_t* image, size_t len, uint32_t blk_sz, std::vector<uint8_t>& tail,
+              uint32_t& total_blks, std::vector<SplitChunk>& chunks) {
+    total_blks = static_cast<uint32_t>((len + blk_sz - 1) / blk_sz);
+    if (len % blk_sz != 0) {
+        // Último bloco parcial completado com zeros, como no img2simg
+        size_t tail_start = len - len % blk_sz;
+        tail.assign(blk_sz, 0);
+        std::memcpy(tail.data(), image + tail_start, len - tail_start);
+    }
+
+    for (uint32_t b = 0; b < total_blks; b++) {
+        const uint8_t* block = tail.empty() || b + 1 < total_blks
+                                   ? image + static_cast<size_t>(b) * blk_sz
+                                   : tail.data();
+        uint32_t fill;
+        bool uniform = uniformBlock(block, blk_sz, fill);
+        SplitChunk* last = chunks.empty() ? nullptr : &chunks.back();
+        if (uniform) {
+            if (last && last->type == kSparseChunkFill && last->fill == fill) {
+                last->blocks++;
+            } else {
+                chunks.push_back({ kSparseChunkFill, b, 1, nullptr, fill });
+            }
+        } else if (last && last->type == kSparseChunkRaw && block == last->data + static_cast<size_t>(last->blocks) * blk_sz) {
+            last->blocks++;
+        } else {
+            chunks.push_back({ kSparseChunkRaw, b, 1, block, 0 });
+        }
+    }
+}
+
+void appendBytes(std::vector<uint8_t>& out, const void* data, size_t len) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    out.insert(out.end(), p, p + len);
+}
+
+void appendChunkHeader(std::vector<uint8_t>& out, uint16_t type, uint32_t blocks, uint32_t data_sz) {
+    SparseChunkHeader ch = { type, 0, blocks, static_cast<uint32_t>(sizeof(SparseChunkHeader) + data_sz) };
+    appendBytes(out, &ch, sizeof(ch));
+}
+
+// Monta uma parte com os chunks [first, last], cobrindo a imagem inteira
+std::vector<uint8_t> buildPiece(const std::vector<SplitChunk>& chunks, uint32_t blk_sz, uint32_t total_blks) {
+    std::vector<uint8_t> out(sizeof(SparseHeader));
+    uint32_t count = 0;
+    uint32_t block = 0;
+    for (const SplitChunk& c : chunks) {
+        if (c.start > block) {
+            appendChunkHeader(out, kSparseChunkDontCare, c.start - block, 0);
+            count++;
+        }
+        if (c.type == kSparseChunkRaw) {
+            uint32_t bytes = c.blocks * blk_sz;
+            appendChunkHeader(out, kSparseChunkRaw, c.blocks, bytes);
+            appendBytes(out, c.data, bytes);
+        } else {
+            appendChunkHeader(out, kSparseChunkFill, c.blocks, sizeof(c.fill));
+            appendBytes(out, &c.fill, sizeof(c.fill));
+        }
+        count++;
+        block = c.start + c.blocks;
+    }
+    if (block < total_blks) {
+        appendChunkHeader(out, kSparseChunkDontCare, total_blks - block, 0);
+        count++;
+    }
+
+    SparseHeader hdr = { kSparseMagic, 1, 0, sizeof(SparseHeader), sizeof(SparseChunkHeader),
+                         blk_sz, total_blks, count, 0 };
+    std::memcpy(out.data(), &hdr, sizeof(hdr));
+    return out;
+}
+
+} // namespace
+
+bool splitSparseImage(const uint8_t* image, size_t len, uint64_t max_download_size,
+                      std::vector<std::vector<uint8_t>>& pieces, std::string& error,
+                      uint32_t raw_block_size) {
+    pieces.clear();
+    uint32_t blk_sz = raw_block_size;
+    uint32_t total_blks = 0;
+    std::vector<SplitChunk> chunks;
+    std::vector<uint8_t> tail;
+
+    uint32_t magic = 0;
+    if (len >= sizeof(SparseHeader)) {
+        std::memcpy(&magic, image, sizeof(magic));
+    }
+    if (magic == kSparseMagic) {
+        if (!parseSparse(image, len, blk_sz, total_blks, chunks, error)) {
+            return false;
+        }
+    } else {
+        if (blk_sz == 0 || blk_sz % 4 != 0) {
+            error = "tamanho de bloco inválido";
+            return false;
+        }
+        parseRaw(image, len, blk_sz, tail, total_blks, chunks);
+    }
+
+    // Cabeçalho + DONT_CARE inicial e final reservados em toda parte
+    const uint64_t kChunkHdr = sizeof(SparseChunkHeader);
+    const uint64_t overhead = sizeof(SparseHeader) + 2 * kChunkHdr;
+    if (max_download_size < overhead + kChunkHdr + std::max<uint64_t>(blk_sz, 4)) {
+        error = "max-download-size menor que um bloco da imagem";
+        return false;
+    }
+
+    std::vector<SplitChunk> current;
+    uint64_t used = overhead;
+    auto flushPiece = [&] {
+        pieces.push_back(buildPiece(current, blk_sz, total_blks));
+        current.clear();
+        used = overhead;
+    };
+
+    for (size_t i = 0; i < chunks.size(); i++) {
+        SplitChunk c = chunks[i];
+        while (c.blocks > 0) {
+            // Lacuna interna vira um DONT_CARE a mais
+            bool gap = !current.empty() && current.back().start + current.back().blocks != c.start;
+            uint64_t fixed = kChunkHdr + (gap ? kChunkHdr : 0);
+            uint64_t payload = c.type == kSparseChunkRaw ? static_cast<uint64_t>(c.blocks) * blk_sz : 4;
+
+            if (used + fixed + payload <= max_download_size) {
+                current.push_back(c);
+                used += fixed + payload;
+                break;
+            }
+            if (c.type == kSparseChunkRaw && used + fixed + blk_sz <= max_download_size) {
+                // Divide o RAW no limite de blocos que ainda cabe
+                uint32_t fit = static_cast<uint32_t>((max_download_size - used - fixed) / blk_sz);
+                SplitChunk head = c;
+                head.blocks = fit;
+                current.push_back(head);
+                c.start += fit;
+                c.blocks -= fit;
+                c.data += static_cast<size_t>(fit) * blk_sz;
+            }
+            flushPiece();
+        }
+    }
+    if (!current.empty() || pieces.empty()) {
+        flushPiece();
+    }
+    return true;
+}
+
+} // namespace arcanos::fastboot
@@ -0,0 +1,130 @@
+#ifndef ARCANOS_FASTBOOT_SPARSE_IMAGE_H
+#define ARCANOS_FASTBOOT_SPARSE_IMAGE_H
+
+#include "block_device.h"
+#include "flash_pipeline.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace arcanos::fastboot {
+
+// Formato de imagem esparsa do Android (libsparse), little-endian
+constexpr uint32_t kSparseMagic = 0xED26FF3A;
+constexpr uint16_t kSparseChunkRaw = 0xCAC1;
+constexpr uint16_t kSparseChunkFill = 0xCAC2;
+constexpr uint16_t kSparseChunkDontCare = 0xCAC3;
+constexpr uint16_t kSparseChunkCrc32 = 0xCAC4;
+
+struct SparseHeader {
+    uint32_t magic;
+    uint16_t major_version;
+    uint16_t minor_version;
+    uint16_t file_hdr_sz;
+    uint16_t chunk_hdr_sz;
+    uint32_t blk_sz;
+    uint32_t total_blks;
+    uint32_t total_chunks;
+    uint32_t image_checksum;
+};
+static_assert(sizeof(SparseHeader) == 28, "cabeçalho esparso deve ter 28 bytes");
+
+struct SparseChunkHeader {
+    uint16_t chunk_type;
+    uint16_t reserved;
+    uint32_t chunk_sz; // Em blocos da imagem expandida
+    uint32_t total_sz; // Em bytes, incluindo este cabeçalho
+};
+static_assert(sizeof(SparseChunkHeader) == 12, "cabeçalho de chunk deve ter 12 bytes");
+
+// CRC-32 (polinômio 0xEDB88320), o mesmo usado nos chunks CRC32
+uint32_t sparseCrc32(uint32_t crc, const void* data, size_t len);
+
+/**
+ * @brief Aplica uma imagem esparsa recebida em streaming, sem expandi-la em memória.
+ *
+ * RAW é gravado direto do buffer recebido; FILL com padrão zero vira
+ * BlockDevice::writeZeroes; DONT_CARE não gera I/O (o conteúdo anterior é
+ * mantido, o que permite gravar uma imagem dividida em várias partes);
+ * CRC32 confere o CRC da imagem expandida até aquele ponto.
+ */
+class SparseImageWriter : public ImageWriter {
+public:
+    explicit SparseImageWriter(BlockDevice& device) : device_(device) {}
+
+    bool write(const uint8_t* data, size_t len) override;
+    bool finish() override;
+    std::string errorMessage() const override { return error_; }
+
+    // Tamanho da imagem expandida (válido depois do cabeçalho)
+    uint64_t expandedSize() const { return static_cast<uint64_t>(header_.blk_sz) * header_.total_blks; }
+
+private:
+    enum class State { FileHeader, ChunkHeader, RawData, FillValue, CrcValue, Done };
+
+    bool invalid(const char* message);
+    bool onFileHeader();
+    bool onChunkHeader();
+    bool applyFill(uint32_t value);
+    void crcZeros(uint64_t len);
+
+    BlockDevice& device_;
+    State state_ = State::FileHeader;
+    SparseHeader header_ = {};
+    SparseChunkHeader chunk_ = {};
+
+    // Bytes de cabeçalho/valor acumulados entre chamadas de write()
+    uint8_t staging_[sizeof(SparseHeader)];
+    size_t staged_ = 0;
+    size_t skip_ = 0;       // Bytes extras de cabeçalho a descartar
+    uint64_t raw_left_ = 0; // Bytes restantes do chunk RAW atual
+
+    uint64_t offset_ = 0;   // Posição de escrita na partição
+    uint32_t blocks_done_ = 0;
+    uint32_t chunks_done_ = 0;
+    uint32_t crc_ = 0;
+    std::string error_;
+};
+
+/**
+ * @brief Escolhe o formato pelo início da imagem: frame LZ4 (download
+ * comprimido, cujo conteúdo passa de novo por esta detecção), esparsa ou crua.
+ * Só o primeiro nível pode ser LZ4: um frame LZ4 dentro de outro é rejeitado.
+ */
+class AutoImageWriter : public ImageWriter {
+public:
+    explicit AutoImageWriter(BlockDevice& device, size_t decompress_threads = 0, bool allow_lz4 = true)
+        : device_(device), decompress_threads_(decompress_threads), allow_lz4_(allow_lz4) {}
+
+    bool write(const uint8_t* data, size_t len) override;
+    bool finish() override;
+    std::string errorMessage() const override;
+
+private:
+    BlockDevice& device_;
+    size_t decompress_threads_;
+    bool allow_lz4_;
+    std::string error_;
+    std::unique_ptr<ImageWriter> impl_;
+};
+
+/**
+ * @brief (Host) Divide uma imagem em imagens esparsas de até 'max_download_size' bytes.
+ *
+ * Cada parte cobre o tamanho total da imagem, com DONT_CARE fora do seu
+ * trecho, e pode ser enviada com um "flash" separado. Uma imagem crua é
+ * convertida antes (blocos de padrão repetido viram FILL). Chunks CRC32 são
+ * descartados, pois cobrem a imagem inteira.
+ */
+bool splitSparseImage(const uint8_t* image, size_t len, uint64_t max_download_size,
+                      std::vector<std::vector<uint8_t>>& pieces, std::string& error,
+                      uint32_t raw_block_size = 4096);
+
+// Autoteste da divisão e aplicação de imagens esparsas (sparse_image_test.cc)
+int sparse_run_selftest();
+
+} // namespace arcanos::fastboot
+
+#endif // ARCANOS_FASTBOOT_SPARSE_IMAGE_H
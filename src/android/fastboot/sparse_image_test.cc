@@ -0,0 +1,196 @@
+//
+// Autoteste das imagens esparsas: divisão no host e aplicação no dispositivo.
+// Arquivo: src/android/fastboot/sparse_image_test.cc
+//
+
+#include "sparse_image.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace arcanos::fastboot {
+
+namespace {
+
+constexpr uint32_t kBlock = 4096;
+constexpr uint8_t kUnwritten = 0xAA; // Conteúdo da partição antes do flash
+
+// Partição em memória
+class MemoryBlockDevice : public BlockDevice {
+public:
+    explicit MemoryBlockDevice(size_t size) : data(size, kUnwritten) {}
+
+    bool write(uint64_t offset, const void* src, size_t len) override {
+        if (offset + len > data.size()) {
+            return false;
+        }
+        std::memcpy(data.data() + offset, src, len);
+        return true;
+    }
+    bool flush() override { return true; }
+    uint64_t size() const override { return data.size(); }
+
+    std::vector<uint8_t> data;
+};
+
+// Entrega 'piece' ao escritor em pedaços de 'step' bytes (cabeçalhos divididos
+// entre chamadas, como chegam do pipeline) e finaliza
+bool applyPiece(SparseImageWriter& writer, const std::vector<uint8_t>& piece, size_t step) {
+    for (size_t pos = 0; pos < piece.size(); pos += step) {
+        if (!writer.write(piece.data() + pos, std::min(step, piece.size() - pos))) {
+            return false;
+        }
+    }
+    return writer.finish();
+}
+
+void appendBytes(std::vector<uint8_t>& out, const void* data, size_t len) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    out.insert(out.end(), p, p + len);
+}
+
+void appendChunk(std::vector<uint8_t>& out, uint16_t type, uint32_t blocks, const void* data, uint32_t data_sz) {
+    SparseChunkHeader ch = { type, 0, blocks, static_cast<uint32_t>(sizeof(SparseChunkHeader) + data_sz) };
+    appendBytes(out, &ch, sizeof(ch));
+    appendBytes(out, data, data_sz);
+}
+
+// Imagem esparsa com RAW (1 bloco), FILL zero (2), DONT_CARE (1) e um chunk
+// CRC32 final com o valor 'crc'
+std::vector<uint8_t> crcImage(const std::vector<uint8_t>& raw_block, uint32_t crc) {
+    std::vector<uint8_t> out;
+    SparseHeader hdr = { kSparseMagic, 1, 0, sizeof(SparseHeader), sizeof(SparseChunkHeader),
+                         kBlock, 4, 4, 0 };
+    appendBytes(out, &hdr, sizeof(hdr));
+    appendChunk(out, kSparseChunkRaw, 1, raw_block.data(), kBlock);
+    uint32_t zero = 0;
+    appendChunk(out, kSparseChunkFill, 2, &zero, sizeof(zero));
+    appendChunk(out, kSparseChunkDontCare, 1, nullptr, 0);
+    appendChunk(out, kSparseChunkCrc32, 0, &crc, sizeof(crc));
+    return out;
+}
+
+} // namespace
+
+/**
+ * @brief Divide imagens com splitSparseImage e aplica as partes com
+ * SparseImageWriter: o resultado deve ser a imagem original, e cada parte deve
+ * caber no max-download-size. Confere também o chunk CRC32 (aceito quando
+ * confere, rejeitado quando não) e a rejeição de uma parte truncada.
+ * @return 0 se o teste for bem-sucedido, 1 caso contrário.
+ */
+int sparse_run_selftest() {
+    std::printf("--- ARCANOS SPARSE IMAGE: SELF-TEST ---\n");
+
+    // Imagem crua com trechos RAW, zero, padrão repetido e um bloco final parcial
+    const size_t len = 96 * kBlock + 1000;
+    std::vector<uint8_t> image(len, 0);
+    uint32_t rnd = 0x2545F491u;
+    for (size_t i = 0; i < len; i++) {
+        size_t block = i / kBlock;
+        if (block < 30 || (block >= 60 && block < 70) || block >= 90) {
+            rnd = rnd * 1103515245u + 12345u;
+            image[i] = static_cast<uint8_t>(rnd >> 16);
+        } else if (block >= 45 && block < 60) {
+            image[i] = static_cast<uint8_t>("ARC!"[i % 4]);
+        }
+    }
+    std::vector<uint8_t> expected = image;
+    expected.resize(97 * kBlock, 0); // Último bloco completado com zeros
+
+    // 1. Divisão em várias partes e ida e volta, com limites de tamanhos diferentes
+    for (uint64_t max_download : { uint64_t(64 * 1024), uint64_t(100 * 1024 + 7), uint64_t(1) << 30 }) {
+        std::vector<std::vector<uint8_t>> pieces;
+        std::string error;
+        if (!splitSparseImage(image.data(), image.size(), max_download, pieces, error, kBlock)) {
+            std::printf("TEST FAILED: splitSparseImage recusou a imagem: %s\n", error.c_str());
+            return 1;
+        }
+        MemoryBlockDevice device(expected.size());
+        for (const std::vector<uint8_t>& piece : pieces) {
+            SparseImageWriter writer(device);
+            if (piece.size() > max_download || !applyPiece(writer, piece, 777)) {
+                std::printf("TEST FAILED: Parte de %zu bytes (limite %llu): %s\n", piece.size(),
+                            static_cast<unsigned long long>(max_download), writer.errorMessage().c_str());
+                return 1;
+            }
+        }
+        if (device.data != expected) {
+            std::printf("TEST FAILED: Imagem reconstruida difere (%zu partes).\n", pieces.size());
+            return 1;
+        }
+        if (max_download < 100 * 1024 && pieces.size() < 3) {
+            std::printf("TEST FAILED: Limite de %llu bytes gerou so %zu partes.\n",
+                        static_cast<unsigned long long>(max_download), pieces.size());
+            return 1;
+        }
+    }
+
+    // 2. Imagem já esparsa: uma parte única é dividida de novo
+    std::vector<std::vector<uint8_t>> whole, again;
+    std::string error;
+    if (!splitSparseImage(image.data(), image.size(), uint64_t(1) << 30, whole, error, kBlock) ||
+        !splitSparseImage(whole[0].data(), whole[0].size(), 80 * 1024, again, error)) {
+        std::printf("TEST FAILED: Nova divisao da imagem esparsa falhou: %s\n", error.c_str());
+        return 1;
+    }
+    MemoryBlockDevice resplit(expected.size());
+    for (const std::vector<uint8_t>& piece : again) {
+        SparseImageWriter writer(resplit);
+        if (!applyPiece(writer, piece, 4096)) {
+            std::printf("TEST FAILED: Parte redividida recusada: %s\n", writer.errorMessage().c_str());
+            return 1;
+        }
+    }
+    if (resplit.data != expected) {
+        std::printf("TEST FAILED: Imagem redividida difere da original.\n");
+        return 1;
+    }
+
+    // 3. CRC32: DONT_CARE conta como zeros no CRC da imagem expandida
+    std::vector<uint8_t> raw_block(image.begin(), image.begin() + kBlock);
+    std::vector<uint8_t> expanded(4 * kBlock, 0);
+    std::memcpy(expanded.data(), raw_block.data(), kBlock);
+    uint32_t crc = sparseCrc32(0, expanded.data(), expanded.size());
+    {
+        MemoryBlockDevice device(4 * kBlock);
+        SparseImageWriter writer(device);
+        if (!applyPiece(writer, crcImage(raw_block, crc), 5)) {
+            std::printf("TEST FAILED: CRC32 correto recusado: %s\n", writer.errorMessage().c_str());
+            return 1;
+        }
+    }
+    {
+        MemoryBlockDevice device(4 * kBlock);
+        SparseImageWriter writer(device);
+        if (applyPiece(writer, crcImage(raw_block, crc ^ 1), 5) ||
+            writer.errorMessage().find("CRC32") == std::string::npos) {
+            std::printf("TEST FAILED: CRC32 errado nao foi rejeitado.\n");
+            return 1;
+        }
+    }
+
+    // 4. Parte truncada não é aceita
+    {
+        std::vector<uint8_t> truncated = whole[0];
+        truncated.resize(truncated.size() - 100);
+        MemoryBlockDevice device(expected.size());
+        SparseImageWriter writer(device);
+        if (applyPiece(writer, truncated, 65536)) {
+            std::printf("TEST FAILED: Imagem truncada foi aceita.\n");
+            return 1;
+        }
+    }
+
+    std::printf("--- ARCANOS SPARSE IMAGE: TESTE BEM-SUCEDIDO ---\n");
+    return 0;
+}
+
+} // namespace arcanos::fastboot
+
+// Opcional: Função main simulada para execução direta do teste
+/*
+int main() {
+    return arcanos::fastboot::sparse_run_selftest();
+}
+*/
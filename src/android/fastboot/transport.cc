@@ -0,0 +1,150 @@
+//
+// Transportes do serviço Fastboot (USB, socket local, loopback).
+// Arquivo: src/android/fastboot/transport.cc
+//
+
+#include "transport.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <unistd.h>
+
+namespace arcanos::fastboot {
+
+bool FastbootTransport::readFully(void* buf, size_t len) {
+    uint8_t* p = static_cast<uint8_t*>(buf);
+    while (len > 0) {
+        ssize_t n = read(p, len);
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool FastbootTransport::writeAll(const void* buf, size_t len) {
+    const uint8_t* p = static_cast<const uint8_t*>(buf);
+    while (len > 0) {
+        ssize_t n = write(p, len);
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// -------------------------------------------------------
+// FdTransport
+// -------------------------------------------------------
+
+ssize_t FdTransport::read(void* buf, size_t len) {
+    for (;;) {
+        ssize_t n = ::read(fd_, buf, len);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        return n;
+    }
+}
+
+ssize_t FdTransport::write(const void* buf, size_t len) {
+    for (;;) {
+        ssize_t n = ::write(fd_, buf, len);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        return n;
+    }
+}
+
+void FdTransport::close() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+// -------------------------------------------------------
+// LoopbackTransport
+// -------------------------------------------------------
+
+std::pair<std::unique_ptr<LoopbackTransport>, std::unique_ptr<LoopbackTransport>>
+LoopbackTransport::createPair(size_t capacity) {
+    auto a_to_b = std::make_shared<Pipe>(capacity);
+    auto b_to_a = std::make_shared<Pipe>(capacity);
+    std::unique_ptr<LoopbackTransport> a(new LoopbackTransport(b_to_a, a_to_b));
+    std::unique_ptr<LoopbackTransport> b(new LoopbackTransport(a_to_b, b_to_a));
+    return {std::move(a), std::move(b)};
+}
+
+ssize_t LoopbackTransport::read(void* buf, size_t len) {
+    Pipe& p = *in_;
+    std::unique_lock<std::mutex> lock(p.lock);
+    p.readable.wait(lock, [&] { return p.count > 0 || p.closed; });
+    if (p.count == 0) {
+        return 0; // Fechado e vazio
+    }
+
+    size_t cap = p.data.size();
+    size_t n = std::min(len, p.count);
+    size_t first = std::min(n, cap - p.head);
+    std::memcpy(buf, &p.data[p.head], first);
+    std::memcpy(static_cast<uint8_t*>(buf) + first, &p.data[0], n - first);
+    p.head = (p.head + n) % cap;
+    p.count -= n;
+    p.writable.notify_one();
+    return static_cast<ssize_t>(n);
+}
+
+ssize_t LoopbackTransport::write(const void* buf, size_t len) {
+    Pipe& p = *out_;
+    std::unique_lock<std::mutex> lock(p.lock);
+    size_t cap = p.data.size();
+    p.writable.wait(lock, [&] { return p.count < cap || p.closed; });
+    if (p.closed) {
+        return -1;
+    }
+
+    size_t n = std::min(len, cap - p.count);
+    size_t tail = (p.head + p.count) % cap;
+    size_t first = std::min(n, cap - tail);
+    std::memcpy(&p.data[tail], buf, first);
+    std::memcpy(&p.data[0], static_cast<const uint8_t*>(buf) + first, n - first);
+    p.count += n;
+    p.readable.notify_one();
+    return static_cast<ssize_t>(n);
+}
+
+void LoopbackTransport::close() {
+    for (Pipe* p : {in_.get(), out_.get()}) {
+        std::lock_guard<std::mutex> lock(p->lock);
+        p->closed = true;
+        p->readable.notify_all();
+        p->writable.notify_all();
+    }
+}
+
+// -------------------------------------------------------
+// SimulatedUsbTransport
+// -------------------------------------------------------
+
+ssize_t SimulatedUsbTransport::read(void* buf, size_t len) {
+    // Simula uma resposta de status de Fastboot
+    static const char kResponse[] = "INFO: OKAY [1.0s] - Comando concluído.";
+    size_t n = std::min(len, sizeof(kResponse) - 1);
+    std::memcpy(buf, kResponse, n);
+    return static_cast<ssize_t>(n);
+}
+
+ssize_t SimulatedUsbTransport::write(const void* buf, size_t len) {
+    std::cout << "FastbootService: Enviando: "
+              << std::string(static_cast<const char*>(buf), len) << std::endl;
+    return static_cast<ssize_t>(len);
+}
+
+} // namespace arcanos::fastboot
@@ -0,0 +1,93 @@
+#ifndef ARCANOS_FASTBOOT_TRANSPORT_H
+#define ARCANOS_FASTBOOT_TRANSPORT_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+#include <utility>
+#include <vector>
+
+namespace arcanos::fastboot {
+
+/**
+ * @brief Canal de bytes entre host e dispositivo Fastboot.
+ * USB em produção; socket local ou loopback em memória nos testes.
+ */
+class FastbootTransport {
+public:
+    virtual ~FastbootTransport() = default;
+
+    // Lê até 'len' bytes. Retorna os bytes lidos, 0 no fim do fluxo, -1 em erro.
+    virtual ssize_t read(void* buf, size_t len) = 0;
+
+    // Escreve até 'len' bytes. Retorna os bytes escritos ou -1 em erro.
+    virtual ssize_t write(const void* buf, size_t len) = 0;
+
+    virtual void close() {}
+
+    // Repetem read()/write() até completar (false em erro ou fim prematuro)
+    bool readFully(void* buf, size_t len);
+    bool writeAll(const void* buf, size_t len);
+    bool writeString(const std::string& s) { return writeAll(s.data(), s.size()); }
+};
+
+// Descritor de arquivo: socket local (socketpair/AF_UNIX), pipe ou endpoint FunctionFS
+class FdTransport : public FastbootTransport {
+public:
+    // Assume a posse do descritor
+    explicit FdTransport(int fd) : fd_(fd) {}
+    ~FdTransport() override { close(); }
+
+    ssize_t read(void* buf, size_t len) override;
+    ssize_t write(const void* buf, size_t len) override;
+    void close() override;
+
+private:
+    int fd_;
+};
+
+// Par de extremidades ligadas por buffers em memória (sem syscalls)
+class LoopbackTransport : public FastbootTransport {
+public:
+    static std::pair<std::unique_ptr<LoopbackTransport>, std::unique_ptr<LoopbackTransport>>
+    createPair(size_t capacity = 4 * 1024 * 1024);
+
+    ssize_t read(void* buf, size_t len) override;
+    ssize_t write(const void* buf, size_t len) override;
+    void close() override;
+
+private:
+    // Anel de bytes de um sentido da conexão
+    struct Pipe {
+        explicit Pipe(size_t capacity) : data(capacity) {}
+        std::mutex lock;
+        std::condition_variable readable;
+        std::condition_variable writable;
+        std::vector<uint8_t> data;
+        size_t head = 0;   // Próximo byte a ler
+        size_t count = 0;  // Bytes pendentes
+        bool closed = false;
+    };
+
+    LoopbackTransport(std::shared_ptr<Pipe> in, std::shared_ptr<Pipe> out)
+        : in_(std::move(in)), out_(std::move(out)) {}
+
+    std::shared_ptr<Pipe> in_;
+    std::shared_ptr<Pipe> out_;
+};
+
+// USB simulado (comportamento original do serviço: registra o que é enviado e
+// responde OKAY a cada comando)
+class SimulatedUsbTransport : public FastbootTransport {
+public:
+    ssize_t read(void* buf, size_t len) override;
+    ssize_t write(const void* buf, size_t len) override;
+};
+
+} // namespace arcanos::fastboot
+
+#endif // ARCANOS_FASTBOOT_TRANSPORT_H
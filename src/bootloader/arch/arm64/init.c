@@ -2,6 +2,20 @@
 // Funções de inicialização específicas para arquitetura ARM64 (Celulares)
 
 #include "../../libbootloader/mem.h" // Funções de memória
+#include "../../libbootloader/smp.h" // Bring-up dos núcleos secundários
+#include "../../libbootloader/paging.h" // Tabelas de página do boot
+
+static BlPageTableBuilder boot_pt;
+
+// Libera FP/SIMD no BSP (CPACR_EL1.FPEN = 0b11). O firmware pode deixar o acesso
+// em trap e bl_memset/bl_memcpy usam NEON depois de bl_mem_init() (os
+// secundários fazem o mesmo no stub de entrada).
+static void arch_enable_fpsimd(void) {
+    uint64_t cpacr;
+    __asm__ volatile("mrs %0, cpacr_el1" : "=r"(cpacr));
+    cpacr |= (3ull << 20);
+    __asm__ volatile("msr cpacr_el1, %0\n\tisb" : : "r"(cpacr) : "memory");
+}
 
 /**
  * @brief Ponto de entrada do bootloader para ARM64.
@@ -10,17 +24,35 @@
  * 2. Inicializar o mapeamento de memória (MMU) e paginação.
  * 3. Configurar a porta serial/console para debug (UART).
  * 4. Chamar o carregador de Kernel.
+ * @param info Mapa de memória e região do ramdisk (NULL = mantém as tabelas do firmware).
  */
-void arch_init_arm64() {
-    // 1. Configurar Paging / MMU
-    // ... Código de baixo nível de Assembly/C ...
+void arch_init_arm64(ArcBootInfo *info) {
+    // 0. FP/SIMD antes de qualquer código que possa usar NEON
+    arch_enable_fpsimd();
+
+    // 1. Configurar Paging / MMU: mapa identidade com blocos de 1 GiB / 2 MiB
+    // (4 KiB só nas bordas). Os secundários copiam MAIR/TCR/TTBR0 do BSP.
+    // Sem mapa de memória (ou se a construção falhar) a MMU fica como o firmware deixou.
+    if (info != NULL && bl_pt_init(&boot_pt, BL_PT_FORMAT_ARM64, NULL, NULL) &&
+        bl_pt_build_boot_tables(&boot_pt, info, BL_PT_KERNEL_WINDOW)) {
+        bl_pt_activate(&boot_pt);
+    }
 
     // 2. Inicializar I/O (para debug)
     // ... Código para configurar o UART ...
     
     // 3. Limpar BSS e Pilha
+    bl_mem_init(); // Seleciona as variantes otimizadas de bl_memset/bl_memcpy
     // bl_memset(...); 
 
+    // 3.1. Acordar os demais núcleos (ficam ociosos esperando trabalho).
+    // Tarefas grandes do boot (zerar memória, tabelas de página, hashing,
+    // descompressão) podem usar bl_smp_run_on_all() / bl_smp_memset() daqui em diante.
+    bl_smp_init();
+    if (info != NULL) {
+        bl_smp_publish(info); // O executor de init do kernel reaproveita os APs
+    }
+
     // 4. Chamar o carregador principal (Core Loader)
     // core_loader_load_kernel(); 
 }
@@ -0,0 +1,114 @@
+// src/bootloader/arch/arm64/smp.c
+// Bring-up dos núcleos secundários (ARM64) via PSCI CPU_ON.
+
+#include "../../libbootloader/smp.h"
+
+// Conduit do PSCI: SMC por padrão; firmwares sob hypervisor usam HVC.
+#ifndef CONFIG_PSCI_USE_HVC
+#define PSCI_CONDUIT "smc #0"
+#else
+#define PSCI_CONDUIT "hvc #0"
+#endif
+
+#define PSCI_CPU_ON_64          0xC4000003u
+#define PSCI_SUCCESS            0
+#define PSCI_ALREADY_ON         (-4)
+
+// Candidatos a MPIDR sondados (Aff1 = cluster, Aff0 = núcleo), sem device tree
+#define SMP_MAX_CLUSTERS        4
+#define SMP_MAX_CORES_PER_CLUSTER 16
+#define MPIDR_AFFINITY_MASK     0xFF00FFFFFFull
+
+// Lidos pelo stub de entrada com MMU e caches desligados: o BSP os limpa até o PoC.
+uint64_t bl_arm64_ap_stack_tops[BL_MAX_CPUS];
+uint64_t bl_arm64_ap_sysregs[4]; // MAIR_EL1, TCR_EL1, TTBR0_EL1, SCTLR_EL1
+
+// Entrada dos secundários (x0 = context_id = índice da CPU). Liga FP/SIMD,
+// reaproveita a configuração de MMU do BSP, monta a pilha e chama bl_smp_ap_entry.
+__asm__(
+    ".section .text\n"
+    ".balign 8\n"
+    ".global bl_arm64_secondary_entry\n"
+    "bl_arm64_secondary_entry:\n"
+    "    mov x19, x0\n"
+    "    mov x1, #(3 << 20)\n"           // CPACR_EL1.FPEN = 0b11
+    "    msr cpacr_el1, x1\n"
+    "    isb\n"
+    "    adrp x1, bl_arm64_ap_sysregs\n"
+    "    add x1, x1, :lo12:bl_arm64_ap_sysregs\n"
+    "    ldr x4, [x1, #24]\n"             // SCTLR do BSP
+    "    tbz x4, #0, 1f\n"                // MMU desligada no BSP: segue sem MMU
+    "    ldr x2, [x1, #0]\n"
+    "    msr mair_el1, x2\n"
+    "    ldr x2, [x1, #8]\n"
+    "    msr tcr_el1, x2\n"
+    "    ldr x2, [x1, #16]\n"
+    "    msr ttbr0_el1, x2\n"
+    "    isb\n"
+    "    tlbi vmalle1\n"
+    "    dsb nsh\n"
+    "    isb\n"
+    "    msr sctlr_el1, x4\n"
+    "    isb\n"
+    "1:  adrp x1, bl_arm64_ap_stack_tops\n"
+    "    add x1, x1, :lo12:bl_arm64_ap_stack_tops\n"
+    "    ldr x2, [x1, x19, lsl #3]\n"
+    "    mov sp, x2\n"
+    "    mov x0, x19\n"
+    "    bl bl_smp_ap_entry\n"
+    "2:  wfe\n"
+    "    b 2b\n"
+    ".previous\n"
+);
+extern void bl_arm64_secondary_entry(void);
+
+static int64_t psci_cpu_on(uint64_t mpidr, uint64_t entry, uint64_t context_id) {
+    register uint64_t x0 __asm__("x0") = PSCI_CPU_ON_64;
+    register uint64_t x1 __asm__("x1") = mpidr;
+    register uint64_t x2 __asm__("x2") = entry;
+    register uint64_t x3 __asm__("x3") = context_id;
+    __asm__ volatile(PSCI_CONDUIT : "+r"(x0) : "r"(x1), "r"(x2), "r"(x3) : "memory");
+    return (int64_t)x0;
+}
+
+// Limpa um objeto até o ponto de coerência (o AP começa com caches desligados)
+static void dcache_clean_poc(const void *addr, size_t size) {
+    for (uintptr_t p = (uintptr_t)addr & ~63ull; p < (uintptr_t)addr + size; p += 64) {
+        __asm__ volatile("dc cvac, %0" : : "r"(p) : "memory");
+    }
+    __asm__ volatile("dsb sy" : : : "memory");
+}
+
+uint32_t arch_smp_start_aps(uint8_t *stacks, size_t stack_size, uint32_t max_cpus) {
+    uint64_t self;
+    __asm__ volatile("mrs %0, mpidr_el1" : "=r"(self));
+    self &= MPIDR_AFFINITY_MASK;
+
+    __asm__ volatile("mrs %0, mair_el1" : "=r"(bl_arm64_ap_sysregs[0]));
+    __asm__ volatile("mrs %0, tcr_el1" : "=r"(bl_arm64_ap_sysregs[1]));
+    __asm__ volatile("mrs %0, ttbr0_el1" : "=r"(bl_arm64_ap_sysregs[2]));
+    __asm__ volatile("mrs %0, sctlr_el1" : "=r"(bl_arm64_ap_sysregs[3]));
+    for (uint32_t cpu = 1; cpu < max_cpus; cpu++) {
+        bl_arm64_ap_stack_tops[cpu] = (uint64_t)(uintptr_t)(stacks + (cpu + 1) * stack_size);
+    }
+    dcache_clean_poc(bl_arm64_ap_sysregs, sizeof(bl_arm64_ap_sysregs));
+    dcache_clean_poc(bl_arm64_ap_stack_tops, sizeof(bl_arm64_ap_stack_tops));
+
+    // Sonda os MPIDRs candidatos; os inexistentes retornam erro e são ignorados.
+    uint32_t next = 1;
+    for (uint64_t cluster = 0; cluster < SMP_MAX_CLUSTERS; cluster++) {
+        for (uint64_t core = 0; core < SMP_MAX_CORES_PER_CLUSTER && next < max_cpus; core++) {
+            uint64_t mpidr = (cluster << 8) | core;
+            if (mpidr == self) {
+                continue;
+            }
+            int64_t ret = psci_cpu_on(mpidr, (uint64_t)(uintptr_t)bl_arm64_secondary_entry, next);
+            if (ret == PSCI_SUCCESS) {
+                next++;
+            } else if (ret != PSCI_ALREADY_ON && core == 0 && cluster > 0) {
+                break; // Cluster inexistente
+            }
+        }
+    }
+    return next - 1;
+}
@@ -0,0 +1,96 @@
+; ap_trampoline.asm - trampolim dos APs x86_64 (real mode -> long mode)
+; Assemble: nasm -f bin ap_trampoline.asm -o ap_trampoline.bin
+;
+; O BSP copia este binário para AP_TRAMPOLINE_ADDR (abaixo de 1 MiB, alinhado a
+; 4 KiB; vetor do SIPI = endereço >> 12), preenche o bloco de parâmetros no
+; offset 8 (ver ApTrampolineParams em smp.c) e envia INIT-SIPI-SIPI.
+; Cada AP pega um índice com 'lock xadd', monta sua pilha e chama
+; entry(índice) -> bl_smp_ap_entry.
+
+[BITS 16]
+[ORG 0x8000]
+
+ap_start:
+    jmp short ap_real
+    times 8-($-$$) db 0
+
+; Bloco de parâmetros (preenchido pelo BSP)
+param_cr3        dd 0        ; CR3 do BSP (tabelas abaixo de 4 GiB)
+param_next_cpu   dd 1        ; Próximo índice livre (0 = BSP)
+param_max_cpus   dd 0
+param_reserved   dd 0
+param_entry      dq 0        ; void entry(uint32_t cpu)
+param_stack_base dq 0        ; Topo da pilha da CPU n = base + (n + 1) * size
+param_stack_size dq 0
+
+ap_real:
+    cli
+    cld
+    xor ax, ax
+    mov ds, ax
+    lgdt [tramp_gdt_ptr]
+    mov eax, cr0
+    or eax, 1                 ; PE
+    mov cr0, eax
+    jmp 0x08:ap_pm32
+
+[BITS 32]
+ap_pm32:
+    mov ax, 0x10
+    mov ds, ax
+    mov es, ax
+    mov ss, ax
+
+    mov eax, cr4
+    or eax, (1 << 5) | (1 << 9) | (1 << 10)   ; PAE | OSFXSR | OSXMMEXCPT (SSE em bl_memset)
+    mov cr4, eax
+    mov eax, [param_cr3]
+    mov cr3, eax
+
+    mov ecx, 0xC0000080       ; IA32_EFER
+    rdmsr
+    or eax, (1 << 8) | (1 << 11)  ; LME | NXE (as tabelas do BSP usam o bit NX)
+    wrmsr
+
+    mov eax, cr0
+    and eax, ~(1 << 2)        ; EM = 0
+    or eax, (1 << 31) | (1 << 1)  ; PG | MP
+    mov cr0, eax
+    jmp 0x18:ap_lm64
+
+[BITS 64]
+ap_lm64:
+    xor ax, ax
+    mov ds, ax
+    mov es, ax
+    mov ss, ax
+
+    mov eax, 1
+    lock xadd [rel param_next_cpu], eax
+    cmp eax, [rel param_max_cpus]
+    jae .park                 ; Mais CPUs do que o suportado: fica parado
+
+    mov edi, eax              ; 1º argumento (SysV): índice da CPU
+    lea rax, [rax + 1]
+    imul rax, [rel param_stack_size]
+    add rax, [rel param_stack_base]
+    mov rsp, rax
+    mov rax, [rel param_entry]
+    call rax
+
+.park:
+    cli
+    hlt
+    jmp .park
+
+align 8
+tramp_gdt:
+    dq 0
+    dq 0x00CF9A000000FFFF     ; 0x08: código 32 bits
+    dq 0x00CF92000000FFFF     ; 0x10: dados
+    dq 0x00AF9A000000FFFF     ; 0x18: código 64 bits (L = 1)
+tramp_gdt_end:
+
+tramp_gdt_ptr:
+    dw tramp_gdt_end - tramp_gdt - 1
+    dd tramp_gdt
@@ -2,6 +2,23 @@
 // Funções de inicialização específicas para arquitetura x86_64 (Servidores)
 
 #include "../../libbootloader/mem.h" // Funções de memória
+#include "../../libbootloader/smp.h" // Bring-up dos núcleos secundários
+#include "../../libbootloader/paging.h" // Tabelas de página do boot
+
+static BlPageTableBuilder boot_pt;
+
+// Habilita SSE no BSP: CR0.EM = 0, CR0.MP = 1, CR4.OSFXSR | CR4.OSXMMEXCPT.
+// O firmware não garante esses bits e bl_memset/bl_memcpy usam SSE2 depois de
+// bl_mem_init() (os APs fazem o mesmo no trampolim).
+static void arch_enable_sse(void) {
+    uint64_t cr0, cr4;
+    __asm__ volatile("mov %%cr0, %0" : "=r"(cr0));
+    cr0 = (cr0 & ~(1ull << 2)) | (1ull << 1);
+    __asm__ volatile("mov %0, %%cr0" : : "r"(cr0));
+    __asm__ volatile("mov %%cr4, %0" : "=r"(cr4));
+    cr4 |= (1ull << 9) | (1ull << 10);
+    __asm__ volatile("mov %0, %%cr4" : : "r"(cr4));
+}
 
 /**
  * @brief Ponto de entrada do bootloader para x86_64.
@@ -11,8 +28,9 @@
  * 3. Configurar tabelas GDT/IDT.
  * 4. Inicializar o mapeamento de memória (Paging) e configurar ACPI/APIC.
  * 5. Chamar o carregador de Kernel.
+ * @param info Mapa de memória e região do ramdisk (NULL = mantém as tabelas do firmware).
  */
-void arch_init_x86_64() {
+void arch_init_x86_64(ArcBootInfo *info) {
     // 1. Transição de modo (assembly)
     // ... Chamadas de funções de Assembly ...
 
@@ -20,8 +38,26 @@ void arch_init_x86_64() {
     // ... Código para configurar descritores ...
     
     // 3. Inicializar I/O e memória
+    arch_enable_sse();
+    bl_mem_init(); // Seleciona as variantes otimizadas de bl_memset/bl_memcpy
     // bl_memset(...);
 
+    // 3.0. Paging: mapa identidade com páginas de 1 GiB / 2 MiB (4 KiB só nas bordas).
+    // Antes dos APs: o trampolim copia o CR3 do BSP. Sem mapa de memória (ou se a
+    // construção falhar) fica o mapeamento do firmware, que cobre o loader.
+    if (info != NULL && bl_pt_init(&boot_pt, BL_PT_FORMAT_X86_64, NULL, NULL) &&
+        bl_pt_build_boot_tables(&boot_pt, info, BL_PT_KERNEL_WINDOW)) {
+        bl_pt_activate(&boot_pt);
+    }
+
+    // 3.1. Acordar os demais núcleos (ficam ociosos esperando trabalho).
+    // Tarefas grandes do boot (zerar memória, tabelas de página, hashing,
+    // descompressão) podem usar bl_smp_run_on_all() / bl_smp_memset() daqui em diante.
+    bl_smp_init();
+    if (info != NULL) {
+        bl_smp_publish(info); // O executor de init do kernel reaproveita os APs
+    }
+
     // 4. Chamar o carregador principal (Core Loader)
     // core_loader_load_kernel(); 
 }
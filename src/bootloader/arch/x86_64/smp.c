@@ -0,0 +1,255 @@
+// src/bootloader/arch/x86_64/smp.c
+// Bring-up dos Application Processors (x86_64) via Local APIC: INIT-SIPI-SIPI.
+
+#include "../../libbootloader/smp.h"
+#include "../../libbootloader/mem.h"
+
+// Trampolim em 16 bits (ap_trampoline.asm), montado antes deste arquivo (ver o Makefile)
+// como binário puro e embutido aqui.
+__asm__(
+    ".section .rodata\n"
+    ".balign 16\n"
+    ".global ap_trampoline_start\n"
+    "ap_trampoline_start:\n"
+    ".incbin \"ap_trampoline.bin\"\n"
+    ".global ap_trampoline_end\n"
+    "ap_trampoline_end:\n"
+    ".previous\n"
+);
+extern const uint8_t ap_trampoline_start[];
+extern const uint8_t ap_trampoline_end[];
+
+#define AP_TRAMPOLINE_ADDR   0x8000   // Deve bater com o ORG do trampolim
+#define AP_PARAMS_OFFSET     8
+
+// Bloco de parâmetros do trampolim (mesmo layout de ap_trampoline.asm)
+typedef struct {
+    uint32_t cr3;
+    volatile uint32_t next_cpu;
+    uint32_t max_cpus;
+    uint32_t reserved;
+    uint64_t entry;
+    uint64_t stack_base;
+    uint64_t stack_size;
+} __attribute__((packed)) ApTrampolineParams;
+
+// Local APIC (xAPIC, acesso por MMIO)
+#define IA32_APIC_BASE_MSR   0x1B
+#define LAPIC_ID             0x020
+#define LAPIC_ICR_LOW        0x300
+#define LAPIC_ICR_HIGH       0x310
+#define LAPIC_ICR_PENDING    (1u << 12)
+
+// ICR: shorthand "todos exceto eu" | nível assert | modo de entrega
+#define ICR_ALL_BUT_SELF     (3u << 18)
+#define ICR_ASSERT           (1u << 14)
+#define ICR_INIT             (5u << 8)
+#define ICR_STARTUP          (6u << 8)
+
+// Tempo para os APs se apresentarem após o segundo SIPI
+#define AP_ARRIVAL_TIMEOUT_US 100000
+
+static volatile uint32_t *lapic;
+
+static inline uint64_t rdmsr(uint32_t msr) {
+    uint32_t lo, hi;
+    __asm__ volatile("rdmsr" : "=a"(lo), "=d"(hi) : "c"(msr));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+// ~1 us por escrita na porta 0x80 (POST code), sem depender de timer calibrado
+static void io_delay_us(uint32_t us) {
+    while (us--) {
+        __asm__ volatile("outb %%al, $0x80" : : "a"(0));
+    }
+}
+
+// ACPI: só o necessário para achar a MADT ("APIC") e ler os IDs dos núcleos
+typedef struct {
+    char signature[8];        // "RSD PTR "
+    uint8_t checksum;
+    char oem_id[6];
+    uint8_t revision;         // 0 = ACPI 1.0 (só RSDT); >= 2 = XSDT disponível
+    uint32_t rsdt_paddr;
+    uint32_t length;
+    uint64_t xsdt_paddr;
+    uint8_t ext_checksum;
+    uint8_t reserved[3];
+} __attribute__((packed)) AcpiRsdp;
+
+typedef struct {
+    char signature[4];
+    uint32_t length;          // Inclui o cabeçalho
+    uint8_t revision;
+    uint8_t checksum;
+    char oem_id[6];
+    char oem_table_id[8];
+    uint32_t oem_revision;
+    uint32_t creator_id;
+    uint32_t creator_revision;
+} __attribute__((packed)) AcpiSdtHeader;
+
+#define MADT_ENTRIES_OFFSET  (sizeof(AcpiSdtHeader) + 8)  // + endereço do LAPIC + flags
+#define MADT_LOCAL_APIC      0
+#define MADT_LOCAL_X2APIC    9
+#define MADT_CPU_ENABLED     (1u << 0)
+
+static bool acpi_checksum_ok(const void *data, size_t len) {
+    const uint8_t *p = data;
+    uint8_t sum = 0;
+    while (len--) {
+        sum += *p++;
+    }
+    return sum == 0;
+}
+
+static bool acpi_sig_eq(const char *a, const char *b, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (a[i] != b[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static const AcpiRsdp *acpi_scan_rsdp(uintptr_t start, uintptr_t end) {
+    for (uintptr_t p = start; p + sizeof(AcpiRsdp) <= end; p += 16) {
+        const AcpiRsdp *rsdp = (const AcpiRsdp *)p;
+        if (acpi_sig_eq(rsdp->signature, "RSD PTR ", 8) && acpi_checksum_ok(rsdp, 20)) {
+            return rsdp;
+        }
+    }
+    return NULL;
+}
+
+// RSDP nas áreas legadas: primeiro 1 KiB da EBDA, depois 0xE0000-0xFFFFF.
+// Firmware UEFI sem essa cópia legada não é encontrado aqui.
+static const AcpiRsdp *acpi_find_rsdp(void) {
+    uintptr_t ebda = (uintptr_t)(*(volatile uint16_t *)0x40E) << 4;
+    const AcpiRsdp *rsdp = ebda >= 0x80000 && ebda < 0xA0000 ? acpi_scan_rsdp(ebda, ebda + 1024) : NULL;
+    return rsdp != NULL ? rsdp : acpi_scan_rsdp(0xE0000, 0x100000);
+}
+
+static const AcpiSdtHeader *acpi_find_table(const AcpiRsdp *rsdp, const char *sig) {
+    bool xsdt = rsdp->revision >= 2 && rsdp->xsdt_paddr != 0;
+    const AcpiSdtHeader *root = (const AcpiSdtHeader *)(uintptr_t)(xsdt ? rsdp->xsdt_paddr : rsdp->rsdt_paddr);
+    if (root == NULL || root->length < sizeof(AcpiSdtHeader) || !acpi_checksum_ok(root, root->length)) {
+        return NULL;
+    }
+    size_t width = xsdt ? 8 : 4;
+    size_t count = (root->length - sizeof(AcpiSdtHeader)) / width;
+    const uint8_t *entries = (const uint8_t *)(root + 1);
+    for (size_t i = 0; i < count; i++) {
+        uint64_t paddr = 0;
+        bl_memcpy(&paddr, entries + i * width, width); // Entradas da XSDT não são alinhadas
+        const AcpiSdtHeader *table = (const AcpiSdtHeader *)(uintptr_t)paddr;
+        if (table != NULL && acpi_sig_eq(table->signature, sig, 4) &&
+            acpi_checksum_ok(table, table->length)) {
+            return table;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Lista os APIC IDs dos núcleos habilitados na MADT, exceto o do BSP.
+ * * Núcleos desabilitados pelo firmware (flag 'enabled' = 0) ficam de fora, assim
+ * * como x2APIC IDs > 255, que o ICR do xAPIC não endereça.
+ * @return Número de IDs em 'ids', ou -1 se não há MADT.
+ */
+static int madt_ap_ids(uint8_t *ids, uint32_t max_ids, uint32_t self_id) {
+    const AcpiRsdp *rsdp = acpi_find_rsdp();
+    const AcpiSdtHeader *madt = rsdp != NULL ? acpi_find_table(rsdp, "APIC") : NULL;
+    if (madt == NULL) {
+        return -1;
+    }
+
+    uint32_t count = 0;
+    const uint8_t *p = (const uint8_t *)madt + MADT_ENTRIES_OFFSET;
+    const uint8_t *end = (const uint8_t *)madt + madt->length;
+    while (p + 2 <= end && p[1] >= 2 && p + p[1] <= end) {
+        uint32_t id = UINT32_MAX, flags = 0;
+        if (p[0] == MADT_LOCAL_APIC && p[1] >= 8) {
+            id = p[3];
+            bl_memcpy(&flags, p + 4, 4);
+        } else if (p[0] == MADT_LOCAL_X2APIC && p[1] >= 16) {
+            bl_memcpy(&id, p + 4, 4);
+            bl_memcpy(&flags, p + 8, 4);
+        }
+        if ((flags & MADT_CPU_ENABLED) && id <= 0xFF && id != self_id && count < max_ids) {
+            ids[count++] = (uint8_t)id;
+        }
+        p += p[1];
+    }
+    return (int)count;
+}
+
+static void lapic_send_ipi(uint32_t dest_apic_id, uint32_t icr_low) {
+    lapic[LAPIC_ICR_HIGH / 4] = dest_apic_id << 24;
+    lapic[LAPIC_ICR_LOW / 4] = icr_low;
+    while (lapic[LAPIC_ICR_LOW / 4] & LAPIC_ICR_PENDING) {
+        bl_cpu_relax();
+    }
+}
+
+uint32_t arch_smp_start_aps(uint8_t *stacks, size_t stack_size, uint32_t max_cpus) {
+    uint64_t cr3;
+    __asm__ volatile("mov %%cr3, %0" : "=r"(cr3));
+    if (cr3 >> 32) {
+        return 0; // O trampolim carrega CR3 ainda em 32 bits
+    }
+
+    lapic = (volatile uint32_t *)(uintptr_t)(rdmsr(IA32_APIC_BASE_MSR) & ~0xFFFull);
+
+    // 1. Trampolim e parâmetros em memória baixa
+    uint8_t *tramp = (uint8_t *)(uintptr_t)AP_TRAMPOLINE_ADDR;
+    bl_memcpy(tramp, ap_trampoline_start, (size_t)(ap_trampoline_end - ap_trampoline_start));
+
+    ApTrampolineParams *params = (ApTrampolineParams *)(tramp + AP_PARAMS_OFFSET);
+    params->cr3 = (uint32_t)cr3;
+    params->next_cpu = 1;
+    params->max_cpus = max_cpus;
+    params->entry = (uint64_t)(uintptr_t)bl_smp_ap_entry;
+    params->stack_base = (uint64_t)(uintptr_t)stacks;
+    params->stack_size = stack_size;
+
+    // 2. INIT-SIPI-SIPI para cada núcleo habilitado na MADT. Sem MADT (ex: UEFI
+    // sem a cópia legada do RSDP), cai no broadcast "todos exceto eu", que também
+    // acorda núcleos desabilitados pelo firmware; o excesso de APs fica parado no
+    // trampolim (param_max_cpus).
+    uint8_t ids[BL_MAX_CPUS];
+    int targets = madt_ap_ids(ids, max_cpus - 1, lapic[LAPIC_ID / 4] >> 24);
+    if (targets == 0) {
+        return 0;
+    }
+    uint32_t sipi = ICR_ASSERT | ICR_STARTUP | (AP_TRAMPOLINE_ADDR >> 12);
+    if (targets < 0) {
+        lapic_send_ipi(0, ICR_ALL_BUT_SELF | ICR_ASSERT | ICR_INIT);
+    }
+    for (int t = 0; t < targets; t++) {
+        lapic_send_ipi(ids[t], ICR_ASSERT | ICR_INIT);
+    }
+    io_delay_us(10000);
+    for (int i = 0; i < 2; i++) {
+        if (targets < 0) {
+            lapic_send_ipi(0, ICR_ALL_BUT_SELF | sipi);
+        }
+        for (int t = 0; t < targets; t++) {
+            lapic_send_ipi(ids[t], sipi);
+        }
+        io_delay_us(200);
+    }
+
+    // 3. Espera as chegadas pararem (cada AP pega um índice no trampolim)
+    uint32_t seen = params->next_cpu;
+    for (uint32_t quiet = 0; quiet < AP_ARRIVAL_TIMEOUT_US; quiet += 100) {
+        io_delay_us(100);
+        if (params->next_cpu != seen) {
+            seen = params->next_cpu;
+            quiet = 0;
+        }
+    }
+
+    uint32_t started = params->next_cpu - 1;
+    return started < max_cpus ? started : max_cpus - 1;
+}
@@ -0,0 +1,64 @@
+#ifndef LIBBOOTLOADER_BOOT_INFO_H
+#define LIBBOOTLOADER_BOOT_INFO_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+// Estrutura compacta entregue pelo bootloader (BIOS ou UEFI) ao kernel.
+// Tudo é endereço físico; o kernel a encontra pelo ponteiro passado na entrada.
+
+#define ARC_BOOT_INFO_MAGIC   0x4F464E4943524155ull // "UARCINFO"
+#define ARC_BOOT_INFO_VERSION 2
+
+// Alinhamento da região do ramdisk: permite mapeá-la com páginas de 2 MiB.
+#define ARC_RAMDISK_ALIGN (2ull * 1024 * 1024)
+
+// Entrada do mapa de memória. Mesmo layout e códigos de tipo de PmmRegion
+// (src/sys/kernel/kernl/mm/page_alloc.h): o array pode ir direto para pmm_init().
+typedef struct {
+    uint64_t base;
+    uint64_t length;
+    uint32_t type;     // 1 = usável, 2 = reservado, 3 = ACPI reclaim, 4 = ACPI NVS, 5 = defeituosa,
+                       // ARC_MEM_TYPE_LOADER
+} ArcMemRegion;
+
+// Memória do bootloader (UEFI LoaderCode/LoaderData: imagem do loader, pilhas,
+// boot info). Mapeada executável nas tabelas do boot; para o kernel é reservada
+// como qualquer tipo != 1.
+#define ARC_MEM_TYPE_LOADER 0x80
+
+// Caixa de correio de um núcleo secundário (libbootloader/smp.c). Os APs
+// acordados pelo bootloader continuam no laço ocioso dele depois do handoff:
+// quem publica (fn, arg) e incrementa 'seq' faz o AP executar fn e copiar
+// 'seq' para 'done'. Um trabalho por vez (espere done == seq antes de publicar).
+#define ARC_SMP_MAX_CPUS 64
+
+typedef struct {
+    atomic_uint seq;
+    atomic_uint done;
+    void (*fn)(uint32_t cpu, uint32_t ncpus, void *arg);
+    void *arg;
+} __attribute__((aligned(64))) ArcSmpMailbox;
+
+typedef struct {
+    uint64_t magic;             // ARC_BOOT_INFO_MAGIC
+    uint32_t version;           // ARC_BOOT_INFO_VERSION
+    uint32_t mem_region_count;  // Entradas em mem_regions
+    uint64_t mem_regions_paddr; // ArcMemRegion[mem_region_count]
+
+    // Região contígua, alinhada a ARC_RAMDISK_ALIGN: ramdisk seguido da
+    // arena de descompressão. Já marcada como reservada no mapa de memória.
+    uint64_t ramdisk_paddr;
+    uint64_t ramdisk_size;
+    uint64_t arena_paddr;
+    uint64_t arena_size;
+
+    // Núcleos online no handoff (inclui o BSP) e suas caixas de correio
+    // (ArcSmpMailbox[ARC_SMP_MAX_CPUS]; 0 = só o BSP). O código e as pilhas do
+    // bootloader precisam continuar reservados enquanto os APs forem usados.
+    uint32_t cpu_count;
+    uint32_t reserved;
+    uint64_t smp_mailboxes_paddr;
+} ArcBootInfo;
+
+#endif // LIBBOOTLOADER_BOOT_INFO_H
@@ -10,6 +10,14 @@
 // Funções de Gerenciamento de Memória Mínima
 // Essas funções são cruciais para a inicialização da CPU.
 
+/**
+ * @brief Detecta os recursos da CPU usados por bl_memset/bl_memcpy.
+ * * x86_64: ERMS e AVX2 (chamar após ligar CR4.OSFXSR: o caminho médio usa SSE2).
+ * * ARM64: bloco do DC ZVA (chamar após habilitar FP/SIMD).
+ * * Antes desta chamada as funções usam apenas o caminho genérico de palavras.
+ */
+void bl_mem_init(void);
+
 /**
  * @brief Limpa um bloco de memória para um valor específico.
  * * @param dest Endereço inicial da memória.
@@ -26,4 +34,8 @@ void bl_memset(void *dest, int val, size_t count);
  */
 void bl_memcpy(void *dest, const void *src, size_t count);
 
+// Autoteste e benchmark (mem_test.c). 'scratch' é uma área livre de RAM.
+int bl_mem_run_selftest(uint8_t *scratch, size_t scratch_size);
+void bl_mem_run_benchmark(uint8_t *scratch, size_t scratch_size);
+
 #endif // LIBBOOTLOADER_MEM_H
@@ -0,0 +1,189 @@
+// src/bootloader/libbootloader/mem_test.c
+// Autoteste e benchmark de bl_memset/bl_memcpy (freestanding: sem libc).
+
+#include "mem.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+extern void bl_print_str(const char *str);
+
+// Tamanhos medidos: um por classe (pequeno, médio/vetorial, grande/ERMS-ZVA)
+static const size_t bench_sizes[] = { 64, 4096, 64u * 1024 * 1024 };
+
+// Bytes processados por medição (tamanhos pequenos repetem até chegar aqui)
+#define BL_MEM_BENCH_BYTES (64u * 1024 * 1024)
+
+// Contador de ciclos da CPU (TSC no x86_64, CNTVCT_EL0 no ARM64)
+static inline uint64_t bl_bench_ticks(void) {
+#if defined(__x86_64__)
+    uint32_t lo, hi;
+    __asm__ volatile("lfence; rdtsc" : "=a"(lo), "=d"(hi) : : "memory");
+    return ((uint64_t)hi << 32) | lo;
+#elif defined(__aarch64__)
+    uint64_t v;
+    __asm__ volatile("isb; mrs %0, cntvct_el0" : "=r"(v) : : "memory");
+    return v;
+#else
+    return 0;
+#endif
+}
+
+// Referência: laço byte a byte (volatile impede o compilador de vetorizar)
+static void bench_byte_memset(uint8_t *d, uint8_t val, size_t count) {
+    volatile uint8_t *p = d;
+    while (count--) {
+        *p++ = val;
+    }
+}
+
+static void bench_byte_memcpy(uint8_t *d, const uint8_t *s, size_t count) {
+    volatile uint8_t *p = d;
+    while (count--) {
+        *p++ = *s++;
+    }
+}
+
+static void bl_print_u64(uint64_t v) {
+    char buf[21];
+    int i = 20;
+    buf[i] = '\0';
+    do {
+        buf[--i] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v != 0);
+    bl_print_str(&buf[i]);
+}
+
+// Ticks médios por chamada e bytes por 1000 ticks
+static void bench_report(const char *what, size_t size, uint64_t ticks, uint64_t iters) {
+    bl_print_str("BL_MEM_BENCH: ");
+    bl_print_str(what);
+    bl_print_str(" ");
+    bl_print_u64(size);
+    bl_print_str(" B: ");
+    bl_print_u64(ticks / iters);
+    bl_print_str(" ticks/op, ");
+    bl_print_u64(ticks ? (uint64_t)size * iters * 1000 / ticks : 0);
+    bl_print_str(" B/kTick\n");
+}
+
+
+/**
+ * @brief Confere bl_memset/bl_memcpy contra o laço byte a byte em todas as
+ * classes de tamanho, com destino e origem desalinhados.
+ * * Usa 'scratch' (>= 3 * 8 KiB) como área de trabalho.
+ * @return 0 se o teste for bem-sucedido, 1 caso contrário.
+ */
+int bl_mem_run_selftest(uint8_t *scratch, size_t scratch_size) {
+    const size_t span = 8192;
+    if (scratch == NULL || scratch_size < 3 * span) {
+        bl_print_str("TEST FAILED: area de trabalho insuficiente.\n");
+        return 1;
+    }
+    uint8_t *dst = scratch;
+    uint8_t *src = scratch + span;
+    uint8_t *ref = scratch + 2 * span;
+
+    bl_print_str("--- ARCANOS BL_MEM: SELF-TEST ---\n");
+    for (size_t i = 0; i < span; i++) {
+        src[i] = (uint8_t)(i * 131 + 7);
+    }
+
+    static const size_t sizes[] = { 0, 1, 3, 4, 7, 8, 15, 16, 31, 32, 63, 64, 65, 100,
+                                     255, 256, 1000, 2047, 2048, 2049, 4096, 6000 };
+    for (size_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+        size_t n = sizes[k];
+        for (size_t off = 0; off < 64; off += 7) {
+            if (off + n + 64 > span) {
+                continue;
+            }
+            // memset: guarda de 32 bytes em volta do trecho
+            bench_byte_memset(dst, 0xEE, span);
+            bench_byte_memset(ref, 0xEE, span);
+            bl_memset(dst + off, 0x5A, n);
+            bench_byte_memset(ref + off, 0x5A, n);
+            for (size_t i = 0; i < n + 64 + off; i++) {
+                if (dst[i] != ref[i]) {
+                    bl_print_str("TEST FAILED: bl_memset divergiu do laco de referencia.\n");
+                    return 1;
+                }
+            }
+
+            // memcpy com origem em outro alinhamento
+            bench_byte_memset(dst, 0xEE, span);
+            bench_byte_memset(ref, 0xEE, span);
+            bl_memcpy(dst + off, src + (off * 3) % 64, n);
+            bench_byte_memcpy(ref + off, src + (off * 3) % 64, n);
+            for (size_t i = 0; i < n + 64 + off; i++) {
+                if (dst[i] != ref[i]) {
+                    bl_print_str("TEST FAILED: bl_memcpy divergiu do laco de referencia.\n");
+                    return 1;
+                }
+            }
+        }
+    }
+
+    bl_print_str("--- ARCANOS BL_MEM: TESTE BEM-SUCEDIDO ---\n");
+    return 0;
+}
+
+/**
+ * @brief Mede bl_memset/bl_memcpy a 64 B, 4 KiB e 64 MiB contra o laço byte a byte.
+ * * Chamar depois de bl_mem_init(). 'scratch' precisa de 2 * 64 MiB para o caso
+ * * grande (ex: a arena de descompressão do ArcBootInfo); tamanhos que não
+ * * cabem são pulados.
+ */
+void bl_mem_run_benchmark(uint8_t *scratch, size_t scratch_size) {
+    bl_print_str("--- ARCANOS BL_MEM: BENCHMARK ---\n");
+
+    for (size_t k = 0; k < sizeof(bench_sizes) / sizeof(bench_sizes[0]); k++) {
+        size_t size = bench_sizes[k];
+        if (scratch == NULL || scratch_size < 2 * size) {
+            bl_print_str("BL_MEM_BENCH: area de trabalho pequena, pulando ");
+            bl_print_u64(size);
+            bl_print_str(" B\n");
+            continue;
+        }
+        uint8_t *dst = scratch;
+        uint8_t *src = scratch + size;
+        uint64_t iters = BL_MEM_BENCH_BYTES / size;
+        if (iters == 0) {
+            iters = 1;
+        }
+
+        bl_memset(src, 0x33, size); // Páginas já tocadas antes de medir
+        bl_memset(dst, 0, size);
+
+        uint64_t t0 = bl_bench_ticks();
+        for (uint64_t i = 0; i < iters; i++) {
+            bench_byte_memset(dst, (uint8_t)i, size);
+        }
+        uint64_t t1 = bl_bench_ticks();
+        for (uint64_t i = 0; i < iters; i++) {
+            bl_memset(dst, (int)(uint8_t)i, size);
+        }
+        uint64_t t2 = bl_bench_ticks();
+        bench_report("memset byte-loop", size, t1 - t0, iters);
+        bench_report("memset bl_memset", size, t2 - t1, iters);
+
+        t0 = bl_bench_ticks();
+        for (uint64_t i = 0; i < iters; i++) {
+            bench_byte_memcpy(dst, src, size);
+        }
+        t1 = bl_bench_ticks();
+        for (uint64_t i = 0; i < iters; i++) {
+            bl_memcpy(dst, src, size);
+        }
+        t2 = bl_bench_ticks();
+        bench_report("memcpy byte-loop", size, t1 - t0, iters);
+        bench_report("memcpy bl_memcpy", size, t2 - t1, iters);
+    }
+}
+
+// Opcional: chamada a partir do arch_init (depois de bl_mem_init), por exemplo
+// com a arena do ArcBootInfo:
+/*
+    bl_mem_run_selftest((uint8_t *)(uintptr_t)info->arena_paddr, info->arena_size);
+    bl_mem_run_benchmark((uint8_t *)(uintptr_t)info->arena_paddr, info->arena_size);
+*/
@@ -0,0 +1,353 @@
+#include "paging.h"
+#include "mem.h"
+
+// =======================================================
+// Tabelas de página do boot (parte independente de arquitetura)
+// =======================================================
+//
+// Nível 0 = PML4 / L0 (512 GiB por entrada), 1 = PDPT / L1 (1 GiB),
+// 2 = PD / L2 (2 MiB), 3 = PT / L3 (4 KiB). No boot tudo é mapa identidade,
+// então o endereço físico de uma tabela também é o seu ponteiro.
+
+// Pool estático usado quando bl_pt_init() recebe alloc == NULL. Com páginas
+// grandes, o mapa identidade de toda a RAM cabe em poucas tabelas.
+#define BL_PT_POOL_PAGES 64
+
+static uint64_t pt_pool[BL_PT_POOL_PAGES][BL_PT_ENTRIES] __attribute__((aligned(4096)));
+static uint32_t pt_pool_used;
+
+#define PT_ADDR_MASK 0x0000FFFFFFFFF000ull
+
+// x86_64
+#define X86_P    (1ull << 0)
+#define X86_RW   (1ull << 1)
+#define X86_PWT  (1ull << 3)
+#define X86_PCD  (1ull << 4)
+#define X86_PS   (1ull << 7)
+#define X86_NX   (1ull << 63)
+
+// ARM64 (stage 1, grânulo de 4 KiB). MAIR: índice 0 = normal WB, 1 = Device-nGnRnE.
+#define A64_VALID      (1ull << 0)
+#define A64_TABLE      (1ull << 1)   // Tabela (níveis 0-2) ou página (nível 3)
+#define A64_ATTR_NORM  (0ull << 2)
+#define A64_ATTR_DEV   (1ull << 2)
+#define A64_AP_RO      (1ull << 7)
+#define A64_SH_INNER   (3ull << 8)
+#define A64_AF         (1ull << 10)
+#define A64_PXN        (1ull << 53)
+#define A64_UXN        (1ull << 54)
+
+static inline uint64_t *pt_table(uint64_t paddr) {
+    return (uint64_t *)(uintptr_t)paddr;
+}
+
+static inline uint32_t pt_shift(int level) {
+    return 39 - 9 * (uint32_t)level;
+}
+
+static uint64_t pt_pool_alloc(void *ctx) {
+    (void)ctx;
+    if (pt_pool_used >= BL_PT_POOL_PAGES) {
+        return 0;
+    }
+    uint64_t *page = pt_pool[pt_pool_used++];
+    bl_memset(page, 0, BL_PT_SIZE_4K);
+    return (uint64_t)(uintptr_t)page;
+}
+
+static uint64_t pt_alloc_table(BlPageTableBuilder *b) {
+    uint64_t paddr = b->alloc(b->alloc_ctx);
+    if (paddr != 0) {
+        b->tables++;
+    }
+    return paddr;
+}
+
+static bool pt_is_table(const BlPageTableBuilder *b, uint64_t e, int level) {
+    if (level == 3 || !(e & 1)) {
+        return false;
+    }
+    if (b->format == BL_PT_FORMAT_X86_64) {
+        return level == 0 || !(e & X86_PS);
+    }
+    return (e & A64_TABLE) != 0;
+}
+
+static uint64_t pt_make_table(const BlPageTableBuilder *b, uint64_t paddr) {
+    if (b->format == BL_PT_FORMAT_X86_64) {
+        return paddr | X86_P | X86_RW; // Permissões finais ficam na folha
+    }
+    return paddr | A64_VALID | A64_TABLE;
+}
+
+// Descritor de folha: página de 4 KiB (nível 3) ou bloco (níveis 1-2)
+static uint64_t pt_make_leaf(const BlPageTableBuilder *b, uint64_t paddr, int level, uint32_t attrs) {
+    uint64_t e = paddr & PT_ADDR_MASK;
+
+    if (b->format == BL_PT_FORMAT_X86_64) {
+        e |= X86_P;
+        if (level < 3) e |= X86_PS;
+        if (attrs & BL_PT_WRITE) e |= X86_RW;
+        if (attrs & BL_PT_DEVICE) e |= X86_PCD | X86_PWT;
+        if (!(attrs & BL_PT_EXEC) && b->use_nx) e |= X86_NX;
+        return e;
+    }
+
+    e |= A64_VALID | A64_AF;
+    if (level == 3) e |= A64_TABLE;
+    e |= (attrs & BL_PT_DEVICE) ? A64_ATTR_DEV : (A64_ATTR_NORM | A64_SH_INNER);
+    if (!(attrs & BL_PT_WRITE)) e |= A64_AP_RO;
+    e |= A64_UXN;
+    if (!(attrs & BL_PT_EXEC) || (attrs & BL_PT_DEVICE)) e |= A64_PXN;
+    return e;
+}
+
+// Converte um bloco em uma tabela do nível seguinte com os mesmos atributos,
+// para que um mapeamento menor possa sobrescrever só parte dele.
+static bool pt_split_block(BlPageTableBuilder *b, uint64_t *entry, int level) {
+    uint64_t table = pt_alloc_table(b);
+    if (table == 0) {
+        return false;
+    }
+    uint64_t block = *entry;
+    uint64_t base = block & PT_ADDR_MASK & ~((1ull << pt_shift(level)) - 1);
+    uint64_t flags = block & ~PT_ADDR_MASK;
+    uint64_t step = 1ull << pt_shift(level + 1);
+
+    if (b->format == BL_PT_FORMAT_X86_64) {
+        if (level + 1 == 3) flags &= ~X86_PS; // No nível 3 o bit 7 é PAT
+    } else if (level + 1 == 3) {
+        flags |= A64_TABLE;                   // Descritor de página
+    }
+
+    uint64_t *t = pt_table(table);
+    for (uint32_t i = 0; i < BL_PT_ENTRIES; i++) {
+        t[i] = (base + i * step) | flags;
+    }
+    if (level + 1 == 3) b->mapped_4k += BL_PT_ENTRIES;
+    else b->mapped_2m += BL_PT_ENTRIES;
+    if (level == 1) b->mapped_1g--;
+    else b->mapped_2m--;
+
+    *entry = pt_make_table(b, table);
+    return true;
+}
+
+static bool pt_map_one(BlPageTableBuilder *b, int target, uint64_t vaddr, uint64_t paddr, uint32_t attrs) {
+    uint64_t *table = pt_table(b->root);
+
+    for (int level = 0; level < target; level++) {
+        uint64_t *entry = &table[(vaddr >> pt_shift(level)) & (BL_PT_ENTRIES - 1)];
+        if (!(*entry & 1)) {
+            uint64_t next = pt_alloc_table(b);
+            if (next == 0) {
+                return false;
+            }
+            *entry = pt_make_table(b, next);
+        } else if (!pt_is_table(b, *entry, level)) {
+            if (!pt_split_block(b, entry, level)) {
+                return false;
+            }
+        }
+        table = pt_table(*entry & PT_ADDR_MASK);
+    }
+
+    uint64_t *entry = &table[(vaddr >> pt_shift(target)) & (BL_PT_ENTRIES - 1)];
+    if (pt_is_table(b, *entry, target)) {
+        // Já há mapeamentos menores aqui: desce um nível em vez de descartá-los
+        uint64_t step = 1ull << pt_shift(target + 1);
+        for (uint32_t i = 0; i < BL_PT_ENTRIES; i++) {
+            if (!pt_map_one(b, target + 1, vaddr + i * step, paddr + i * step, attrs)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    if (*entry & 1) {
+        // Substituindo uma folha do mesmo tamanho
+        if (target == 1) b->mapped_1g--;
+        else if (target == 2) b->mapped_2m--;
+        else b->mapped_4k--;
+    }
+    *entry = pt_make_leaf(b, paddr, target, attrs);
+    if (target == 1) b->mapped_1g++;
+    else if (target == 2) b->mapped_2m++;
+    else b->mapped_4k++;
+    return true;
+}
+
+
+bool bl_pt_init(BlPageTableBuilder *b, BlPtFormat format, BlPtAllocFn alloc, void *ctx) {
+    bl_memset(b, 0, sizeof(*b));
+    b->format = format;
+    b->alloc = alloc ? alloc : pt_pool_alloc;
+    b->alloc_ctx = ctx;
+
+    if (format == BL_PT_FORMAT_ARM64) {
+        b->allow_1g = true; // Blocos L1 sempre existem com grânulo de 4 KiB
+    } else {
+#if defined(__x86_64__)
+        uint32_t eax, ebx, ecx, edx;
+        __asm__ volatile("cpuid" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "a"(0x80000000u), "c"(0));
+        if (eax >= 0x80000001u) {
+            __asm__ volatile("cpuid" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "a"(0x80000001u), "c"(0));
+            b->allow_1g = (edx >> 26) & 1; // PDPE1GB
+            b->use_nx = (edx >> 20) & 1;   // NX (bl_pt_activate liga EFER.NXE)
+        }
+#endif
+    }
+
+    b->root = pt_alloc_table(b);
+    return b->root != 0;
+}
+
+bool bl_pt_map_range(BlPageTableBuilder *b, uint64_t vaddr, uint64_t paddr,
+                     uint64_t size, uint32_t attrs) {
+    if (((vaddr | paddr | size) & (BL_PT_SIZE_4K - 1)) != 0) {
+        return false;
+    }
+
+    while (size > 0) {
+        // Maior página que cabe: endereços alinhados e tamanho restante suficiente.
+        // Endereços com a mesma fase em relação a 2 MiB/1 GiB usam blocos no meio
+        // da região e páginas de 4 KiB só nas bordas.
+        uint64_t align = vaddr | paddr;
+        int level = 3;
+        if (b->allow_1g && (align & (BL_PT_SIZE_1G - 1)) == 0 && size >= BL_PT_SIZE_1G) {
+            level = 1;
+        } else if ((align & (BL_PT_SIZE_2M - 1)) == 0 && size >= BL_PT_SIZE_2M) {
+            level = 2;
+        }
+
+        if (!pt_map_one(b, level, vaddr, paddr, attrs)) {
+            return false;
+        }
+        uint64_t step = 1ull << pt_shift(level);
+        vaddr += step;
+        paddr += step;
+        size -= step;
+    }
+    return true;
+}
+
+// Mapa identidade, arredondando para fora até a granularidade de 4 KiB
+static bool pt_identity(BlPageTableBuilder *b, uint64_t base, uint64_t length, uint32_t attrs) {
+    if (length == 0) {
+        return true;
+    }
+    uint64_t start = base & ~(BL_PT_SIZE_4K - 1);
+    uint64_t end = (base + length + BL_PT_SIZE_4K - 1) & ~(BL_PT_SIZE_4K - 1);
+    return bl_pt_map_range(b, start, start, end - start, attrs);
+}
+
+bool bl_pt_build_boot_tables(BlPageTableBuilder *b, const ArcBootInfo *info,
+                             uint64_t kernel_size) {
+    if (info != NULL) {
+        const ArcMemRegion *regions = (const ArcMemRegion *)(uintptr_t)info->mem_regions_paddr;
+        for (uint32_t i = 0; i < info->mem_region_count; i++) {
+            // RAM, tabelas ACPI e o próprio loader (código + dados: executável).
+            // Faixas reservadas podem ser MMIO e ficam de fora.
+            uint32_t type = regions[i].type;
+            uint32_t attrs = type == ARC_MEM_TYPE_LOADER ? BL_PT_WRITE | BL_PT_EXEC : BL_PT_WRITE;
+            if (type != 1 && type != 3 && type != 4 && type != ARC_MEM_TYPE_LOADER) {
+                continue;
+            }
+            if (!pt_identity(b, regions[i].base, regions[i].length, attrs)) {
+                return false;
+            }
+        }
+
+        // Ramdisk + arena: contíguos e alinhados a 2 MiB (ARC_RAMDISK_ALIGN)
+        uint64_t rd_end = info->arena_size ? info->arena_paddr + info->arena_size
+                                           : info->ramdisk_paddr + info->ramdisk_size;
+        if (info->ramdisk_size != 0 &&
+            !pt_identity(b, info->ramdisk_paddr, rd_end - info->ramdisk_paddr, BL_PT_WRITE)) {
+            return false;
+        }
+    }
+
+    if (b->format == BL_PT_FORMAT_X86_64) {
+        // Memória baixa: loader BIOS e trampolim dos APs rodam daqui (NX não pode
+        // valer); o RSDP da MADT também fica nessa faixa.
+        if (!pt_identity(b, 0, BL_PT_LOW_MEMORY_END, BL_PT_WRITE | BL_PT_EXEC) ||
+            !pt_identity(b, CONFIG_LAPIC_BASE_ADDR, BL_PT_SIZE_4K, BL_PT_WRITE | BL_PT_DEVICE)) {
+            return false;
+        }
+    } else if (CONFIG_UART_BASE_ADDR != 0 &&
+               !pt_identity(b, CONFIG_UART_BASE_ADDR, BL_PT_SIZE_4K, BL_PT_WRITE | BL_PT_DEVICE)) {
+        return false;
+    }
+
+    // Kernel por último: sobrescreve os atributos da RAM em volta com EXEC
+    return pt_identity(b, CONFIG_MEM_BASE_ADDR, kernel_size, BL_PT_WRITE | BL_PT_EXEC);
+}
+
+uint64_t bl_pt_translate(const BlPageTableBuilder *b, uint64_t vaddr, uint64_t *page_size) {
+    uint64_t *table = pt_table(b->root);
+
+    for (int level = 0; level <= 3; level++) {
+        uint64_t e = table[(vaddr >> pt_shift(level)) & (BL_PT_ENTRIES - 1)];
+        if (!(e & 1)) {
+            break;
+        }
+        if (pt_is_table(b, e, level)) {
+            table = pt_table(e & PT_ADDR_MASK);
+            continue;
+        }
+        uint64_t size = 1ull << pt_shift(level);
+        if (page_size) {
+            *page_size = size;
+        }
+        return (e & PT_ADDR_MASK & ~(size - 1)) | (vaddr & (size - 1));
+    }
+    return UINT64_MAX;
+}
+
+// =======================================================
+// Ativação (específica de arquitetura)
+// =======================================================
+
+void bl_pt_activate(const BlPageTableBuilder *b) {
+#if defined(__x86_64__) && !defined(BL_PT_HOSTED)
+    if (b->use_nx) {
+        uint32_t lo, hi;
+        __asm__ volatile("rdmsr" : "=a"(lo), "=d"(hi) : "c"(0xC0000080u)); // EFER
+        lo |= 1u << 11;                                                  // NXE
+        __asm__ volatile("wrmsr" : : "a"(lo), "d"(hi), "c"(0xC0000080u));
+    }
+    __asm__ volatile("mov %0, %%cr3" : : "r"(b->root) : "memory");
+#elif defined(__aarch64__) && !defined(BL_PT_HOSTED)
+    uint64_t mmfr0;
+    __asm__ volatile("mrs %0, id_aa64mmfr0_el1" : "=r"(mmfr0));
+
+    uint64_t mair = 0xFFull            // Índice 0: normal, write-back
+                  | (0x00ull << 8);    // Índice 1: Device-nGnRnE
+    uint64_t tcr = 16ull               // T0SZ: 48 bits
+                 | (1ull << 8)         // IRGN0: WB
+                 | (1ull << 10)        // ORGN0: WB
+                 | (3ull << 12)        // SH0: inner shareable
+                 | (0ull << 14)        // TG0: 4 KiB
+                 | (1ull << 23)        // EPD1: sem TTBR1 no boot
+                 | ((mmfr0 & 7) << 32);// IPS = PARange
+
+    __asm__ volatile(
+        "dsb ishst\n"
+        "msr mair_el1, %0\n"
+        "msr tcr_el1, %1\n"
+        "msr ttbr0_el1, %2\n"
+        "isb\n"
+        "tlbi vmalle1\n"
+        "dsb ish\n"
+        "isb\n"
+        "mrs x9, sctlr_el1\n"
+        "orr x9, x9, #(1 << 0)\n"   // M
+        "orr x9, x9, #(1 << 2)\n"   // C
+        "orr x9, x9, #(1 << 12)\n"  // I
+        "msr sctlr_el1, x9\n"
+        "isb\n"
+        : : "r"(mair), "r"(tcr), "r"(b->root) : "x9", "memory");
+#else
+    (void)b;
+#endif
+}
@@ -0,0 +1,106 @@
+#ifndef LIBBOOTLOADER_PAGING_H
+#define LIBBOOTLOADER_PAGING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "boot_info.h"
+
+// Construtor das tabelas de página do boot (4 níveis, grânulo de 4 KiB, 48 bits).
+// Usa páginas de 1 GiB e 2 MiB sempre que endereço virtual, físico e tamanho
+// permitem, caindo para 4 KiB só nas bordas das regiões.
+
+// Endereço físico do kernel (kernel/config.bzl: MEM_BASE_ADDR)
+#ifndef CONFIG_MEM_BASE_ADDR
+#define CONFIG_MEM_BASE_ADDR 0x80000000ull
+#endif
+
+// Janela mapeada para a imagem do kernel a partir de CONFIG_MEM_BASE_ADDR
+#define BL_PT_KERNEL_WINDOW (64ull * 1024 * 1024)
+
+// x86_64: primeiro 1 MiB (loader BIOS, trampolim dos APs em 0x8000, EBDA/RSDP)
+#define BL_PT_LOW_MEMORY_END 0x100000ull
+
+// MMIO mapeado como BL_PT_DEVICE pelas tabelas do boot
+#ifndef CONFIG_LAPIC_BASE_ADDR
+#define CONFIG_LAPIC_BASE_ADDR 0xFEE00000ull  // x86_64: Local APIC (xAPIC)
+#endif
+#ifndef CONFIG_UART_BASE_ADDR
+#define CONFIG_UART_BASE_ADDR 0x09000000ull   // ARM64: PL011 (QEMU virt); 0 = sem UART MMIO
+#endif
+
+#define BL_PT_ENTRIES   512
+#define BL_PT_SIZE_4K   (1ull << 12)
+#define BL_PT_SIZE_2M   (1ull << 21)
+#define BL_PT_SIZE_1G   (1ull << 30)
+
+// Formato dos descritores. Ambos usam a mesma árvore (PML4/L0 .. PT/L3).
+typedef enum {
+    BL_PT_FORMAT_X86_64 = 0,
+    BL_PT_FORMAT_ARM64  = 1
+} BlPtFormat;
+
+// Atributos de mapeamento
+#define BL_PT_WRITE   (1u << 0)
+#define BL_PT_EXEC    (1u << 1)
+#define BL_PT_DEVICE  (1u << 2)   // MMIO: sem cache
+
+// Aloca uma página de tabela (4 KiB, zerada). Retorna o endereço físico ou 0.
+typedef uint64_t (*BlPtAllocFn)(void *ctx);
+
+typedef struct {
+    BlPtFormat format;
+    bool allow_1g;          // x86_64: exige CPUID PDPE1GB; ARM64: sempre
+    bool use_nx;            // x86_64: marca NX (requer EFER.NXE)
+    BlPtAllocFn alloc;
+    void *alloc_ctx;
+    uint64_t root;          // Endereço físico da tabela raiz (PML4 / L0)
+    uint64_t tables;        // Páginas de tabela alocadas
+    uint64_t mapped_1g;     // Contadores de mapeamentos por tamanho
+    uint64_t mapped_2m;
+    uint64_t mapped_4k;
+} BlPageTableBuilder;
+
+/**
+ * @brief Prepara o construtor e aloca a tabela raiz.
+ * @param alloc Alocador de páginas de tabela (NULL = pool estático do bootloader).
+ */
+bool bl_pt_init(BlPageTableBuilder *b, BlPtFormat format, BlPtAllocFn alloc, void *ctx);
+
+/**
+ * @brief Mapeia [vaddr, vaddr + size) -> [paddr, ...) com as maiores páginas possíveis.
+ * * Endereços e tamanho devem ser múltiplos de 4 KiB. Blocos grandes já existentes
+ * * são divididos quando um mapeamento menor se sobrepõe a eles.
+ */
+bool bl_pt_map_range(BlPageTableBuilder *b, uint64_t vaddr, uint64_t paddr,
+                     uint64_t size, uint32_t attrs);
+
+/**
+ * @brief Tabelas do boot: mapa identidade da RAM do mapa de memória, do kernel
+ * * (CONFIG_MEM_BASE_ADDR, executável) e da região ramdisk + arena.
+ * * Também executáveis: a memória do loader (ARC_MEM_TYPE_LOADER) e, no x86_64,
+ * * o primeiro 1 MiB. O Local APIC (x86_64) e o UART (ARM64) entram como
+ * * BL_PT_DEVICE; no x86_64 o console serial é por porta de I/O.
+ * * Sem 'info' as tabelas não cobririam o loader nem sua pilha: não ative.
+ */
+bool bl_pt_build_boot_tables(BlPageTableBuilder *b, const ArcBootInfo *info,
+                             uint64_t kernel_size);
+
+/**
+ * @brief Percorre as tabelas e traduz um endereço virtual.
+ * @param page_size Recebe o tamanho da página que mapeia vaddr (pode ser NULL).
+ * @return O endereço físico, ou UINT64_MAX se não mapeado.
+ */
+uint64_t bl_pt_translate(const BlPageTableBuilder *b, uint64_t vaddr, uint64_t *page_size);
+
+/**
+ * @brief Ativa as tabelas na CPU atual (CR3 / TTBR0_EL1 + MAIR/TCR).
+ */
+void bl_pt_activate(const BlPageTableBuilder *b);
+
+#ifdef BL_PT_HOSTED
+// Autoteste das tabelas do boot no host (paging_test.c)
+int bl_pt_run_selftest(void);
+#endif
+
+#endif // LIBBOOTLOADER_PAGING_H
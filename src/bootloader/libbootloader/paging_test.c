@@ -0,0 +1,234 @@
+// src/bootloader/libbootloader/paging_test.c
+// Autoteste do construtor das tabelas de página do boot (modo hosted).
+//
+// Compilar junto com paging.c e utils.c, com -DBL_PT_HOSTED: as tabelas vêm de
+// um pool do processo e o "endereço físico" de cada uma é o seu ponteiro, como
+// no mapa identidade do boot. Nada é ativado; as tabelas só são percorridas.
+
+#ifdef BL_PT_HOSTED
+
+#include "paging.h"
+#include <stdio.h>
+#include <string.h>
+
+#define PT_TEST_POOL_PAGES 128
+#define PT_TEST_ADDR_MASK  0x0000FFFFFFFFF000ull
+
+// Bits conferidos nas folhas
+#define PT_TEST_X86_PCD    (1ull << 4)
+#define PT_TEST_X86_NX     (1ull << 63)
+#define PT_TEST_A64_DEV    (1ull << 2)
+#define PT_TEST_A64_PXN    (1ull << 53)
+
+#define GiB (1ull << 30)
+#define MiB (1ull << 20)
+
+static uint64_t pt_test_pool[PT_TEST_POOL_PAGES][BL_PT_ENTRIES] __attribute__((aligned(4096)));
+static uint32_t pt_test_used;
+
+static uint64_t pt_test_alloc(void *ctx) {
+    (void)ctx;
+    if (pt_test_used >= PT_TEST_POOL_PAGES) {
+        return 0;
+    }
+    uint64_t *page = pt_test_pool[pt_test_used++];
+    memset(page, 0, BL_PT_SIZE_4K);
+    return (uint64_t)(uintptr_t)page;
+}
+
+// Mapa sintético (além da janela do kernel em CONFIG_MEM_BASE_ADDR):
+//  - RAM de 1 MiB a 2 GiB: 4 KiB até 2 MiB, blocos de 2 MiB até 1 GiB, 1 GiB depois
+//  - RAM de 4 GiB a 5 GiB + 12 KiB: um bloco de 1 GiB e três páginas de borda
+//  - Reservado em 3 GiB (pode ser MMIO): fora das tabelas
+//  - Loader em 6 GiB + 20 KiB, desalinhado: só 4 KiB, executável
+//  - Ramdisk + arena em 5 GiB + 2 MiB, alinhados a 2 MiB
+#define PT_TEST_LOADER_BASE (6 * GiB + 0x5000)
+#define PT_TEST_RAMDISK     (5 * GiB + 2 * MiB)
+
+static const ArcMemRegion pt_test_regions[] = {
+    { 1 * MiB, 2 * GiB - 1 * MiB, 1 },
+    { 4 * GiB, 1 * GiB + 0x3000, 1 },
+    { 3 * GiB, 256 * MiB, 2 },
+    { PT_TEST_LOADER_BASE, 2 * MiB, ARC_MEM_TYPE_LOADER },
+};
+
+static void pt_test_info(ArcBootInfo *info) {
+    memset(info, 0, sizeof(*info));
+    info->magic = ARC_BOOT_INFO_MAGIC;
+    info->version = ARC_BOOT_INFO_VERSION;
+    info->mem_region_count = sizeof(pt_test_regions) / sizeof(pt_test_regions[0]);
+    info->mem_regions_paddr = (uint64_t)(uintptr_t)pt_test_regions;
+    info->ramdisk_paddr = PT_TEST_RAMDISK;
+    info->ramdisk_size = 2 * MiB;
+    info->arena_paddr = PT_TEST_RAMDISK + 2 * MiB;
+    info->arena_size = 4 * MiB;
+}
+
+// Percorre as tabelas por conta própria (sem bl_pt_translate) e devolve a
+// folha que mapeia vaddr, com o tamanho da página; 0 se não mapeado.
+static uint64_t pt_test_leaf(const BlPageTableBuilder *b, uint64_t vaddr, uint64_t *size) {
+    const uint64_t *table = (const uint64_t *)(uintptr_t)b->root;
+
+    for (int level = 0; level <= 3; level++) {
+        uint32_t shift = 39 - 9 * (uint32_t)level;
+        uint64_t e = table[(vaddr >> shift) & (BL_PT_ENTRIES - 1)];
+        if (!(e & 1)) {
+            return 0;
+        }
+        bool is_table;
+        if (level == 3) {
+            is_table = false;
+        } else if (b->format == BL_PT_FORMAT_X86_64) {
+            is_table = level == 0 || !(e & (1ull << 7));   // PS
+        } else {
+            is_table = (e & (1ull << 1)) != 0;             // Descritor de tabela
+        }
+        if (!is_table) {
+            *size = 1ull << shift;
+            return e;
+        }
+        table = (const uint64_t *)(uintptr_t)(e & PT_TEST_ADDR_MASK);
+    }
+    return 0;
+}
+
+// Confere que vaddr é mapa identidade com página 'size', executável ou não e
+// com atributo de dispositivo ou não
+static bool pt_test_expect(const BlPageTableBuilder *b, const char *what, uint64_t vaddr,
+                           uint64_t size, bool exec, bool device) {
+    uint64_t leaf_size = 0;
+    uint64_t leaf = pt_test_leaf(b, vaddr, &leaf_size);
+    uint64_t tsize = 0;
+    uint64_t paddr = bl_pt_translate(b, vaddr, &tsize);
+    bool x86 = b->format == BL_PT_FORMAT_X86_64;
+    bool leaf_exec = x86 ? !(leaf & PT_TEST_X86_NX) : !(leaf & PT_TEST_A64_PXN);
+    bool leaf_device = x86 ? (leaf & PT_TEST_X86_PCD) != 0 : (leaf & PT_TEST_A64_DEV) != 0;
+
+    if (leaf == 0 || paddr != vaddr || leaf_size != size || tsize != size ||
+        leaf_exec != exec || leaf_device != device ||
+        (leaf & PT_TEST_ADDR_MASK & ~(size - 1)) != (vaddr & ~(size - 1))) {
+        printf("TEST FAILED: %s (%s): 0x%llx -> 0x%llx, pagina 0x%llx/0x%llx (esperado 0x%llx), exec %d, dev %d\n",
+               what, x86 ? "x86_64" : "arm64", (unsigned long long)vaddr, (unsigned long long)paddr,
+               (unsigned long long)leaf_size, (unsigned long long)tsize, (unsigned long long)size,
+               leaf_exec, leaf_device);
+        return false;
+    }
+    return true;
+}
+
+static bool pt_test_unmapped(const BlPageTableBuilder *b, const char *what, uint64_t vaddr) {
+    uint64_t size = 0;
+    if (pt_test_leaf(b, vaddr, &size) != 0 || bl_pt_translate(b, vaddr, NULL) != UINT64_MAX) {
+        printf("TEST FAILED: %s: 0x%llx nao deveria estar mapeado.\n", what, (unsigned long long)vaddr);
+        return false;
+    }
+    return true;
+}
+
+// Tabelas do boot para o mapa sintético em um formato
+static bool pt_test_format(BlPtFormat format, bool allow_1g) {
+    BlPageTableBuilder b;
+    ArcBootInfo info;
+    bool x86 = format == BL_PT_FORMAT_X86_64;
+
+    pt_test_used = 0;
+    pt_test_info(&info);
+    if (!bl_pt_init(&b, format, pt_test_alloc, NULL)) {
+        printf("TEST FAILED: bl_pt_init.\n");
+        return false;
+    }
+    // Independente da CPU do host
+    b.allow_1g = allow_1g;
+    b.use_nx = x86;
+    if (!bl_pt_build_boot_tables(&b, &info, BL_PT_KERNEL_WINDOW)) {
+        printf("TEST FAILED: bl_pt_build_boot_tables.\n");
+        return false;
+    }
+
+    uint64_t big = allow_1g ? BL_PT_SIZE_1G : BL_PT_SIZE_2M;
+    bool ok = true;
+
+    // RAM: folhas grandes no meio, 4 KiB só na borda desalinhada
+    ok &= pt_test_expect(&b, "RAM borda de 1 MiB", 1 * MiB, BL_PT_SIZE_4K, false, false);
+    ok &= pt_test_expect(&b, "RAM 2 MiB", 2 * MiB + 0x1234, BL_PT_SIZE_2M, false, false);
+    ok &= pt_test_expect(&b, "RAM 1 GiB", 1 * GiB + 0x123456, big, false, false);
+    ok &= pt_test_expect(&b, "RAM alta", 4 * GiB + 0x5000, big, false, false);
+    ok &= pt_test_expect(&b, "RAM alta, borda", 5 * GiB + 0x2000, BL_PT_SIZE_4K, false, false);
+    ok &= pt_test_unmapped(&b, "RAM alta, fim", 5 * GiB + 0x3000);
+
+    // Kernel: janela executável de 2 MiB sobre a RAM em volta
+    ok &= pt_test_expect(&b, "kernel", CONFIG_MEM_BASE_ADDR + 0x10, BL_PT_SIZE_2M, true, false);
+    ok &= pt_test_expect(&b, "kernel, fim", CONFIG_MEM_BASE_ADDR + BL_PT_KERNEL_WINDOW - 1,
+                         BL_PT_SIZE_2M, true, false);
+
+    // Loader desalinhado: 4 KiB executáveis do começo ao fim
+    ok &= pt_test_expect(&b, "loader", PT_TEST_LOADER_BASE, BL_PT_SIZE_4K, true, false);
+    ok &= pt_test_expect(&b, "loader, fim", PT_TEST_LOADER_BASE + 2 * MiB - 1, BL_PT_SIZE_4K, true, false);
+    ok &= pt_test_unmapped(&b, "depois do loader", PT_TEST_LOADER_BASE + 2 * MiB);
+
+    // Ramdisk + arena: blocos de 2 MiB, não executáveis
+    ok &= pt_test_expect(&b, "ramdisk", PT_TEST_RAMDISK, BL_PT_SIZE_2M, false, false);
+    ok &= pt_test_expect(&b, "arena", PT_TEST_RAMDISK + 5 * MiB, BL_PT_SIZE_2M, false, false);
+
+    // Reservado fica de fora
+    ok &= pt_test_unmapped(&b, "reservado", 3 * GiB + 0x1000);
+
+    if (x86) {
+        // Primeiro 1 MiB executável (trampolim dos APs em 0x8000) e o Local APIC
+        ok &= pt_test_expect(&b, "trampolim", 0x8000, BL_PT_SIZE_4K, true, false);
+        ok &= pt_test_expect(&b, "LAPIC", CONFIG_LAPIC_BASE_ADDR, BL_PT_SIZE_4K, false, true);
+    } else {
+        // Sem memória baixa no ARM64; o UART parte o bloco de 2 MiB da RAM em volta
+        ok &= pt_test_unmapped(&b, "memoria baixa", 0x8000);
+        ok &= pt_test_expect(&b, "UART", CONFIG_UART_BASE_ADDR, BL_PT_SIZE_4K, false, true);
+        ok &= pt_test_expect(&b, "RAM ao lado do UART", CONFIG_UART_BASE_ADDR + BL_PT_SIZE_4K,
+                             BL_PT_SIZE_4K, false, false);
+    }
+
+    if (ok && (b.mapped_4k == 0 || b.mapped_2m == 0 || (allow_1g && b.mapped_1g < 2))) {
+        printf("TEST FAILED: Contadores: 1G=%llu 2M=%llu 4K=%llu.\n", (unsigned long long)b.mapped_1g,
+               (unsigned long long)b.mapped_2m, (unsigned long long)b.mapped_4k);
+        ok = false;
+    }
+    return ok;
+}
+
+/**
+ * @brief Monta as tabelas do boot nos dois formatos para um mapa de memória
+ * sintético mais a janela em CONFIG_MEM_BASE_ADDR, percorre-as e confere o
+ * tamanho de cada folha (1 GiB / 2 MiB / 4 KiB nas bordas), as traduções e os
+ * atributos (executável, dispositivo). No x86_64 repete sem páginas de 1 GiB.
+ * @return 0 se o teste for bem-sucedido, 1 caso contrário.
+ */
+int bl_pt_run_selftest(void) {
+    printf("--- ARCANOS BOOT PAGING: SELF-TEST ---\n");
+
+    if (!pt_test_format(BL_PT_FORMAT_X86_64, true) ||
+        !pt_test_format(BL_PT_FORMAT_X86_64, false) ||
+        !pt_test_format(BL_PT_FORMAT_ARM64, true)) {
+        return 1;
+    }
+
+    // Sem mapa de memória só a janela do kernel (e, no x86_64, a memória baixa
+    // e o LAPIC) existe: o chamador não deve ativar essas tabelas
+    BlPageTableBuilder b;
+    pt_test_used = 0;
+    if (!bl_pt_init(&b, BL_PT_FORMAT_ARM64, pt_test_alloc, NULL) ||
+        !bl_pt_build_boot_tables(&b, NULL, BL_PT_KERNEL_WINDOW) ||
+        !pt_test_expect(&b, "kernel sem mapa", CONFIG_MEM_BASE_ADDR, BL_PT_SIZE_2M, true, false) ||
+        !pt_test_unmapped(&b, "RAM sem mapa", 2 * MiB)) {
+        return 1;
+    }
+
+    printf("--- ARCANOS BOOT PAGING: TESTE BEM-SUCEDIDO ---\n");
+    return 0;
+}
+
+// Opcional: Função main simulada para execução direta do teste
+/*
+int main() {
+    return bl_pt_run_selftest();
+}
+*/
+
+#endif // BL_PT_HOSTED
@@ -0,0 +1,122 @@
+#include "smp.h"
+#include "mem.h"
+#include <stdatomic.h>
+
+// =======================================================
+// Despacho de trabalho entre núcleos (parte independente de arquitetura)
+// =======================================================
+
+// Tempo máximo (em iterações de bl_cpu_relax) esperando os APs ficarem online
+#define BL_SMP_ONLINE_SPINS (50u * 1000 * 1000)
+
+// Abaixo disso, dividir um memset entre núcleos não compensa
+#define BL_SMP_MEMSET_MIN (1024 * 1024)
+
+// Caixa de correio de um AP (ArcSmpMailbox, boot_info.h): o BSP publica
+// (fn, arg) e incrementa 'seq'; o AP executa e copia 'seq' para 'done'.
+// Uma linha de cache por CPU. O layout é compartilhado com o kernel.
+typedef ArcSmpMailbox BlCpuMailbox;
+
+static BlCpuMailbox mailboxes[BL_MAX_CPUS];
+static uint8_t ap_stacks[BL_MAX_CPUS][BL_AP_STACK_SIZE] __attribute__((aligned(16)));
+static atomic_uint cpus_online = 1; // O BSP já está online
+static uint32_t cpu_count = 1;
+
+
+void bl_smp_ap_entry(uint32_t cpu) {
+    BlCpuMailbox *mb = &mailboxes[cpu];
+    atomic_fetch_add(&cpus_online, 1);
+
+    // Laço ocioso: espera trabalho na própria caixa de correio
+    for (;;) {
+        uint32_t seq = atomic_load_explicit(&mb->seq, memory_order_acquire);
+        if (seq == atomic_load_explicit(&mb->done, memory_order_relaxed)) {
+            bl_cpu_relax();
+            continue;
+        }
+        mb->fn(cpu, cpu_count, mb->arg);
+        atomic_store_explicit(&mb->done, seq, memory_order_release);
+    }
+}
+
+void bl_smp_init(void) {
+    uint32_t started = arch_smp_start_aps(&ap_stacks[0][0], BL_AP_STACK_SIZE, BL_MAX_CPUS);
+
+    for (uint32_t spins = 0; spins < BL_SMP_ONLINE_SPINS; spins++) {
+        if (atomic_load(&cpus_online) >= started + 1) {
+            break;
+        }
+        bl_cpu_relax();
+    }
+    cpu_count = atomic_load(&cpus_online);
+}
+
+uint32_t bl_smp_cpu_count(void) {
+    return cpu_count;
+}
+
+void bl_smp_wait(uint32_t cpu) {
+    if (cpu == 0 || cpu >= cpu_count) {
+        return;
+    }
+    BlCpuMailbox *mb = &mailboxes[cpu];
+    while (atomic_load_explicit(&mb->done, memory_order_acquire) !=
+           atomic_load_explicit(&mb->seq, memory_order_relaxed)) {
+        bl_cpu_relax();
+    }
+}
+
+bool bl_smp_dispatch(uint32_t cpu, BlSmpWorkFn fn, void *arg) {
+    if (cpu == 0 || cpu >= cpu_count || fn == NULL) {
+        return false;
+    }
+    BlCpuMailbox *mb = &mailboxes[cpu];
+
+    bl_smp_wait(cpu); // Um trabalho por vez em cada AP
+    mb->fn = fn;
+    mb->arg = arg;
+    atomic_fetch_add_explicit(&mb->seq, 1, memory_order_release);
+    return true;
+}
+
+void bl_smp_run_on_all(BlSmpWorkFn fn, void *arg) {
+    for (uint32_t cpu = 1; cpu < cpu_count; cpu++) {
+        bl_smp_dispatch(cpu, fn, arg);
+    }
+    fn(0, cpu_count, arg);
+    for (uint32_t cpu = 1; cpu < cpu_count; cpu++) {
+        bl_smp_wait(cpu);
+    }
+}
+
+typedef struct {
+    uint8_t *dest;
+    int val;
+    size_t count;
+} BlSmpMemsetJob;
+
+static void bl_smp_memset_work(uint32_t cpu, uint32_t ncpus, void *arg) {
+    BlSmpMemsetJob *job = arg;
+    // Fatias alinhadas a 64 bytes para que dois núcleos não dividam uma linha de cache
+    size_t chunk = ((job->count / ncpus) + 63) & ~(size_t)63;
+    size_t start = chunk * cpu;
+    if (start >= job->count) {
+        return;
+    }
+    size_t len = job->count - start < chunk ? job->count - start : chunk;
+    bl_memset(job->dest + start, job->val, len);
+}
+
+void bl_smp_memset(void *dest, int val, size_t count) {
+    if (cpu_count == 1 || count < BL_SMP_MEMSET_MIN) {
+        bl_memset(dest, val, count);
+        return;
+    }
+    BlSmpMemsetJob job = { (uint8_t *)dest, val, count };
+    bl_smp_run_on_all(bl_smp_memset_work, &job);
+}
+
+void bl_smp_publish(ArcBootInfo *info) {
+    info->cpu_count = cpu_count;
+    info->smp_mailboxes_paddr = cpu_count > 1 ? (uint64_t)(uintptr_t)mailboxes : 0;
+}
@@ -0,0 +1,81 @@
+#ifndef LIBBOOTLOADER_SMP_H
+#define LIBBOOTLOADER_SMP_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "boot_info.h"
+
+// Bring-up SMP do bootloader: os núcleos secundários (APs) são acordados cedo,
+// ficam em um laço ocioso com pilha própria e executam trabalhos despachados
+// pelo núcleo de boot (BSP) antes do scheduler do kernel existir.
+
+#define BL_MAX_CPUS       ARC_SMP_MAX_CPUS
+#define BL_AP_STACK_SIZE  (16 * 1024)
+
+// Trabalho executado em um núcleo: cpu = índice (BSP = 0), ncpus = total online.
+typedef void (*BlSmpWorkFn)(uint32_t cpu, uint32_t ncpus, void *arg);
+
+// Dica de espera ativa para a CPU (laços de polling)
+static inline void bl_cpu_relax(void) {
+#if defined(__x86_64__)
+    __asm__ volatile("pause");
+#elif defined(__aarch64__)
+    __asm__ volatile("yield");
+#endif
+}
+
+/**
+ * @brief Acorda os APs (INIT-SIPI-SIPI no x86_64, PSCI CPU_ON no ARM64).
+ * * Retorna quando todos os APs iniciados chegaram ao laço ocioso (ou no timeout).
+ */
+void bl_smp_init(void);
+
+/**
+ * @brief Número de núcleos online (inclui o BSP).
+ */
+uint32_t bl_smp_cpu_count(void);
+
+/**
+ * @brief Envia um trabalho para um AP ocioso (assíncrono).
+ * @return false se o índice não corresponde a um AP online.
+ */
+bool bl_smp_dispatch(uint32_t cpu, BlSmpWorkFn fn, void *arg);
+
+/**
+ * @brief Espera o AP terminar o último trabalho despachado.
+ */
+void bl_smp_wait(uint32_t cpu);
+
+/**
+ * @brief Executa fn em todos os núcleos (inclusive o BSP) e espera todos.
+ */
+void bl_smp_run_on_all(BlSmpWorkFn fn, void *arg);
+
+/**
+ * @brief bl_memset dividido entre todos os núcleos (ex: zerar regiões grandes).
+ */
+void bl_smp_memset(void *dest, int val, size_t count);
+
+/**
+ * @brief Entrega ao kernel os núcleos ociosos (cpu_count e caixas de correio).
+ */
+void bl_smp_publish(ArcBootInfo *info);
+
+// ----------------------------------------------------
+// Interface com a arquitetura (src/bootloader/arch/*/smp.c)
+// ----------------------------------------------------
+
+/**
+ * @brief Inicia os APs. Cada AP deve entrar em bl_smp_ap_entry(índice) usando a
+ * * pilha stacks + (índice + 1) * stack_size (topo), com índices 1..max_cpus-1.
+ * @return Número de APs que foram iniciados.
+ */
+uint32_t arch_smp_start_aps(uint8_t *stacks, size_t stack_size, uint32_t max_cpus);
+
+/**
+ * @brief Ponto de entrada em C dos APs (nunca retorna).
+ */
+void bl_smp_ap_entry(uint32_t cpu);
+
+#endif // LIBBOOTLOADER_SMP_H
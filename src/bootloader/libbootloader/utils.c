@@ -1,24 +1,334 @@
 #include "mem.h" // Inclui as funções de memória definidas acima
 #include <stdint.h>
 #include <stddef.h>
+#include <stdbool.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h> // SSE2/AVX2 (habilitados por função via target())
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 
 // =======================================================
 // Implementação de Funções de Memória (para ser usada pelo bootloader)
-// Estas são implementações simples, sem otimizações de cache da CPU (por enquanto).
 // =======================================================
+//
+// Despacho por classe de tamanho:
+//  - Pequeno (< BL_MEM_SMALL_MAX): stores de 8/4 bytes sobrepostos, sem laço vetorial.
+//  - Médio: laço vetorial (AVX2/SSE2 no x86_64, NEON no ARM64) com prólogo e
+//    epílogo não alinhados e corpo com stores alinhados no destino.
+//  - Grande (>= BL_MEM_LARGE_MIN): 'rep movsb/stosb' quando a CPU tem ERMS (x86_64);
+//    zeragem por 'DC ZVA' (ARM64).
+// Antes de bl_mem_init() só o caminho genérico de palavras (8 bytes) é usado.
+
+#define BL_MEM_SMALL_MAX 64
+#define BL_MEM_LARGE_MIN 2048
+
+// Recursos detectados por bl_mem_init()
+static struct {
+    bool ready;
+    bool erms;          // x86_64: Enhanced REP MOVSB/STOSB
+    bool avx2;          // x86_64: AVX2 suportado e habilitado pelo XCR0
+    uint32_t zva_block; // ARM64: tamanho do bloco do DC ZVA (0 = proibido)
+} bl_mem_caps;
+
+
+static inline void bl_store64(void *p, uint64_t v) { __builtin_memcpy(p, &v, 8); }
+static inline void bl_store32(void *p, uint32_t v) { __builtin_memcpy(p, &v, 4); }
+static inline uint64_t bl_load64(const void *p) { uint64_t v; __builtin_memcpy(&v, p, 8); return v; }
+static inline uint32_t bl_load32(const void *p) { uint32_t v; __builtin_memcpy(&v, p, 4); return v; }
+
+// ----- Caminho genérico (qualquer arquitetura) -----
+
+static void bl_memset_small(uint8_t *d, uint8_t val, size_t count) {
+    uint64_t v = 0x0101010101010101ull * val;
+
+    if (count >= 8) {
+        for (size_t i = 0; i + 8 <= count; i += 8) {
+            bl_store64(d + i, v);
+        }
+        bl_store64(d + count - 8, v); // Epílogo sobreposto
+    } else if (count >= 4) {
+        bl_store32(d, (uint32_t)v);
+        bl_store32(d + count - 4, (uint32_t)v);
+    } else {
+        while (count--) {
+            *d++ = val;
+        }
+    }
+}
+
+static void bl_memcpy_small(uint8_t *d, const uint8_t *s, size_t count) {
+    if (count >= 8) {
+        for (size_t i = 0; i + 8 <= count; i += 8) {
+            bl_store64(d + i, bl_load64(s + i));
+        }
+        bl_store64(d + count - 8, bl_load64(s + count - 8));
+    } else if (count >= 4) {
+        uint32_t head = bl_load32(s);
+        uint32_t tail = bl_load32(s + count - 4);
+        bl_store32(d, head);
+        bl_store32(d + count - 4, tail);
+    } else {
+        while (count--) {
+            *d++ = *s++;
+        }
+    }
+}
+
+// Corpo em palavras de 8 bytes com destino alinhado (count >= 8).
+static void bl_memset_words(uint8_t *d, uint8_t val, size_t count) {
+    uint64_t v = 0x0101010101010101ull * val;
+    uint8_t *end = d + count;
+
+    bl_store64(d, v);
+    for (uint8_t *p = (uint8_t *)(((uintptr_t)d + 8) & ~(uintptr_t)7); p + 8 <= end; p += 8) {
+        bl_store64(p, v);
+    }
+    bl_store64(end - 8, v);
+}
+
+static void bl_memcpy_words(uint8_t *d, const uint8_t *s, size_t count) {
+    uint64_t head = bl_load64(s);
+    uint64_t tail = bl_load64(s + count - 8);
+    size_t skew = 8 - ((uintptr_t)d & 7);
+
+    for (size_t i = skew; i + 8 <= count; i += 8) {
+        bl_store64(d + i, bl_load64(s + i));
+    }
+    bl_store64(d, head);
+    bl_store64(d + count - 8, tail);
+}
+
+// ----- x86_64 -----
+#if defined(__x86_64__)
+
+static inline void bl_cpuid(uint32_t leaf, uint32_t sub, uint32_t r[4]) {
+    __asm__ volatile("cpuid" : "=a"(r[0]), "=b"(r[1]), "=c"(r[2]), "=d"(r[3]) : "a"(leaf), "c"(sub));
+}
+
+static void bl_mem_detect(void) {
+    uint32_t r[4];
+    bl_cpuid(0, 0, r);
+    uint32_t max_leaf = r[0];
+
+    bl_cpuid(1, 0, r);
+    bool osxsave = (r[2] >> 27) & 1;
+    bool avx = (r[2] >> 28) & 1;
+
+    if (max_leaf >= 7) {
+        bl_cpuid(7, 0, r);
+        bl_mem_caps.erms = (r[1] >> 9) & 1;
+        bl_mem_caps.avx2 = (r[1] >> 5) & 1;
+    }
+
+    // AVX2 só é utilizável se o estado YMM estiver habilitado no XCR0 (XMM|YMM).
+    if (bl_mem_caps.avx2) {
+        uint32_t lo = 0, hi = 0;
+        if (osxsave && avx) {
+            __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+        }
+        bl_mem_caps.avx2 = (lo & 0x6) == 0x6;
+    }
+}
+
+static inline void bl_rep_stosb(uint8_t *d, uint8_t val, size_t count) {
+    __asm__ volatile("rep stosb" : "+D"(d), "+c"(count) : "a"(val) : "memory");
+}
+
+static inline void bl_rep_movsb(uint8_t *d, const uint8_t *s, size_t count) {
+    __asm__ volatile("rep movsb" : "+D"(d), "+S"(s), "+c"(count) : : "memory");
+}
+
+__attribute__((target("avx2")))
+static void bl_memset_avx2(uint8_t *d, uint8_t val, size_t count) {
+    __m256i v = _mm256_set1_epi8((char)val);
+    uint8_t *end = d + count - 32;
+
+    _mm256_storeu_si256((__m256i *)d, v);
+    for (uint8_t *p = (uint8_t *)(((uintptr_t)d + 32) & ~(uintptr_t)31); p < end; p += 32) {
+        _mm256_store_si256((__m256i *)p, v);
+    }
+    _mm256_storeu_si256((__m256i *)end, v);
+}
+
+__attribute__((target("avx2")))
+static void bl_memcpy_avx2(uint8_t *d, const uint8_t *s, size_t count) {
+    __m256i head = _mm256_loadu_si256((const __m256i *)s);
+    __m256i tail = _mm256_loadu_si256((const __m256i *)(s + count - 32));
+    size_t skew = 32 - ((uintptr_t)d & 31);
+
+    for (size_t i = skew; i + 32 < count; i += 32) {
+        _mm256_store_si256((__m256i *)(d + i), _mm256_loadu_si256((const __m256i *)(s + i)));
+    }
+    _mm256_storeu_si256((__m256i *)d, head);
+    _mm256_storeu_si256((__m256i *)(d + count - 32), tail);
+}
+
+__attribute__((target("sse2")))
+static void bl_memset_sse2(uint8_t *d, uint8_t val, size_t count) {
+    __m128i v = _mm_set1_epi8((char)val);
+    uint8_t *end = d + count - 16;
+
+    _mm_storeu_si128((__m128i *)d, v);
+    for (uint8_t *p = (uint8_t *)(((uintptr_t)d + 16) & ~(uintptr_t)15); p < end; p += 16) {
+        _mm_store_si128((__m128i *)p, v);
+    }
+    _mm_storeu_si128((__m128i *)end, v);
+}
+
+__attribute__((target("sse2")))
+static void bl_memcpy_sse2(uint8_t *d, const uint8_t *s, size_t count) {
+    __m128i head = _mm_loadu_si128((const __m128i *)s);
+    __m128i tail = _mm_loadu_si128((const __m128i *)(s + count - 16));
+    size_t skew = 16 - ((uintptr_t)d & 15);
+
+    for (size_t i = skew; i + 16 < count; i += 16) {
+        _mm_store_si128((__m128i *)(d + i), _mm_loadu_si128((const __m128i *)(s + i)));
+    }
+    _mm_storeu_si128((__m128i *)d, head);
+    _mm_storeu_si128((__m128i *)(d + count - 16), tail);
+}
+
+static void bl_memset_arch(uint8_t *d, uint8_t val, size_t count) {
+    if (count >= BL_MEM_LARGE_MIN && bl_mem_caps.erms) {
+        bl_rep_stosb(d, val, count);
+    } else if (bl_mem_caps.avx2) {
+        bl_memset_avx2(d, val, count);
+    } else {
+        bl_memset_sse2(d, val, count); // SSE2 é baseline no x86_64
+    }
+}
+
+static void bl_memcpy_arch(uint8_t *d, const uint8_t *s, size_t count) {
+    if (count >= BL_MEM_LARGE_MIN && bl_mem_caps.erms) {
+        bl_rep_movsb(d, s, count);
+    } else if (bl_mem_caps.avx2) {
+        bl_memcpy_avx2(d, s, count);
+    } else {
+        bl_memcpy_sse2(d, s, count);
+    }
+}
+
+// ----- ARM64 -----
+#elif defined(__aarch64__)
+
+static void bl_mem_detect(void) {
+    uint64_t dczid;
+    __asm__ volatile("mrs %0, dczid_el0" : "=r"(dczid));
+    // DZP (bit 4) proíbe DC ZVA; BS (bits 3:0) = log2 do bloco em palavras de 4 bytes.
+    bl_mem_caps.zva_block = (dczid & 0x10) ? 0 : (4u << (dczid & 0xF));
+}
+
+#if defined(__ARM_NEON)
+static void bl_memset_neon(uint8_t *d, uint8_t val, size_t count) {
+    uint8x16_t v = vdupq_n_u8(val);
+    uint8_t *end = d + count - 16;
+
+    vst1q_u8(d, v);
+    for (uint8_t *p = (uint8_t *)(((uintptr_t)d + 16) & ~(uintptr_t)15); p < end; p += 16) {
+        vst1q_u8(p, v);
+    }
+    vst1q_u8(end, v);
+}
+
+static void bl_memcpy_neon(uint8_t *d, const uint8_t *s, size_t count) {
+    uint8x16_t head = vld1q_u8(s);
+    uint8x16_t tail = vld1q_u8(s + count - 16);
+    size_t skew = 16 - ((uintptr_t)d & 15);
+
+    for (size_t i = skew; i + 16 < count; i += 16) {
+        vst1q_u8(d + i, vld1q_u8(s + i));
+    }
+    vst1q_u8(d, head);
+    vst1q_u8(d + count - 16, tail);
+}
+#define bl_memset_vec bl_memset_neon
+#define bl_memcpy_vec bl_memcpy_neon
+#else
+#define bl_memset_vec bl_memset_words
+#define bl_memcpy_vec bl_memcpy_words
+#endif
+
+// Zera usando DC ZVA no trecho alinhado ao bloco; bordas pelo laço vetorial.
+static void bl_memzero_zva(uint8_t *d, size_t count) {
+    uintptr_t block = bl_mem_caps.zva_block;
+    uint8_t *start = (uint8_t *)(((uintptr_t)d + block - 1) & ~(block - 1));
+    uint8_t *stop = (uint8_t *)(((uintptr_t)(d + count)) & ~(block - 1));
+
+    if (start - d >= BL_MEM_SMALL_MAX) {
+        bl_memset_vec(d, 0, (size_t)(start - d));
+    } else {
+        bl_memset_small(d, 0, (size_t)(start - d));
+    }
+    for (uint8_t *p = start; p < stop; p += block) {
+        __asm__ volatile("dc zva, %0" : : "r"(p) : "memory");
+    }
+    size_t rest = (size_t)(d + count - stop);
+    if (rest >= BL_MEM_SMALL_MAX) {
+        bl_memset_vec(stop, 0, rest);
+    } else {
+        bl_memset_small(stop, 0, rest);
+    }
+}
+
+static void bl_memset_arch(uint8_t *d, uint8_t val, size_t count) {
+    // Exige ao menos 2 blocos para que sobre um trecho alinhado útil.
+    if (val == 0 && bl_mem_caps.zva_block != 0 && count >= BL_MEM_LARGE_MIN &&
+        count >= 2 * (size_t)bl_mem_caps.zva_block) {
+        bl_memzero_zva(d, count);
+    } else {
+        bl_memset_vec(d, val, count);
+    }
+}
+
+static void bl_memcpy_arch(uint8_t *d, const uint8_t *s, size_t count) {
+    bl_memcpy_vec(d, s, count);
+}
+
+// ----- Outras arquiteturas -----
+#else
+
+static void bl_mem_detect(void) {}
+
+static void bl_memset_arch(uint8_t *d, uint8_t val, size_t count) {
+    bl_memset_words(d, val, count);
+}
+
+static void bl_memcpy_arch(uint8_t *d, const uint8_t *s, size_t count) {
+    bl_memcpy_words(d, s, count);
+}
+
+#endif
+
+
+void bl_mem_init(void) {
+    bl_mem_detect();
+    bl_mem_caps.ready = true;
+}
 
 void bl_memset(void *dest, int val, size_t count) {
-    char *d = (char *)dest;
-    while (count--) {
-        *d++ = (char)val;
+    uint8_t *d = (uint8_t *)dest;
+
+    if (count < BL_MEM_SMALL_MAX) {
+        bl_memset_small(d, (uint8_t)val, count);
+    } else if (bl_mem_caps.ready) {
+        bl_memset_arch(d, (uint8_t)val, count);
+    } else {
+        bl_memset_words(d, (uint8_t)val, count);
     }
 }
 
 void bl_memcpy(void *dest, const void *src, size_t count) {
-    char *d = (char *)dest;
-    const char *s = (const char *)src;
-    while (count--) {
-        *d++ = *s++;
+    uint8_t *d = (uint8_t *)dest;
+    const uint8_t *s = (const uint8_t *)src;
+
+    if (count < BL_MEM_SMALL_MAX) {
+        bl_memcpy_small(d, s, count);
+    } else if (bl_mem_caps.ready) {
+        bl_memcpy_arch(d, s, count);
+    } else {
+        bl_memcpy_words(d, s, count);
     }
 }
 
@@ -4,51 +4,64 @@
 #include "is_responding.h"
 #include "../kernel/kernl/printk/printk.h" // Para logging
 #include "../kernel/kernl/kernel_monitor/monitor.h" // Para integração com o Monitor
+#include <stddef.h> // Para NULL
 
-#define MAX_TESTS 15
-static ComponentResponseTest registered_tests[MAX_TESTS];
-static uint32_t test_count = 0;
+extern uint64_t arch_get_current_ms();
+
+// Os testes não têm array próprio: vivem no registro unificado do Kernel Monitor,
+// junto com os SubsystemTrackers (ver watchdog.c).
 
 
 void irt_register_test(ComponentResponseTest *test) {
-    if (test_count < MAX_TESTS) {
-        test->id = test_count + 1;
-        registered_tests[test_count] = *test; // Copia a estrutura
-        test_count++;
-        
-        // Opcional: Integrar com o Kernel Monitor (watchdog)
-        // Criar um SubsystemTracker e registrar no km_register_subsystem
-        
+    test->id = km_register_entry(test->name, test->max_delay_ms,
+                                 test->test_function, test->max_latency_ms);
+
+    if (test->id != 0) {
         KERN_INFO("IR Test: Componente '%s' registrado (ID: %u).", test->name, test->id);
     } else {
-        KERN_ERR("IR Test: Falha ao registrar '%s'. Limite de testes atingido.", test->name);
+        KERN_ERR("IR Test: Falha ao registrar '%s' no Kernel Monitor.", test->name);
     }
 }
 
 
 bool irt_check_all_components() {
     bool all_ok = true;
+    uint32_t count = km_entry_count();
     
-    for (uint32_t i = 0; i < test_count; i++) {
-        ComponentResponseTest *test = &registered_tests[i];
+    for (uint32_t id = 1; id <= count; id++) {
+        ResponsivenessTestFn test_function = km_entry_probe(id);
+        
+        // Entradas sem sonda são SubsystemTrackers puros (reportam por conta própria).
+        if (test_function == NULL) {
+            continue;
+        }
+        
+        const char *name = km_entry_name(id);
+        uint64_t max_latency_ms = km_entry_max_latency(id);
         
         uint64_t start_time = arch_get_current_ms();
         
         // EXECUÇÃO DO TESTE
-        bool is_responsive = test->test_function();
+        bool is_responsive = test_function();
         
         uint64_t end_time = arch_get_current_ms();
         uint64_t latency = end_time - start_time;
         
         if (!is_responsive) {
             KERN_CRIT("IR Test: Componente '%s' (ID %u) FALHOU no teste de responsividade.", 
-                      test->name, test->id);
+                      name, id);
             all_ok = false;
-        } else if (latency > test->max_latency_ms) {
+            continue;
+        }
+        
+        // Respondeu: conta como heartbeat para o watchdog, mesmo se lento.
+        km_i_am_alive(id);
+        
+        if (latency > max_latency_ms) {
             KERN_WARNING("IR Test: Componente '%s' LENTO (%llu ms). Máximo %llu ms.", 
-                         test->name, latency, test->max_latency_ms);
+                         name, latency, max_latency_ms);
         } else {
-            KERN_DEBUG("IR Test: Componente '%s' OK (%llu ms).", test->name, latency);
+            KERN_DEBUG("IR Test: Componente '%s' OK (%llu ms).", name, latency);
         }
     }
     
@@ -15,6 +15,7 @@ typedef struct {
     uint32_t id;                       // ID único do teste
     ResponsivenessTestFn test_function; // A função de teste
     uint64_t max_latency_ms;           // Latência máxima aceitável para o teste
+    uint64_t max_delay_ms;             // Atraso máximo do watchdog (0 = sem watchdog)
 } ComponentResponseTest;
 
 // =======================================================
@@ -23,12 +24,15 @@ typedef struct {
 
 /**
  * @brief Registra um novo teste de responsividade para um componente.
+ * * O teste entra no registro unificado do Kernel Monitor; test->id recebe o ID
+ * * do monitor (0 se o registro falhar).
  * @param test A estrutura de teste a ser registrada.
  */
 void irt_register_test(ComponentResponseTest *test);
 
 /**
  * @brief Executa todos os testes registrados e retorna o status.
+ * * Cada sonda bem-sucedida alimenta o heartbeat do watchdog (km_i_am_alive).
  * @return TRUE se todos os componentes responderam, FALSE se algum falhou.
  */
 bool irt_check_all_components();
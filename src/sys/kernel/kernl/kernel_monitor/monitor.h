@@ -12,6 +12,10 @@ typedef struct {
     const char *name;           // Nome do subsistema
 } SubsystemTracker;
 
+// Sonda de responsividade associada a uma entrada do registro.
+// Mesma assinatura de ResponsivenessTestFn (is_responding.h).
+typedef bool (*KmProbeFn)(void);
+
 // =======================================================
 // Funções do Kernel Monitor
 // =======================================================
@@ -27,10 +31,29 @@ void km_init_monitor();
  */
 void km_register_subsystem(SubsystemTracker *tracker);
 
+/**
+ * @brief Registra uma entrada no registro unificado do monitor.
+ * * O registro é único e dinâmico (sem limite fixo), compartilhado por
+ * * SubsystemTracker e ComponentResponseTest.
+ * @param name Nome do subsistema (string estática).
+ * @param max_delay_ms Atraso máximo do watchdog (0 = não vigiado pelo watchdog).
+ * @param probe Sonda de responsividade (NULL se não houver).
+ * @param max_latency_ms Latência máxima aceitável da sonda.
+ * @return O ID atribuído (>= 1), ou 0 em caso de falha.
+ */
+uint32_t km_register_entry(const char *name, uint64_t max_delay_ms,
+                           KmProbeFn probe, uint64_t max_latency_ms);
+
 /**
  * @brief O subsistema reporta que está vivo (reseta seu timer).
  * @param id O ID do subsistema.
  */
 void km_i_am_alive(uint32_t id);
 
+// Acesso de leitura ao registro (IDs válidos: 1..km_entry_count()).
+uint32_t km_entry_count(void);
+const char *km_entry_name(uint32_t id);
+KmProbeFn km_entry_probe(uint32_t id);
+uint64_t km_entry_max_latency(uint32_t id);
+
 #endif // ARCANOS_KERNEL_MONITOR_H
@@ -2,22 +2,98 @@
 // Implementação do Watchdog de Software/Hardware.
 
 #include "monitor.h"
+#include <stdatomic.h>
 #include <stdio.h>
-#include <string.h> // Para memcmp/memset
+#include <stdlib.h> // Para malloc/free
+#include <string.h> // Para memcpy/memset
 
 // Funções externas do sistema
 extern void arch_reset_watchdog_timer();
 extern void kernel_panic(const char* message);
+extern uint64_t arch_get_current_ms();
 
-// Array de subsistemas monitorados (tamanho fixo para simplificação)
-#define MAX_SUBSYSTEMS 10
-static SubsystemTracker tracked_subsytems[MAX_SUBSYSTEMS];
-static uint32_t next_id = 1;
+// Registro unificado de subsistemas, em layout struct-of-arrays:
+// os campos quentes (lidos a cada km_check_state / km_i_am_alive) ficam em
+// arrays contíguos próprios; nome e sonda só são tocados em falha ou nos testes.
+// Cresce dinamicamente, sem limite fixo. O índice do array é (ID - 1).
+// Rotinas de init rodam em vários núcleos (sys_register), então todo acesso
+// aos arrays passa pelo spinlock: um crescimento troca os ponteiros.
+#define KM_INITIAL_CAPACITY 16
+
+typedef struct {
+    uint32_t count;
+    uint32_t capacity;
+    // Campos quentes
+    uint64_t *last_check_time;
+    uint64_t *max_delay_ms;
+    // Campos frios
+    const char **name;
+    KmProbeFn *probe;
+    uint64_t *max_latency_ms;
+} KmRegistry;
+
+static KmRegistry registry = {0};
+static atomic_flag registry_lock = ATOMIC_FLAG_INIT;
+
+static inline void km_lock(void) {
+    while (atomic_flag_test_and_set_explicit(&registry_lock, memory_order_acquire)) {
+        // spin
+    }
+}
+
+static inline void km_unlock(void) {
+    atomic_flag_clear_explicit(&registry_lock, memory_order_release);
+}
+
+static void km_registry_free_arrays(KmRegistry *r) {
+    free(r->last_check_time);
+    free(r->max_delay_ms);
+    free(r->name);
+    free(r->probe);
+    free(r->max_latency_ms);
+}
+
+// Aloca todos os arrays novos antes de tocar no registro e só então troca os
+// ponteiros juntos: em falha, nada muda e as capacidades continuam iguais.
+// Chamado com registry_lock adquirido.
+static bool km_registry_grow(void) {
+    uint32_t new_cap = registry.capacity ? registry.capacity * 2 : KM_INITIAL_CAPACITY;
+    KmRegistry grown = registry;
+
+    grown.last_check_time = malloc(new_cap * sizeof(*grown.last_check_time));
+    grown.max_delay_ms = malloc(new_cap * sizeof(*grown.max_delay_ms));
+    grown.name = malloc(new_cap * sizeof(*grown.name));
+    grown.probe = malloc(new_cap * sizeof(*grown.probe));
+    grown.max_latency_ms = malloc(new_cap * sizeof(*grown.max_latency_ms));
+    if (!grown.last_check_time || !grown.max_delay_ms || !grown.name ||
+        !grown.probe || !grown.max_latency_ms) {
+        km_registry_free_arrays(&grown); // free(NULL) é inofensivo
+        return false;
+    }
+
+#define KM_MOVE(field) memcpy(grown.field, registry.field, registry.count * sizeof(*grown.field))
+    if (registry.count > 0) {
+        KM_MOVE(last_check_time);
+        KM_MOVE(max_delay_ms);
+        KM_MOVE(name);
+        KM_MOVE(probe);
+        KM_MOVE(max_latency_ms);
+    }
+#undef KM_MOVE
+
+    km_registry_free_arrays(&registry);
+    grown.capacity = new_cap;
+    registry = grown;
+    return true;
+}
 
 
 void km_init_monitor() {
     // 1. Limpa a lista de rastreamento
-    memset(tracked_subsytems, 0, sizeof(tracked_subsytems));
+    km_lock();
+    km_registry_free_arrays(&registry);
+    memset(&registry, 0, sizeof(registry));
+    km_unlock();
     
     // 2. Inicializa o timer de Watchdog de Hardware (se disponível na arquitetura)
     // arch_init_watchdog(); 
@@ -25,45 +101,98 @@ void km_init_monitor() {
     printf("Kernel Monitor: Watchdog inicializado.\n");
 }
 
-void km_register_subsystem(SubsystemTracker *tracker) {
-    if (next_id < MAX_SUBSYSTEMS) {
-        tracker->id = next_id++;
-        // Copia a estrutura (e assume que o tracker->name é uma string estática)
-        memcpy(&tracked_subsytems[tracker->id - 1], tracker, sizeof(SubsystemTracker));
-        printf("Monitor: Subsistema '%s' (ID %u) registrado.\n", tracker->name, tracker->id);
+uint32_t km_register_entry(const char *name, uint64_t max_delay_ms,
+                           KmProbeFn probe, uint64_t max_latency_ms) {
+    uint64_t now = arch_get_current_ms();
+
+    km_lock();
+    if (registry.count == registry.capacity && !km_registry_grow()) {
+        km_unlock();
+        printf("Monitor: Falha ao registrar '%s' (sem memória).\n", name);
+        return 0;
     }
+
+    uint32_t idx = registry.count++;
+    registry.last_check_time[idx] = now;
+    registry.max_delay_ms[idx] = max_delay_ms;
+    registry.name[idx] = name; // Assume que o nome é uma string estática
+    registry.probe[idx] = probe;
+    registry.max_latency_ms[idx] = max_latency_ms;
+    km_unlock();
+
+    printf("Monitor: Subsistema '%s' (ID %u) registrado.\n", name, idx + 1);
+    return idx + 1;
+}
+
+void km_register_subsystem(SubsystemTracker *tracker) {
+    tracker->id = km_register_entry(tracker->name, tracker->max_delay_ms, NULL, 0);
 }
 
 void km_i_am_alive(uint32_t id) {
-    if (id > 0 && id <= MAX_SUBSYSTEMS) {
-        tracked_subsytems[id - 1].last_check_time = arch_get_current_ms();
+    uint64_t now = arch_get_current_ms();
+    km_lock();
+    if (id > 0 && id <= registry.count) {
+        registry.last_check_time[id - 1] = now;
     }
+    km_unlock();
     // Alimentar o Watchdog de Hardware para evitar um reset forçado.
     arch_reset_watchdog_timer(); 
 }
 
+uint32_t km_entry_count(void) {
+    km_lock();
+    uint32_t count = registry.count;
+    km_unlock();
+    return count;
+}
+
+const char *km_entry_name(uint32_t id) {
+    km_lock();
+    const char *name = (id > 0 && id <= registry.count) ? registry.name[id - 1] : NULL;
+    km_unlock();
+    return name;
+}
+
+KmProbeFn km_entry_probe(uint32_t id) {
+    km_lock();
+    KmProbeFn probe = (id > 0 && id <= registry.count) ? registry.probe[id - 1] : NULL;
+    km_unlock();
+    return probe;
+}
+
+uint64_t km_entry_max_latency(uint32_t id) {
+    km_lock();
+    uint64_t latency = (id > 0 && id <= registry.count) ? registry.max_latency_ms[id - 1] : 0;
+    km_unlock();
+    return latency;
+}
+
 // =======================================================
 // Função de Verificação (Chamada em um timer de baixa prioridade)
 // =======================================================
 void km_check_state() {
     uint64_t current_time = arch_get_current_ms();
     
-    for (int i = 0; i < MAX_SUBSYSTEMS; i++) {
-        SubsystemTracker *tracker = &tracked_subsytems[i];
+    // Varre apenas os arrays quentes; entradas com max_delay_ms == 0 não são vigiadas.
+    km_lock();
+    for (uint32_t i = 0; i < registry.count; i++) {
+        uint64_t max_delay = registry.max_delay_ms[i];
+        uint64_t elapsed = current_time - registry.last_check_time[i];
         
-        if (tracker->id != 0) {
-            uint64_t elapsed = current_time - tracker->last_check_time;
-            
-            if (elapsed > tracker->max_delay_ms) {
-                // VIOLAÇÃO: O subsistema demorou muito para responder!
-                printf("CRITICAL: Subsistema '%s' (ID %u) falhou em responder (%llu ms).\n", 
-                       tracker->name, tracker->id, elapsed);
-                       
-                // Aciona o Kernel Panic para uma tela de erro elegante.
-                kernel_panic("Kernel Monitor Timeout: System Unresponsive");
-            }
+        if (max_delay != 0 && elapsed > max_delay) {
+            const char *name = registry.name[i];
+            km_unlock();
+
+            // VIOLAÇÃO: O subsistema demorou muito para responder!
+            printf("CRITICAL: Subsistema '%s' (ID %u) falhou em responder (%llu ms).\n", 
+                   name, i + 1, (unsigned long long)elapsed);
+                   
+            // Aciona o Kernel Panic para uma tela de erro elegante.
+            kernel_panic("Kernel Monitor Timeout: System Unresponsive");
+            return;
         }
     }
+    km_unlock();
 }
 
 // Funções externas simuladas:
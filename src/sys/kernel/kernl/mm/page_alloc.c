@@ -0,0 +1,365 @@
+// src/sys/kernel/kernl/mm/page_alloc.c
+// Implementação do alocador de frames físicos (buddy + caches por CPU).
+//
+// Compilado com -DPMM_HOSTED, o alocador roda em user space no Linux: o
+// "mapa de memória" aponta para um buffer do processo e o ID da CPU vem de
+// sched_getcpu(). Isso permite testar e medir o código fora do boot.
+
+#ifdef PMM_HOSTED
+#define _GNU_SOURCE // sched_getcpu()
+#endif
+
+#include "page_alloc.h"
+#include "../printk/printk.h" // Para KERN_INFO
+#include <stdatomic.h>
+#include <string.h>
+
+#ifdef PMM_HOSTED
+#include <sched.h>
+#else
+extern uint32_t arch_get_cpu_id(void);
+#endif
+
+// Memória física acessada pelo mapeamento identidade do boot (ver tabelas de página).
+#ifndef PMM_PHYS_TO_VIRT
+#define PMM_PHYS_TO_VIRT(paddr) ((void *)(uintptr_t)(paddr))
+#define PMM_VIRT_TO_PHYS(vaddr) ((uint64_t)(uintptr_t)(vaddr))
+#endif
+
+#define PMM_LOW_MEMORY_END  0x100000ull  // BIOS, IVT, stage1: nunca entregues
+#define PMM_PCP_CAPACITY    64           // Páginas por cache de CPU
+#define PMM_PCP_BATCH       16           // Páginas movidas por refill/drain
+
+// Nó de lista livre, gravado na primeira página do bloco livre
+typedef struct PmmFreeBlock {
+    struct PmmFreeBlock *next;
+    struct PmmFreeBlock *prev;
+} PmmFreeBlock;
+
+// Estado global do buddy allocator (protegido por 'lock')
+static struct {
+    atomic_flag lock;
+    uint64_t base_pfn;       // Alinhado a 2^PMM_MAX_ORDER: buddies são pfn ^ (1 << order)
+    uint64_t span_pages;     // Páginas cobertas por page_state
+    uint8_t *page_state;     // order + 1 se a página inicia um bloco livre; 0 caso contrário
+    PmmFreeBlock *free_list[PMM_MAX_ORDER + 1];
+    uint64_t free_blocks[PMM_MAX_ORDER + 1];
+    uint64_t free_pages;
+    uint64_t total_pages;
+} pmm = { .lock = ATOMIC_FLAG_INIT };
+
+// Cache por CPU: pilha de páginas únicas, cada uma em sua linha de cache.
+// O lock só disputa se outra CPU drenar o cache (ou no modo hosted).
+typedef struct {
+    atomic_flag lock;
+    uint32_t count;
+    uint64_t pages[PMM_PCP_CAPACITY];
+} __attribute__((aligned(64))) PmmCpuCache;
+
+static PmmCpuCache pcp[PMM_MAX_CPUS];
+
+// Região roubada para os metadados (excluída das listas livres)
+static uint64_t meta_start_pfn, meta_end_pfn;
+
+
+static inline void pmm_spin_lock(atomic_flag *lock) {
+    while (atomic_flag_test_and_set_explicit(lock, memory_order_acquire)) {
+        // spin
+    }
+}
+
+static inline void pmm_spin_unlock(atomic_flag *lock) {
+    atomic_flag_clear_explicit(lock, memory_order_release);
+}
+
+static inline uint32_t pmm_cpu_id(void) {
+#ifdef PMM_HOSTED
+    int cpu = sched_getcpu();
+    return cpu < 0 ? 0 : (uint32_t)cpu % PMM_MAX_CPUS;
+#else
+    return arch_get_cpu_id() % PMM_MAX_CPUS;
+#endif
+}
+
+static inline PmmFreeBlock *pmm_block(uint64_t pfn) {
+    return (PmmFreeBlock *)PMM_PHYS_TO_VIRT(pfn << PMM_PAGE_SHIFT);
+}
+
+// ----- Listas livres (chamador segura pmm.lock) -----
+
+static void pmm_list_push(uint64_t pfn, unsigned order) {
+    PmmFreeBlock *node = pmm_block(pfn);
+    node->prev = NULL;
+    node->next = pmm.free_list[order];
+    if (node->next) {
+        node->next->prev = node;
+    }
+    pmm.free_list[order] = node;
+    pmm.page_state[pfn - pmm.base_pfn] = (uint8_t)(order + 1);
+    pmm.free_blocks[order]++;
+    pmm.free_pages += 1ull << order;
+}
+
+static void pmm_list_remove(uint64_t pfn, unsigned order) {
+    PmmFreeBlock *node = pmm_block(pfn);
+    if (node->prev) {
+        node->prev->next = node->next;
+    } else {
+        pmm.free_list[order] = node->next;
+    }
+    if (node->next) {
+        node->next->prev = node->prev;
+    }
+    pmm.page_state[pfn - pmm.base_pfn] = 0;
+    pmm.free_blocks[order]--;
+    pmm.free_pages -= 1ull << order;
+}
+
+static uint64_t pmm_alloc_locked(unsigned order) {
+    unsigned o = order;
+    while (o <= PMM_MAX_ORDER && pmm.free_list[o] == NULL) {
+        o++;
+    }
+    if (o > PMM_MAX_ORDER) {
+        return 0;
+    }
+
+    uint64_t pfn = PMM_VIRT_TO_PHYS(pmm.free_list[o]) >> PMM_PAGE_SHIFT;
+    pmm_list_remove(pfn, o);
+
+    // Divide o bloco, devolvendo as metades superiores às listas menores.
+    while (o > order) {
+        o--;
+        pmm_list_push(pfn + (1ull << o), o);
+    }
+    return pfn;
+}
+
+static void pmm_free_locked(uint64_t pfn, unsigned order) {
+    while (order < PMM_MAX_ORDER) {
+        uint64_t buddy = ((pfn - pmm.base_pfn) ^ (1ull << order)) + pmm.base_pfn;
+        if (buddy - pmm.base_pfn >= pmm.span_pages ||
+            pmm.page_state[buddy - pmm.base_pfn] != order + 1) {
+            break;
+        }
+        pmm_list_remove(buddy, order);
+        if (buddy < pfn) {
+            pfn = buddy;
+        }
+        order++;
+    }
+    pmm_list_push(pfn, order);
+}
+
+// ----- Percurso do mapa de memória -----
+
+typedef void (*PmmRangeFn)(uint64_t start_pfn, uint64_t end_pfn, void *ctx);
+
+// Entrega a fn os trechos de [start, end) que não colidem com regiões não usáveis,
+// com regiões usáveis anteriores a 'self' (entradas duplicadas) nem com os metadados.
+static void pmm_walk_range(const PmmRegion *regions, size_t count, size_t self, size_t from,
+                           uint64_t start, uint64_t end, PmmRangeFn fn, void *ctx) {
+    if (start < PMM_LOW_MEMORY_END) {
+        start = PMM_LOW_MEMORY_END;
+    }
+    if (start >= end) {
+        return;
+    }
+
+    for (size_t j = from; j < count; j++) {
+        if (regions[j].type == PMM_REGION_USABLE && j >= self) {
+            continue;
+        }
+        uint64_t rs = regions[j].base;
+        uint64_t re = regions[j].base + regions[j].length;
+        if (re <= start || rs >= end) {
+            continue;
+        }
+        pmm_walk_range(regions, count, self, j + 1, start, rs, fn, ctx);
+        pmm_walk_range(regions, count, self, j + 1, re, end, fn, ctx);
+        return;
+    }
+
+    // Só páginas inteiras
+    uint64_t s = (start + PMM_PAGE_SIZE - 1) >> PMM_PAGE_SHIFT;
+    uint64_t e = end >> PMM_PAGE_SHIFT;
+    if (s >= e) {
+        return;
+    }
+    if (meta_end_pfn > s && meta_start_pfn < e) {
+        if (s < meta_start_pfn) fn(s, meta_start_pfn, ctx);
+        if (meta_end_pfn < e) fn(meta_end_pfn, e, ctx);
+        return;
+    }
+    fn(s, e, ctx);
+}
+
+static void pmm_walk(const PmmRegion *regions, size_t count, PmmRangeFn fn, void *ctx) {
+    for (size_t i = 0; i < count; i++) {
+        if (regions[i].type == PMM_REGION_USABLE) {
+            pmm_walk_range(regions, count, i, 0, regions[i].base,
+                           regions[i].base + regions[i].length, fn, ctx);
+        }
+    }
+}
+
+typedef struct { uint64_t min_pfn, max_pfn; } PmmSpan;
+
+static void pmm_span_fn(uint64_t s, uint64_t e, void *ctx) {
+    PmmSpan *span = ctx;
+    if (s < span->min_pfn) span->min_pfn = s;
+    if (e > span->max_pfn) span->max_pfn = e;
+}
+
+static void pmm_meta_fn(uint64_t s, uint64_t e, void *ctx) {
+    uint64_t need = *(uint64_t *)ctx;
+    if (meta_end_pfn == 0 && e - s >= need) {
+        meta_start_pfn = s;
+        meta_end_pfn = s + need;
+    }
+}
+
+static void pmm_add_fn(uint64_t s, uint64_t e, void *ctx) {
+    uint64_t *budget = ctx;
+    if (e - s > *budget) {
+        e = s + *budget;
+    }
+    *budget -= e - s;
+    pmm.total_pages += e - s;
+
+    // Maiores blocos alinhados possíveis; pmm_free_locked une com vizinhos já livres.
+    while (s < e) {
+        unsigned order = 0;
+        while (order < PMM_MAX_ORDER &&
+               (s & ((2ull << order) - 1)) == 0 && s + (2ull << order) <= e) {
+            order++;
+        }
+        pmm_free_locked(s, order);
+        s += 1ull << order;
+    }
+}
+
+
+bool pmm_init(const PmmRegion *regions, size_t count, uint64_t max_memory_bytes) {
+    pmm_spin_lock(&pmm.lock);
+
+    memset(pmm.free_list, 0, sizeof(pmm.free_list));
+    memset(pmm.free_blocks, 0, sizeof(pmm.free_blocks));
+    pmm.free_pages = 0;
+    pmm.total_pages = 0;
+    meta_start_pfn = meta_end_pfn = 0;
+    for (int cpu = 0; cpu < PMM_MAX_CPUS; cpu++) {
+        pcp[cpu].count = 0;
+    }
+
+    // 1. Extensão física da memória usável
+    PmmSpan span = { UINT64_MAX, 0 };
+    pmm_walk(regions, count, pmm_span_fn, &span);
+    if (span.max_pfn == 0) {
+        pmm_spin_unlock(&pmm.lock);
+        KERN_ERR("PMM: Nenhuma região usável no mapa de memória.");
+        return false;
+    }
+    pmm.base_pfn = span.min_pfn & ~((1ull << PMM_MAX_ORDER) - 1);
+    pmm.span_pages = span.max_pfn - pmm.base_pfn;
+
+    // 2. Metadados (1 byte por página) no início da primeira região que os comporte
+    uint64_t meta_pages = (pmm.span_pages + PMM_PAGE_SIZE - 1) >> PMM_PAGE_SHIFT;
+    pmm_walk(regions, count, pmm_meta_fn, &meta_pages);
+    if (meta_end_pfn == 0) {
+        pmm_spin_unlock(&pmm.lock);
+        KERN_ERR("PMM: Sem espaço contíguo para os metadados.");
+        return false;
+    }
+    pmm.page_state = PMM_PHYS_TO_VIRT(meta_start_pfn << PMM_PAGE_SHIFT);
+    memset(pmm.page_state, 0, pmm.span_pages);
+
+    // 3. Libera as regiões usáveis, até o limite de memória
+    uint64_t budget = max_memory_bytes ? max_memory_bytes >> PMM_PAGE_SHIFT : UINT64_MAX;
+    pmm_walk(regions, count, pmm_add_fn, &budget);
+
+    pmm_spin_unlock(&pmm.lock);
+
+    KERN_INFO("PMM: %llu MiB gerenciados (%llu páginas), metadados: %llu KiB.",
+              (unsigned long long)(pmm.total_pages >> (20 - PMM_PAGE_SHIFT)),
+              (unsigned long long)pmm.total_pages,
+              (unsigned long long)(meta_pages << (PMM_PAGE_SHIFT - 10)));
+    return pmm.total_pages > 0;
+}
+
+uint64_t pmm_alloc_pages(unsigned order) {
+    if (order > PMM_MAX_ORDER) {
+        return 0;
+    }
+    pmm_spin_lock(&pmm.lock);
+    uint64_t pfn = pmm_alloc_locked(order);
+    pmm_spin_unlock(&pmm.lock);
+    return pfn << PMM_PAGE_SHIFT;
+}
+
+void pmm_free_pages(uint64_t paddr, unsigned order) {
+    if (paddr == 0 || order > PMM_MAX_ORDER) {
+        return;
+    }
+    pmm_spin_lock(&pmm.lock);
+    pmm_free_locked(paddr >> PMM_PAGE_SHIFT, order);
+    pmm_spin_unlock(&pmm.lock);
+}
+
+uint64_t pmm_alloc_page(void) {
+    PmmCpuCache *cache = &pcp[pmm_cpu_id()];
+    pmm_spin_lock(&cache->lock);
+
+    if (cache->count == 0) {
+        // Refill em lote: um único lock global para PMM_PCP_BATCH páginas
+        pmm_spin_lock(&pmm.lock);
+        while (cache->count < PMM_PCP_BATCH) {
+            uint64_t pfn = pmm_alloc_locked(0);
+            if (pfn == 0) {
+                break;
+            }
+            cache->pages[cache->count++] = pfn;
+        }
+        pmm_spin_unlock(&pmm.lock);
+    }
+
+    uint64_t pfn = cache->count ? cache->pages[--cache->count] : 0;
+    pmm_spin_unlock(&cache->lock);
+    return pfn << PMM_PAGE_SHIFT;
+}
+
+void pmm_free_page(uint64_t paddr) {
+    if (paddr == 0) {
+        return;
+    }
+    PmmCpuCache *cache = &pcp[pmm_cpu_id()];
+    pmm_spin_lock(&cache->lock);
+
+    if (cache->count == PMM_PCP_CAPACITY) {
+        // Drena as páginas mais antigas (base da pilha) de volta ao buddy
+        pmm_spin_lock(&pmm.lock);
+        for (uint32_t i = 0; i < PMM_PCP_BATCH; i++) {
+            pmm_free_locked(cache->pages[i], 0);
+        }
+        pmm_spin_unlock(&pmm.lock);
+        memmove(cache->pages, cache->pages + PMM_PCP_BATCH,
+                (PMM_PCP_CAPACITY - PMM_PCP_BATCH) * sizeof(cache->pages[0]));
+        cache->count -= PMM_PCP_BATCH;
+    }
+
+    cache->pages[cache->count++] = paddr >> PMM_PAGE_SHIFT;
+    pmm_spin_unlock(&cache->lock);
+}
+
+void pmm_get_stats(PmmStats *stats) {
+    uint64_t cached = 0;
+    for (int cpu = 0; cpu < PMM_MAX_CPUS; cpu++) {
+        cached += pcp[cpu].count; // Leitura aproximada, sem travar os caches
+    }
+
+    pmm_spin_lock(&pmm.lock);
+    stats->total_pages = pmm.total_pages;
+    stats->free_pages = pmm.free_pages + cached;
+    memcpy(stats->free_blocks, pmm.free_blocks, sizeof(stats->free_blocks));
+    pmm_spin_unlock(&pmm.lock);
+}
@@ -0,0 +1,95 @@
+#ifndef ARCANOS_KERNEL_PAGE_ALLOC_H
+#define ARCANOS_KERNEL_PAGE_ALLOC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Alocador de frames físicos: buddy allocator alimentado pelo mapa de memória
+// (E820 ou UEFI), com caches por CPU para alocação rápida de páginas únicas.
+
+#define PMM_PAGE_SHIFT  12
+#define PMM_PAGE_SIZE   (1ull << PMM_PAGE_SHIFT)
+#define PMM_MAX_ORDER   18   // Maior bloco: 2^18 páginas = 1 GiB
+#define PMM_HUGE_ORDER  9    // Bloco do tamanho de uma huge page (2 MiB)
+#define PMM_MAX_CPUS    64
+
+// Limite de memória do kernel (kernel/config.toml: memory.max_memory_limit_mb),
+// injetado pelo build via kernel/config.bzl.
+#ifndef CONFIG_MAX_MEMORY_LIMIT_MB
+#define CONFIG_MAX_MEMORY_LIMIT_MB 4096
+#endif
+
+// Tipos de região. Os valores são os mesmos do E820 (1 = usável, 2 = reservado,
+// 3 = ACPI reclaim, 4 = ACPI NVS, 5 = defeituosa); qualquer tipo != USABLE é evitado.
+typedef enum {
+    PMM_REGION_USABLE   = 1,
+    PMM_REGION_RESERVED = 2
+} PmmRegionType;
+
+// Uma entrada do mapa de memória físico
+typedef struct {
+    uint64_t base;     // Endereço físico inicial
+    uint64_t length;   // Tamanho em bytes
+    uint32_t type;     // PmmRegionType / tipo E820
+} PmmRegion;
+
+// Estatísticas do alocador
+typedef struct {
+    uint64_t total_pages;                       // Páginas gerenciadas
+    uint64_t free_pages;                        // Livres (buddy + caches por CPU)
+    uint64_t free_blocks[PMM_MAX_ORDER + 1];    // Blocos livres por ordem
+} PmmStats;
+
+// =======================================================
+// Funções do Alocador de Páginas
+// =======================================================
+
+/**
+ * @brief Inicializa o alocador a partir do mapa de memória.
+ * * Regiões não usáveis (e o primeiro 1 MiB) nunca são entregues; o chamador deve
+ * * marcar kernel, ramdisk e tabelas do boot como PMM_REGION_RESERVED. Os metadados
+ * * (1 byte por página) são retirados da primeira região usável que os comporte.
+ * @param regions O mapa de memória (não precisa estar ordenado).
+ * @param count Número de entradas.
+ * @param max_memory_bytes Máximo de memória gerenciada (0 = sem limite);
+ *        normalmente (uint64_t)CONFIG_MAX_MEMORY_LIMIT_MB << 20.
+ * @return true se alguma memória foi disponibilizada.
+ */
+bool pmm_init(const PmmRegion *regions, size_t count, uint64_t max_memory_bytes);
+
+/**
+ * @brief Aloca um bloco de 2^order páginas contíguas, alinhado ao próprio tamanho.
+ * * Use PMM_HUGE_ORDER para blocos de 2 MiB (ex: ramdisk).
+ * @return O endereço físico do bloco, ou 0 se não houver memória.
+ */
+uint64_t pmm_alloc_pages(unsigned order);
+
+/**
+ * @brief Libera um bloco obtido por pmm_alloc_pages(), unindo-o a seus buddies.
+ */
+void pmm_free_pages(uint64_t paddr, unsigned order);
+
+/**
+ * @brief Aloca uma página pelo cache da CPU atual (caminho rápido).
+ * @return O endereço físico da página, ou 0 se não houver memória.
+ */
+uint64_t pmm_alloc_page(void);
+
+/**
+ * @brief Devolve uma página ao cache da CPU atual.
+ */
+void pmm_free_page(uint64_t paddr);
+
+/**
+ * @brief Preenche as estatísticas atuais do alocador.
+ */
+void pmm_get_stats(PmmStats *stats);
+
+#ifdef PMM_HOSTED
+// Autoteste e benchmark em user space (page_alloc_test.c)
+int pmm_run_selftest(void);
+void pmm_run_benchmark(unsigned max_threads);
+#endif
+
+#endif // ARCANOS_KERNEL_PAGE_ALLOC_H
@@ -0,0 +1,279 @@
+// src/sys/kernel/kernl/mm/page_alloc_test.c
+// Autoteste e benchmark do alocador de frames físicos (modo hosted).
+//
+// Compilar junto com page_alloc.c e printk.c, com -DPMM_HOSTED -pthread:
+// o "mapa de memória" é um buffer do processo (PMM_PHYS_TO_VIRT identidade).
+
+#ifdef PMM_HOSTED
+
+#define _GNU_SOURCE
+#include "page_alloc.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define PMM_TEST_ARENA   (64ull << 20)          // Memória do autoteste
+#define PMM_TEST_HOLE    (8ull << 20)           // Início do buraco reservado (offset)
+#define PMM_TEST_HOLE_SZ (1ull << 20)
+#define PMM_HUGE_SIZE    (PMM_PAGE_SIZE << PMM_HUGE_ORDER)
+
+#define PMM_BENCH_ARENA  (256ull << 20)
+#define PMM_BENCH_OPS    (1u << 20)             // Operações por thread e por caso
+#define PMM_BENCH_BURST  32                     // Páginas presas antes de devolver
+
+// Aloca a arena alinhada a 2 MiB e monta o mapa: uma região usável com um buraco
+// reservado no meio (sobreposto, como o kernel marcado no mapa do boot).
+static uint8_t *pmm_test_arena(uint64_t size, PmmRegion regions[2]) {
+    uint8_t *arena = aligned_alloc(PMM_HUGE_SIZE, size);
+    if (arena == NULL) {
+        return NULL;
+    }
+    regions[0] = (PmmRegion){ (uint64_t)(uintptr_t)arena, size, PMM_REGION_USABLE };
+    regions[1] = (PmmRegion){ (uint64_t)(uintptr_t)arena + PMM_TEST_HOLE, PMM_TEST_HOLE_SZ,
+                              PMM_REGION_RESERVED };
+    return arena;
+}
+
+static bool pmm_test_same_blocks(const PmmStats *a, const PmmStats *b) {
+    return a->free_pages == b->free_pages &&
+           memcmp(a->free_blocks, b->free_blocks, sizeof(a->free_blocks)) == 0;
+}
+
+// Endereço dentro da arena, fora do buraco reservado e dos metadados
+static bool pmm_test_in_arena(uint64_t paddr, uint64_t bytes, uint64_t base, uint64_t meta_end) {
+    uint64_t hole = base + PMM_TEST_HOLE;
+    return paddr >= meta_end && paddr + bytes <= base + PMM_TEST_ARENA &&
+           (paddr + bytes <= hole || paddr >= hole + PMM_TEST_HOLE_SZ);
+}
+
+/**
+ * @brief Confere contagens de alocação/liberação, a união de buddies e o
+ * alinhamento dos blocos de ordem 9 (2 MiB) sobre uma arena de 64 MiB.
+ * @return 0 se o teste for bem-sucedido, 1 caso contrário.
+ */
+int pmm_run_selftest(void) {
+    printf("--- ARCANOS PMM: SELF-TEST ---\n");
+
+    PmmRegion regions[2];
+    uint8_t *arena = pmm_test_arena(PMM_TEST_ARENA, regions);
+    uint64_t *pages = malloc((PMM_TEST_ARENA / PMM_PAGE_SIZE) * sizeof(uint64_t));
+    int failed = 1;
+    if (arena == NULL || pages == NULL) {
+        printf("TEST FAILED: Sem memoria para a arena de teste.\n");
+        goto out;
+    }
+
+    // 1. Inicialização: total = arena - buraco - metadados (1 byte por página do span)
+    if (!pmm_init(regions, 2, 0)) {
+        printf("TEST FAILED: pmm_init recusou o mapa de memoria.\n");
+        goto out;
+    }
+    uint64_t base = regions[0].base;
+    uint64_t base_pfn = (base >> PMM_PAGE_SHIFT) & ~((1ull << PMM_MAX_ORDER) - 1);
+    uint64_t span = ((base + PMM_TEST_ARENA) >> PMM_PAGE_SHIFT) - base_pfn;
+    uint64_t meta_pages = (span + PMM_PAGE_SIZE - 1) >> PMM_PAGE_SHIFT;
+    uint64_t meta_end = base + (meta_pages << PMM_PAGE_SHIFT);
+    uint64_t expected = (PMM_TEST_ARENA - PMM_TEST_HOLE_SZ) / PMM_PAGE_SIZE - meta_pages;
+
+    PmmStats initial, now;
+    pmm_get_stats(&initial);
+    if (initial.total_pages != expected || initial.free_pages != expected) {
+        printf("TEST FAILED: %llu paginas gerenciadas (%llu livres), esperado %llu.\n",
+               (unsigned long long)initial.total_pages, (unsigned long long)initial.free_pages,
+               (unsigned long long)expected);
+        goto out;
+    }
+
+    // 2. Blocos de 2 MiB: alinhados ao próprio tamanho e fora das áreas reservadas
+    size_t huge = 0;
+    for (uint64_t p; (p = pmm_alloc_pages(PMM_HUGE_ORDER)) != 0; ) {
+        if ((p & (PMM_HUGE_SIZE - 1)) != 0 || !pmm_test_in_arena(p, PMM_HUGE_SIZE, base, meta_end)) {
+            printf("TEST FAILED: Bloco de ordem 9 em 0x%llx desalinhado ou fora da arena.\n",
+                   (unsigned long long)p);
+            goto out;
+        }
+        pages[huge++] = p;
+    }
+    // Arena de 64 MiB alinhada: 32 blocos, menos o do buraco e o dos metadados
+    if (huge != PMM_TEST_ARENA / PMM_HUGE_SIZE - 2) {
+        printf("TEST FAILED: %zu blocos de ordem 9, esperado %llu.\n", huge,
+               (unsigned long long)(PMM_TEST_ARENA / PMM_HUGE_SIZE - 2));
+        goto out;
+    }
+    for (size_t i = 0; i < huge; i++) {
+        pmm_free_pages(pages[i], PMM_HUGE_ORDER);
+    }
+    pmm_get_stats(&now);
+    if (!pmm_test_same_blocks(&now, &initial)) {
+        printf("TEST FAILED: Liberar os blocos de ordem 9 nao restaurou as listas livres.\n");
+        goto out;
+    }
+
+    // 3. Exaustão em páginas únicas: cada página uma vez, marcada e conferida
+    size_t count = 0;
+    for (uint64_t p; (p = pmm_alloc_pages(0)) != 0; ) {
+        if ((p & (PMM_PAGE_SIZE - 1)) != 0 || !pmm_test_in_arena(p, PMM_PAGE_SIZE, base, meta_end)) {
+            printf("TEST FAILED: Pagina 0x%llx fora da arena.\n", (unsigned long long)p);
+            goto out;
+        }
+        *(uint64_t *)(uintptr_t)p = count;
+        pages[count++] = p;
+    }
+    pmm_get_stats(&now);
+    if (count != expected || now.free_pages != 0) {
+        printf("TEST FAILED: %zu paginas alocadas ate a exaustao, esperado %llu.\n", count,
+               (unsigned long long)expected);
+        goto out;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (*(uint64_t *)(uintptr_t)pages[i] != i) {
+            printf("TEST FAILED: Pagina 0x%llx entregue duas vezes.\n", (unsigned long long)pages[i]);
+            goto out;
+        }
+    }
+    // Liberação intercalada (pares, depois ímpares): força a união em cascata
+    for (size_t i = 0; i < count; i += 2) {
+        pmm_free_pages(pages[i], 0);
+    }
+    for (size_t i = 1; i < count; i += 2) {
+        pmm_free_pages(pages[i], 0);
+    }
+    pmm_get_stats(&now);
+    if (!pmm_test_same_blocks(&now, &initial)) {
+        printf("TEST FAILED: Os buddies nao se uniram de volta aos blocos iniciais.\n");
+        goto out;
+    }
+
+    // 4. Caminho rápido (cache por CPU): contagens incluem as páginas em cache
+    for (size_t i = 0; i < 1000; i++) {
+        pages[i] = pmm_alloc_page();
+        if (pages[i] == 0) {
+            printf("TEST FAILED: pmm_alloc_page falhou com memoria livre.\n");
+            goto out;
+        }
+    }
+    pmm_get_stats(&now);
+    if (now.free_pages != expected - 1000) {
+        printf("TEST FAILED: %llu paginas livres apos 1000 alocacoes, esperado %llu.\n",
+               (unsigned long long)now.free_pages, (unsigned long long)(expected - 1000));
+        goto out;
+    }
+    for (size_t i = 0; i < 1000; i++) {
+        pmm_free_page(pages[i]);
+    }
+    pmm_get_stats(&now);
+    if (now.free_pages != expected) {
+        printf("TEST FAILED: Paginas perdidas no cache por CPU.\n");
+        goto out;
+    }
+
+    // 5. Ordem acima do máximo é recusada
+    if (pmm_alloc_pages(PMM_MAX_ORDER + 1) != 0) {
+        printf("TEST FAILED: Ordem invalida foi aceita.\n");
+        goto out;
+    }
+
+    printf("--- ARCANOS PMM: TESTE BEM-SUCEDIDO ---\n");
+    failed = 0;
+out:
+    free(pages);
+    free(arena);
+    return failed;
+}
+
+// ----- Benchmark -----
+
+typedef struct {
+    int mode;              // 0 = cache por CPU, 1 = buddy ordem 0, 2 = buddy ordem 9
+    uint64_t ops;          // Pares alloc/free concluídos
+} PmmBenchThread;
+
+static void *pmm_bench_worker(void *arg) {
+    PmmBenchThread *t = arg;
+    uint64_t held[PMM_BENCH_BURST];
+    uint64_t done = 0;
+    while (done < PMM_BENCH_OPS) {
+        int n = 0;
+        for (; n < PMM_BENCH_BURST; n++) {
+            held[n] = t->mode == 0 ? pmm_alloc_page()
+                                   : pmm_alloc_pages(t->mode == 1 ? 0 : PMM_HUGE_ORDER);
+            if (held[n] == 0) {
+                break;
+            }
+        }
+        for (int i = n - 1; i >= 0; i--) {
+            if (t->mode == 0) {
+                pmm_free_page(held[i]);
+            } else {
+                pmm_free_pages(held[i], t->mode == 1 ? 0 : PMM_HUGE_ORDER);
+            }
+        }
+        done += n ? (uint64_t)n : 1;
+    }
+    t->ops = done;
+    return NULL;
+}
+
+static uint64_t pmm_bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Mede a vazão de alocação (pares alloc/free por segundo) com 1..max_threads
+ * threads: cache por CPU, buddy em páginas únicas e buddy em blocos de 2 MiB.
+ * * Cada thread prende PMM_BENCH_BURST blocos antes de devolvê-los, o que
+ * * exercita o refill e o drain dos caches em lote.
+ */
+void pmm_run_benchmark(unsigned max_threads) {
+    static const char *names[] = { "alloc_page (cache CPU)", "alloc_pages(0) buddy", "alloc_pages(9) buddy" };
+    printf("--- ARCANOS PMM: BENCHMARK ---\n");
+
+    PmmRegion regions[2];
+    uint8_t *arena = pmm_test_arena(PMM_BENCH_ARENA, regions);
+    if (arena == NULL || !pmm_init(regions, 2, 0)) {
+        printf("PMM_BENCH: sem memoria para a arena.\n");
+        free(arena);
+        return;
+    }
+    if (max_threads == 0 || max_threads > PMM_MAX_CPUS) {
+        max_threads = PMM_MAX_CPUS;
+    }
+
+    for (int mode = 0; mode < 3; mode++) {
+        for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+            PmmBenchThread state[PMM_MAX_CPUS];
+            pthread_t tid[PMM_MAX_CPUS];
+            uint64_t t0 = pmm_bench_now_ns();
+            for (unsigned i = 0; i < threads; i++) {
+                state[i] = (PmmBenchThread){ mode, 0 };
+                pthread_create(&tid[i], NULL, pmm_bench_worker, &state[i]);
+            }
+            uint64_t ops = 0;
+            for (unsigned i = 0; i < threads; i++) {
+                pthread_join(tid[i], NULL);
+                ops += state[i].ops;
+            }
+            uint64_t ns = pmm_bench_now_ns() - t0;
+            printf("PMM_BENCH: %-24s %2u threads: %8.2f M ops/s, %6.1f ns/op\n", names[mode], threads,
+                   ns ? (double)ops * 1e3 / (double)ns : 0.0, ops ? (double)ns / (double)ops : 0.0);
+        }
+    }
+    free(arena);
+}
+
+// Opcional: Função main simulada para execução direta do teste
+/*
+int main() {
+    if (pmm_run_selftest() != 0) {
+        return 1;
+    }
+    pmm_run_benchmark(4);
+    return 0;
+}
+*/
+
+#endif // PMM_HOSTED
@@ -20,6 +20,7 @@ void kernel_log(LogLevel level, const char *fmt, ...);
 
 // Macro de conveniência para ser usada em todo o Kernel
 #define KERN_EMERG(fmt, ...) kernel_log(LOG_EMERG, fmt, ##__VA_ARGS__)
+#define KERN_CRIT(fmt, ...)  kernel_log(LOG_CRIT, fmt, ##__VA_ARGS__)
 #define KERN_ERR(fmt, ...)   kernel_log(LOG_ERR, fmt, ##__VA_ARGS__)
 #define KERN_INFO(fmt, ...)  kernel_log(LOG_INFO, fmt, ##__VA_ARGS__)
 #define KERN_DEBUG(fmt, ...) kernel_log(LOG_DEBUG, fmt, ##__VA_ARGS__)
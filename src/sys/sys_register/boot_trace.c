@@ -0,0 +1,167 @@
+// src/sys/sys_register/boot_trace.c
+// Profiler de boot: tempo de cada rotina de inicialização e caminho crítico.
+
+#include "boot_trace.h"
+#include "../kernel/kernl/printk/printk.h" // Para KERN_INFO
+#include <stdatomic.h>
+#include <stdio.h> // Para snprintf
+
+// Funções externas da arquitetura
+extern uint64_t arch_get_time_ns(void); // TSC (x86_64) / CNTVCT_EL0 (ARM64), em ns
+extern uint32_t arch_get_cpu_id(void);
+
+// Trace de tamanho fixo. Os eventos ficam na ordem de conclusão, que é uma
+// ordem topológica: uma rotina só é liberada depois que suas dependências
+// foram registradas aqui.
+static BootTraceEvent trace_events[BOOT_TRACE_MAX_EVENTS];
+static atomic_uint trace_count;
+static atomic_uint trace_dropped;
+
+
+void boot_trace_reset(void) {
+    atomic_store(&trace_count, 0);
+    atomic_store(&trace_dropped, 0);
+}
+
+uint64_t boot_trace_now_ns(void) {
+    return arch_get_time_ns();
+}
+
+void boot_trace_record(const char *name, uint32_t id, uint32_t deps,
+                       uint64_t start_ns, uint64_t end_ns) {
+    uint32_t slot = atomic_fetch_add(&trace_count, 1);
+    if (slot >= BOOT_TRACE_MAX_EVENTS) {
+        atomic_fetch_add(&trace_dropped, 1);
+        return;
+    }
+
+    BootTraceEvent *ev = &trace_events[slot];
+    ev->name = name;
+    ev->id = id;
+    ev->deps = deps;
+    ev->cpu = arch_get_cpu_id();
+    ev->start_ns = start_ns;
+    ev->end_ns = end_ns;
+}
+
+static uint32_t boot_trace_size(void) {
+    uint32_t n = atomic_load(&trace_count);
+    return n > BOOT_TRACE_MAX_EVENTS ? BOOT_TRACE_MAX_EVENTS : n;
+}
+
+static uint64_t boot_trace_duration(const BootTraceEvent *ev) {
+    return ev->end_ns - ev->start_ns;
+}
+
+
+void boot_trace_print_report(void) {
+    uint32_t n = boot_trace_size();
+    if (n == 0) {
+        return;
+    }
+
+    // 1. Tabela ordenada por duração (decrescente). n <= 32: insertion sort basta.
+    uint8_t order[BOOT_TRACE_MAX_EVENTS];
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t j = i;
+        while (j > 0 && boot_trace_duration(&trace_events[order[j - 1]]) <
+                        boot_trace_duration(&trace_events[i])) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = (uint8_t)i;
+    }
+
+    uint64_t boot_start = trace_events[0].start_ns;
+    uint64_t boot_end = trace_events[0].end_ns;
+    for (uint32_t i = 1; i < n; i++) {
+        if (trace_events[i].start_ns < boot_start) boot_start = trace_events[i].start_ns;
+        if (trace_events[i].end_ns > boot_end) boot_end = trace_events[i].end_ns;
+    }
+
+    KERN_INFO("BOOT_TRACE: %u rotinas em %llu us (wall clock).", n,
+              (unsigned long long)((boot_end - boot_start) / 1000));
+    KERN_INFO("BOOT_TRACE: %-24s %4s %12s %12s", "ROTINA", "CPU", "INICIO(us)", "DURACAO(us)");
+    for (uint32_t k = 0; k < n; k++) {
+        const BootTraceEvent *ev = &trace_events[order[k]];
+        KERN_INFO("BOOT_TRACE: %-24s %4u %12llu %12llu", ev->name, ev->cpu,
+                  (unsigned long long)((ev->start_ns - boot_start) / 1000),
+                  (unsigned long long)(boot_trace_duration(ev) / 1000));
+    }
+
+    // 2. Caminho crítico: maior soma de durações ao longo das dependências.
+    // O trace já está em ordem topológica; dependências ainda não vistas
+    // (rotinas em ciclo, executadas no fallback serial) são ignoradas.
+    int slot_of_id[BOOT_TRACE_MAX_EVENTS];
+    uint64_t path_ns[BOOT_TRACE_MAX_EVENTS];
+    int path_prev[BOOT_TRACE_MAX_EVENTS];
+    for (uint32_t i = 0; i < BOOT_TRACE_MAX_EVENTS; i++) {
+        slot_of_id[i] = -1;
+    }
+
+    int tail = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        const BootTraceEvent *ev = &trace_events[i];
+        path_ns[i] = 0;
+        path_prev[i] = -1;
+        for (uint32_t deps = ev->deps; deps; deps &= deps - 1) {
+            int s = slot_of_id[__builtin_ctz(deps)];
+            if (s >= 0 && path_ns[s] > path_ns[i]) {
+                path_ns[i] = path_ns[s];
+                path_prev[i] = s;
+            }
+        }
+        path_ns[i] += boot_trace_duration(ev);
+        if (ev->id < BOOT_TRACE_MAX_EVENTS) {
+            slot_of_id[ev->id] = (int)i;
+        }
+        if (path_ns[i] > path_ns[tail]) {
+            tail = (int)i;
+        }
+    }
+
+    KERN_INFO("BOOT_TRACE: Caminho crítico (%llu us), do fim para o início:",
+              (unsigned long long)(path_ns[tail] / 1000));
+    for (int s = tail; s >= 0; s = path_prev[s]) {
+        KERN_INFO("BOOT_TRACE:   <- %s (%llu us)", trace_events[s].name,
+                  (unsigned long long)(boot_trace_duration(&trace_events[s]) / 1000));
+    }
+
+    uint32_t dropped = atomic_load(&trace_dropped);
+    if (dropped > 0) {
+        KERN_ERR("BOOT_TRACE: %u eventos descartados (trace cheio).", dropped);
+    }
+}
+
+
+size_t boot_trace_export_chrome_json(char *buf, size_t buf_size) {
+    uint32_t n = boot_trace_size();
+    size_t len = 0;
+
+    // Acumula como snprintf: continua medindo mesmo depois que o buffer enche.
+#define BT_APPEND(...) do { \
+        int w = snprintf(buf && len < buf_size ? buf + len : NULL, \
+                         buf && len < buf_size ? buf_size - len : 0, __VA_ARGS__); \
+        if (w > 0) len += (size_t)w; \
+    } while (0)
+
+    BT_APPEND("{\"traceEvents\":[");
+    for (uint32_t i = 0; i < n; i++) {
+        const BootTraceEvent *ev = &trace_events[i];
+        // Formato "complete event" (ph = X): ts e dur em microssegundos.
+        BT_APPEND("%s{\"name\":\"%s\",\"cat\":\"init\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,"
+                  "\"ts\":%llu.%03llu,\"dur\":%llu.%03llu}",
+                  i ? "," : "", ev->name, ev->cpu,
+                  (unsigned long long)(ev->start_ns / 1000), (unsigned long long)(ev->start_ns % 1000),
+                  (unsigned long long)(boot_trace_duration(ev) / 1000),
+                  (unsigned long long)(boot_trace_duration(ev) % 1000));
+    }
+    BT_APPEND("],\"displayTimeUnit\":\"ns\"}");
+#undef BT_APPEND
+
+    return len;
+}
+
+// Funções externas simuladas:
+uint64_t arch_get_time_ns(void) { return 0; }
+uint32_t arch_get_cpu_id(void) { return 0; }
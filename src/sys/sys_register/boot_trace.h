@@ -0,0 +1,55 @@
+#ifndef ARCANOS_BOOT_TRACE_H
+#define ARCANOS_BOOT_TRACE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Capacidade do trace de boot (igual ao limite de rotinas do sys_register).
+#define BOOT_TRACE_MAX_EVENTS 32
+
+// Um evento do trace: uma rotina de inicialização executada.
+typedef struct {
+    const char *name;      // Nome da rotina
+    uint32_t id;           // Índice da rotina no sys_register (< BOOT_TRACE_MAX_EVENTS)
+    uint32_t deps;         // Máscara de bits das rotinas das quais esta depende
+    uint32_t cpu;          // Núcleo que executou a rotina
+    uint64_t start_ns;     // Início (relógio de alta resolução)
+    uint64_t end_ns;       // Fim
+} BootTraceEvent;
+
+// =======================================================
+// Funções do Boot Trace
+// =======================================================
+
+/**
+ * @brief Limpa o trace (chamado uma vez, na primeira entrada do executor de init).
+ */
+void boot_trace_reset(void);
+
+/**
+ * @brief Lê o relógio de alta resolução usado pelo trace.
+ * @return Tempo monotônico em nanossegundos.
+ */
+uint64_t boot_trace_now_ns(void);
+
+/**
+ * @brief Registra uma rotina concluída. Seguro para chamadas concorrentes.
+ * * Eventos além de BOOT_TRACE_MAX_EVENTS são descartados (e contados).
+ */
+void boot_trace_record(const char *name, uint32_t id, uint32_t deps,
+                       uint64_t start_ns, uint64_t end_ns);
+
+/**
+ * @brief Imprime a tabela de rotinas ordenada por duração e o caminho crítico.
+ */
+void boot_trace_print_report(void);
+
+/**
+ * @brief Exporta o trace no formato Chrome trace-event JSON (chrome://tracing, Perfetto).
+ * @param buf Buffer de destino (pode ser NULL para apenas medir).
+ * @param buf_size Tamanho do buffer.
+ * @return O número de bytes necessários (sem o '\0'), como snprintf.
+ */
+size_t boot_trace_export_chrome_json(char *buf, size_t buf_size);
+
+#endif // ARCANOS_BOOT_TRACE_H
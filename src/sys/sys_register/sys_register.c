@@ -2,44 +2,436 @@
 // Implementação do sistema de registro de inicialização de subsistemas.
 
 #include "sys_register.h"
+#include "boot_trace.h"
 #include "../kernel/kernl/printk/printk.h" // Para KERN_INFO
+#include "../../bootloader/libbootloader/boot_info.h" // ArcSmpMailbox
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
 
 #define MAX_SYS_INIT_FNS 32 // Limite máximo de subsistemas que podem se registrar
 
-// O array para armazenar os ponteiros de função de registro
-static SysInitFn registered_init_fns[MAX_SYS_INIT_FNS] = {0};
+// O grafo é representado por máscaras de bits de 32 bits (uma por rotina).
+_Static_assert(MAX_SYS_INIT_FNS <= 32, "Mascaras de dependencia usam uint32_t");
+
+// Funções externas da arquitetura
+extern void arch_cpu_relax(void);
+
+// Entrada registrada
+typedef struct {
+    const char *name;                        // NULL para rotinas legadas (sem nome)
+    SysInitFn init_func;
+    const char *deps[SYS_INIT_MAX_DEPS];     // Dependências declaradas (por nome)
+    uint32_t dep_count;
+    int legacy_prev;                         // Rotina legada anterior (-1 se nenhuma)
+    bool is_lazy;                            // Classe "lazy": fora do boot crítico
+} SysInitEntry;
+
+// Estados do once-guard de cada rotina
+enum {
+    SYS_ONCE_PENDING = 0,
+    SYS_ONCE_RUNNING = 1,
+    SYS_ONCE_DONE    = 2
+};
+
+// O array para armazenar as rotinas registradas
+static SysInitEntry registered_init_fns[MAX_SYS_INIT_FNS];
 static int current_fn_count = 0;
+static int last_legacy_idx = -1;
 
+// Grafo resolvido: bit j em dep_mask[i] <=> i depende de j
+static uint32_t dep_mask[MAX_SYS_INIT_FNS];
+static uint32_t dependents_mask[MAX_SYS_INIT_FNS];
+static uint32_t acyclic_mask;  // Rotinas fora de ciclos
+static uint32_t lazy_mask;     // Rotinas da classe "lazy"
 
-void sys_register_init_fn(SysInitFn init_func) {
+// Once-guard do grafo (mesmos estados de init_state): sys_require() e a
+// passada em idle podem chegar de outros núcleos enquanto o boot roda.
+// Um registro novo volta o estado para PENDING (registros acontecem antes
+// do boot, em um único núcleo).
+static atomic_int graph_state;
+
+// O trace é limpo uma única vez, na primeira entrada no executor: eventos de
+// um sys_require() anterior ao boot continuam no relatório.
+static atomic_flag trace_started = ATOMIC_FLAG_INIT;
+
+// Garante execução única de cada rotina, seja pelo boot, por sys_require()
+// ou pela passada em idle.
+static atomic_int init_state[MAX_SYS_INIT_FNS];
+
+// Estado do executor paralelo. A fila de prontos nunca recebe a mesma rotina
+// duas vezes, então MAX_SYS_INIT_FNS posições bastam (sem wrap-around).
+static atomic_uint pending_deps[MAX_SYS_INIT_FNS];
+static atomic_int ready_queue[MAX_SYS_INIT_FNS];
+static atomic_uint ready_head;
+static atomic_uint ready_tail;
+static atomic_uint done_count;
+static uint32_t run_total;
+
+// Núcleos secundários herdados do bootloader (sys_attach_boot_cpus). Sem
+// eles, o executor roda só no núcleo de boot.
+static ArcSmpMailbox *boot_mailboxes;
+static uint32_t boot_cpu_count = 1;
+
+
+static const char *sys_init_name(int idx) {
+    return registered_init_fns[idx].name ? registered_init_fns[idx].name : "<anonima>";
+}
+
+static int sys_add_entry(const char *name, SysInitFn init_func, const char *const *deps,
+                         bool is_lazy) {
     if (init_func == NULL) {
         KERN_ERR("SYS_REG: Tentativa de registrar função NULL ignorada.");
-        return;
+        return -1;
     }
     
-    if (current_fn_count < MAX_SYS_INIT_FNS) {
-        // Armazena a função de inicialização no próximo slot disponível
-        registered_init_fns[current_fn_count] = init_func;
-        current_fn_count++;
-        KERN_DEBUG("SYS_REG: Função registrada com sucesso. Total: %d.", current_fn_count);
-    } else {
+    if (current_fn_count >= MAX_SYS_INIT_FNS) {
         KERN_CRIT("SYS_REG: Falha ao registrar subsistema. Limite de %d atingido!", MAX_SYS_INIT_FNS);
+        return -1;
+    }
+
+    SysInitEntry *entry = &registered_init_fns[current_fn_count];
+    memset(entry, 0, sizeof(*entry));
+    entry->name = name;
+    entry->init_func = init_func;
+    entry->legacy_prev = -1;
+    entry->is_lazy = is_lazy;
+
+    for (; deps != NULL && deps[entry->dep_count] != NULL; entry->dep_count++) {
+        if (entry->dep_count == SYS_INIT_MAX_DEPS) {
+            KERN_ERR("SYS_REG: '%s' declara mais de %d dependências.", name, SYS_INIT_MAX_DEPS);
+            return -1;
+        }
+        entry->deps[entry->dep_count] = deps[entry->dep_count];
+    }
+
+    atomic_store(&init_state[current_fn_count], SYS_ONCE_PENDING);
+    atomic_store(&graph_state, SYS_ONCE_PENDING);
+    current_fn_count++;
+    KERN_DEBUG("SYS_REG: Função registrada com sucesso. Total: %d.", current_fn_count);
+    return current_fn_count - 1;
+}
+
+
+void sys_register_init_fn(SysInitFn init_func) {
+    int idx = sys_add_entry(NULL, init_func, NULL, false);
+    if (idx < 0) {
+        return;
+    }
+    // Rotinas sem dependências declaradas mantêm a ordem relativa entre si.
+    registered_init_fns[idx].legacy_prev = last_legacy_idx;
+    last_legacy_idx = idx;
+}
+
+static int sys_register_named(const char *name, SysInitFn init_func,
+                              const char *const *deps, bool is_lazy) {
+    if (name == NULL) {
+        KERN_ERR("SYS_REG: Registro nomeado sem nome ignorado.");
+        return -1;
+    }
+    for (int i = 0; i < current_fn_count; i++) {
+        if (registered_init_fns[i].name && strcmp(registered_init_fns[i].name, name) == 0) {
+            KERN_ERR("SYS_REG: Subsistema '%s' já registrado.", name);
+            return -1;
+        }
+    }
+    return sys_add_entry(name, init_func, deps, is_lazy) < 0 ? -1 : 0;
+}
+
+int sys_register_init(const char *name, SysInitFn init_func, const char *const *deps) {
+    return sys_register_named(name, init_func, deps, false);
+}
+
+int sys_register_lazy_init(const char *name, SysInitFn init_func, const char *const *deps) {
+    return sys_register_named(name, init_func, deps, true);
+}
+
+
+static int sys_find_by_name(const char *name) {
+    for (int i = 0; i < current_fn_count; i++) {
+        if (registered_init_fns[i].name && strcmp(registered_init_fns[i].name, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static uint32_t sys_compute_acyclic(void);
+
+// Converte as dependências por nome em máscaras de bits.
+static void sys_build_graph(void) {
+    memset(dep_mask, 0, sizeof(dep_mask));
+    memset(dependents_mask, 0, sizeof(dependents_mask));
+
+    for (int i = 0; i < current_fn_count; i++) {
+        SysInitEntry *entry = &registered_init_fns[i];
+
+        if (entry->legacy_prev >= 0) {
+            dep_mask[i] |= 1u << entry->legacy_prev;
+        }
+        for (uint32_t d = 0; d < entry->dep_count; d++) {
+            int j = sys_find_by_name(entry->deps[d]);
+            if (j < 0 || j == i) {
+                KERN_ERR("SYS_REG: '%s' depende de '%s', que não existe. Ignorado.",
+                         sys_init_name(i), entry->deps[d]);
+                continue;
+            }
+            dep_mask[i] |= 1u << j;
+        }
+    }
+
+    lazy_mask = 0;
+    for (int i = 0; i < current_fn_count; i++) {
+        for (uint32_t deps = dep_mask[i]; deps; deps &= deps - 1) {
+            dependents_mask[__builtin_ctz(deps)] |= 1u << i;
+        }
+        if (registered_init_fns[i].is_lazy) {
+            lazy_mask |= 1u << i;
+        }
+    }
+
+    acyclic_mask = sys_compute_acyclic();
+}
+
+// Monta o grafo uma única vez; quem perde a corrida espera a montagem terminar.
+static void sys_ensure_graph(void) {
+    if (!atomic_flag_test_and_set(&trace_started)) {
+        boot_trace_reset();
+    }
+    if (atomic_load(&graph_state) == SYS_ONCE_DONE) {
+        return;
+    }
+    int expected = SYS_ONCE_PENDING;
+    if (!atomic_compare_exchange_strong(&graph_state, &expected, SYS_ONCE_RUNNING)) {
+        while (atomic_load(&graph_state) != SYS_ONCE_DONE) {
+            arch_cpu_relax();
+        }
+        return;
+    }
+    sys_build_graph();
+    atomic_store(&graph_state, SYS_ONCE_DONE);
+}
+
+// Retorna a máscara das rotinas alcançáveis sem passar por um ciclo (Kahn).
+// As que sobram estão em um ciclo ou dependem de um.
+static uint32_t sys_compute_acyclic(void) {
+    uint32_t all = current_fn_count == 32 ? 0xFFFFFFFFu : (1u << current_fn_count) - 1;
+    uint32_t resolved = 0;
+    bool progress = true;
+
+    while (progress) {
+        progress = false;
+        for (uint32_t left = all & ~resolved; left; left &= left - 1) {
+            int i = __builtin_ctz(left);
+            if ((dep_mask[i] & ~resolved) == 0) {
+                resolved |= 1u << i;
+                progress = true;
+            }
+        }
+    }
+    return resolved;
+}
+
+
+// Executa uma rotina no máximo uma vez, medindo seu tempo no trace de boot.
+// Quem perde a corrida espera a execução em andamento terminar.
+static void sys_run_once(int idx) {
+    int expected = SYS_ONCE_PENDING;
+    if (!atomic_compare_exchange_strong(&init_state[idx], &expected, SYS_ONCE_RUNNING)) {
+        while (atomic_load(&init_state[idx]) != SYS_ONCE_DONE) {
+            arch_cpu_relax();
+        }
+        return;
+    }
+
+    uint64_t start_ns = boot_trace_now_ns();
+    registered_init_fns[idx].init_func();
+    boot_trace_record(sys_init_name(idx), (uint32_t)idx, dep_mask[idx],
+                      start_ns, boot_trace_now_ns());
+
+    atomic_store(&init_state[idx], SYS_ONCE_DONE);
+}
+
+// Executa as dependências ainda pendentes (ex: rotinas lazy) e depois a própria rotina.
+// Só segue arestas da parte acíclica, então a recursão sempre termina.
+static void sys_ensure_initialized(int idx) {
+    if (atomic_load(&init_state[idx]) == SYS_ONCE_DONE) {
+        return;
+    }
+    for (uint32_t deps = dep_mask[idx] & acyclic_mask; deps; deps &= deps - 1) {
+        sys_ensure_initialized(__builtin_ctz(deps));
+    }
+    sys_run_once(idx);
+}
+
+static void sys_ready_push(int idx) {
+    uint32_t slot = atomic_fetch_add(&ready_tail, 1);
+    atomic_store(&ready_queue[slot], idx);
+}
+
+// Laço executado por cada núcleo participante (inclusive o de boot).
+static void sys_init_worker(void) {
+    while (atomic_load(&done_count) < run_total) {
+        uint32_t head = atomic_load(&ready_head);
+        if (head >= atomic_load(&ready_tail)) {
+            arch_cpu_relax();
+            continue;
+        }
+        if (!atomic_compare_exchange_weak(&ready_head, &head, head + 1)) {
+            continue;
+        }
+
+        // A posição foi reservada pelo produtor; aguarda a escrita do índice.
+        int idx;
+        while ((idx = atomic_load(&ready_queue[head])) < 0) {
+            arch_cpu_relax();
+        }
+
+        sys_ensure_initialized(idx);
+
+        for (uint32_t deps = dependents_mask[idx]; deps; deps &= deps - 1) {
+            int d = __builtin_ctz(deps);
+            if (atomic_fetch_sub(&pending_deps[d], 1) == 1) {
+                sys_ready_push(d);
+            }
+        }
+        atomic_fetch_add(&done_count, 1);
+    }
+}
+
+
+void sys_attach_boot_cpus(uint32_t cpu_count, uint64_t mailboxes_paddr) {
+    if (mailboxes_paddr == 0 || cpu_count <= 1) {
+        return;
     }
+    // O kernel ainda roda sobre o mapa identidade do boot
+    boot_mailboxes = (ArcSmpMailbox *)(uintptr_t)mailboxes_paddr;
+    boot_cpu_count = cpu_count > ARC_SMP_MAX_CPUS ? ARC_SMP_MAX_CPUS : cpu_count;
 }
 
+static void sys_boot_cpu_work(uint32_t cpu, uint32_t ncpus, void *arg) {
+    (void)cpu;
+    (void)ncpus;
+    (void)arg;
+    sys_init_worker();
+}
+
+// Publica o laço do executor na caixa de correio de um AP ocioso do bootloader
+static bool sys_start_on_cpu(uint32_t cpu) {
+    if (boot_mailboxes == NULL || cpu == 0 || cpu >= boot_cpu_count) {
+        return false;
+    }
+    ArcSmpMailbox *mb = &boot_mailboxes[cpu];
+    while (atomic_load_explicit(&mb->done, memory_order_acquire) !=
+           atomic_load_explicit(&mb->seq, memory_order_relaxed)) {
+        arch_cpu_relax(); // Trabalho anterior do bootloader ainda em andamento
+    }
+    mb->fn = sys_boot_cpu_work;
+    mb->arg = NULL;
+    atomic_fetch_add_explicit(&mb->seq, 1, memory_order_release);
+    return true;
+}
+
+// Espera o AP voltar ao laço ocioso (o executor não deixa trabalho pendente)
+static void sys_wait_cpu(uint32_t cpu) {
+    ArcSmpMailbox *mb = &boot_mailboxes[cpu];
+    while (atomic_load_explicit(&mb->done, memory_order_acquire) !=
+           atomic_load_explicit(&mb->seq, memory_order_relaxed)) {
+        arch_cpu_relax();
+    }
+}
 
 void sys_run_init_routines(void) {
     KERN_INFO("SYS_REG: Iniciando rotinas de inicialização registradas (%d funções)...", current_fn_count);
-    
-    // Itera sobre todas as funções registradas e as executa
+
+    sys_ensure_graph();
+
+    // 1. Prepara o executor apenas com a parte acíclica e não-lazy do grafo.
+    // Dependências lazy de uma rotina de boot são executadas sob demanda por ela.
+    uint32_t critical = acyclic_mask & ~lazy_mask;
+    run_total = (uint32_t)__builtin_popcount(critical);
+    atomic_store(&ready_head, 0);
+    atomic_store(&ready_tail, 0);
+    atomic_store(&done_count, 0);
+    for (int i = 0; i < MAX_SYS_INIT_FNS; i++) {
+        atomic_store(&ready_queue[i], -1);
+    }
     for (int i = 0; i < current_fn_count; i++) {
-        SysInitFn init_func = registered_init_fns[i];
-        
-        if (init_func != NULL) {
-            // Executa a função. (O nome da função não é sabido aqui)
-            init_func(); 
+        dependents_mask[i] &= critical;
+        atomic_store(&pending_deps[i], (uint32_t)__builtin_popcount(dep_mask[i] & critical));
+    }
+    // Raízes entram em ordem de registro: com um único núcleo a execução é determinística.
+    for (uint32_t left = critical; left; left &= left - 1) {
+        int i = __builtin_ctz(left);
+        if ((dep_mask[i] & critical) == 0) {
+            sys_ready_push(i);
+        }
+    }
+
+    // 2. Distribui entre os núcleos (o núcleo de boot também trabalha)
+    uint32_t cpus = boot_cpu_count;
+    if (cpus > run_total) {
+        cpus = run_total;
+    }
+    uint32_t started = 1;
+    for (uint32_t cpu = 1; cpu < cpus; cpu++) {
+        if (sys_start_on_cpu(cpu)) {
+            started++;
         }
     }
+    KERN_DEBUG("SYS_REG: Executando %u rotinas em %u núcleo(s).", run_total, started);
+    sys_init_worker();
+    for (uint32_t cpu = 1; cpu < started; cpu++) {
+        sys_wait_cpu(cpu);
+    }
+
+    // 3. Fallback determinístico: rotinas em ciclo rodam serialmente, em ordem de registro
+    for (int i = 0; i < current_fn_count; i++) {
+        if ((acyclic_mask | lazy_mask) & (1u << i)) {
+            continue;
+        }
+        KERN_CRIT("SYS_REG: Dependência circular envolvendo '%s'. Executando em ordem de registro.",
+                  sys_init_name(i));
+        sys_run_once(i);
+    }
     
     KERN_INFO("SYS_REG: Todas as rotinas de inicialização concluídas.");
+    boot_trace_print_report();
+}
+
+
+bool sys_require(const char *name) {
+    int idx = sys_find_by_name(name);
+    if (idx < 0) {
+        KERN_ERR("SYS_REG: sys_require('%s'): subsistema desconhecido.", name);
+        return false;
+    }
+
+    // Caminho rápido: já inicializado (uma leitura atômica).
+    if (atomic_load(&init_state[idx]) == SYS_ONCE_DONE) {
+        return true;
+    }
+    sys_ensure_graph(); // Pode ser chamado antes de sys_run_init_routines()
+    sys_ensure_initialized(idx);
+    return true;
+}
+
+void sys_run_deferred_inits(void) {
+    sys_ensure_graph();
+
+    uint32_t ran = 0;
+    for (uint32_t left = lazy_mask; left; left &= left - 1) {
+        int i = __builtin_ctz(left);
+        if (atomic_load(&init_state[i]) != SYS_ONCE_DONE) {
+            sys_ensure_initialized(i);
+            ran++;
+        }
+    }
+    KERN_DEBUG("SYS_REG: Passada em idle concluída (%u rotinas lazy executadas).", ran);
+}
+
+// Funções externas simuladas:
+void arch_cpu_relax(void) {
+    // x86_64: pause / ARM64: yield
 }
@@ -2,6 +2,7 @@
 #define ARCANOS_SYS_REGISTER_H
 
 #include <stdint.h>
+#include <stdbool.h>
 
 // ----------------------------------------------------
 // 1. Tipo de Função de Registro (Sua intenção original)
@@ -13,20 +14,74 @@
  */
 typedef void (*SysInitFn)(void);
 
+// Número máximo de dependências declaradas por rotina.
+#define SYS_INIT_MAX_DEPS 8
+
 // ----------------------------------------------------
 // 2. Interface de Registro
 // ----------------------------------------------------
 
 /**
  * @brief Registra um subsistema para inicialização tardia.
- * * @param init_func O ponteiro para a função de inicialização do subsistema.
+ * * Rotinas registradas por aqui não têm nome nem dependências declaradas;
+ * * para preservar o comportamento antigo, cada uma depende da anterior
+ * * registrada por esta mesma função (ordem de registro mantida entre elas).
+ * @param init_func O ponteiro para a função de inicialização do subsistema.
  */
 void sys_register_init_fn(SysInitFn init_func);
 
+/**
+ * @brief Registra um subsistema nomeado com dependências declaradas.
+ * * As dependências são resolvidas por nome em sys_run_init_routines(), então a
+ * * ordem de registro entre dependente e dependência não importa.
+ * @param name Nome único do subsistema (string estática, ex: "snap").
+ * @param init_func O ponteiro para a função de inicialização.
+ * @param deps Array de nomes terminado em NULL (ou NULL se não houver dependências).
+ * @return 0 em caso de sucesso, -1 se o registro for rejeitado.
+ */
+int sys_register_init(const char *name, SysInitFn init_func, const char *const *deps);
+
+/**
+ * @brief Registra um subsistema da classe "lazy" (inicialização adiada).
+ * * A rotina não roda no boot crítico: roda no máximo uma vez, no primeiro
+ * * sys_require(name) ou na passada em idle (sys_run_deferred_inits()), o que
+ * * vier primeiro. Rotinas de boot que dependem dela a executam sob demanda.
+ * @return 0 em caso de sucesso, -1 se o registro for rejeitado.
+ */
+int sys_register_lazy_init(const char *name, SysInitFn init_func, const char *const *deps);
+
+/**
+ * @brief Entrega ao executor os núcleos que o bootloader deixou ociosos.
+ * * Recebe ArcBootInfo::cpu_count e ::smp_mailboxes_paddr (boot_info.h). Deve
+ * * ser chamado antes de sys_run_init_routines(); sem ele, tudo roda no núcleo
+ * * de boot.
+ */
+void sys_attach_boot_cpus(uint32_t cpu_count, uint64_t mailboxes_paddr);
+
 /**
  * @brief Executa todas as funções de inicialização registradas.
+ * * Monta o grafo de dependências e executa rotinas independentes em paralelo
+ * * em todos os núcleos disponíveis. Se houver ciclo, as rotinas envolvidas
+ * * rodam serialmente, em ordem de registro, após o restante do grafo.
+ * * Cada rotina é cronometrada no trace de boot (boot_trace.h); o relatório
+ * * com tabela e caminho crítico é impresso ao final.
  * * Chamado uma vez no final do boot do Kernel.
  */
 void sys_run_init_routines(void);
 
+/**
+ * @brief Garante que um subsistema (e suas dependências) esteja inicializado.
+ * * Thread-safe: chamadas concorrentes esperam a única execução terminar.
+ * * Depois da primeira vez, custa uma leitura atômica.
+ * @param name Nome do subsistema.
+ * @return false se o nome não estiver registrado.
+ */
+bool sys_require(const char *name);
+
+/**
+ * @brief Passada em idle: executa as rotinas lazy que ainda não rodaram.
+ * * Chamado pela tarefa idle depois que o boot crítico termina.
+ */
+void sys_run_deferred_inits(void);
+
 #endif // ARCANOS_SYS_REGISTER_H
@@ -0,0 +1,394 @@
+// src/update/delta_engine.cc
+// Execução paralela das operações delta sobre o slot inativo.
+
+#include "delta_engine.h"
+#include "../android/fastboot/sha256.h" // SHA-256 compartilhado com o Fastboot
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/falloc.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace arcanos::update {
+
+using arcanos::fastboot::Sha256;
+
+ScopedFd::~ScopedFd() {
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+// Limite por operação: mantém a memória de cada worker previsível
+static constexpr uint64_t kMaxOpBytes = 64ull * 1024 * 1024;
+
+static bool sha256Matches(const uint8_t* data, size_t len, const uint8_t expected[32]) {
+    Sha256 sha;
+    sha.update(data, len);
+    uint8_t digest[32];
+    sha.finish(digest);
+    return std::memcmp(digest, expected, sizeof(digest)) == 0;
+}
+
+// a + b <= limit, sem overflow
+static bool rangeFits(uint64_t start, uint64_t count, uint64_t limit) {
+    return start <= limit && count <= limit - start;
+}
+
+int delta_validate(const UpdateDeltaHeader& header, const UpdateDeltaOp* ops,
+                   uint64_t source_blocks, uint64_t data_size) {
+    if (std::memcmp(header.magic, UPDATE_DELTA_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != UPDATE_DELTA_VERSION) {
+        return UPDATE_ERR_FORMAT;
+    }
+    if (header.block_size < 512 || header.block_size % 512 != 0 || header.block_size > kMaxOpBytes) {
+        return UPDATE_ERR_FORMAT;
+    }
+    const uint64_t bs = header.block_size;
+    const uint64_t max_blocks = kMaxOpBytes / bs;
+
+    std::vector<uint32_t> by_dst(header.op_count);
+    for (uint32_t i = 0; i < header.op_count; i++) {
+        const UpdateDeltaOp& op = ops[i];
+        by_dst[i] = i;
+        if (op.dst_blocks == 0 || op.dst_blocks > max_blocks ||
+            !rangeFits(op.dst_start, op.dst_blocks, header.target_blocks) ||
+            !rangeFits(op.data_offset, op.data_length, data_size)) {
+            return UPDATE_ERR_FORMAT;
+        }
+        bool uses_source = op.type == UPDATE_OP_COPY || op.type == UPDATE_OP_DIFF;
+        if (uses_source && (op.src_blocks == 0 || op.src_blocks > max_blocks ||
+                            !rangeFits(op.src_start, op.src_blocks, source_blocks))) {
+            return UPDATE_ERR_FORMAT;
+        }
+
+        switch (op.type) {
+        case UPDATE_OP_REPLACE:
+            if (op.data_length != op.dst_blocks * bs) {
+                return UPDATE_ERR_FORMAT;
+            }
+            break;
+        case UPDATE_OP_ZERO:
+            if (op.data_length != 0) {
+                return UPDATE_ERR_FORMAT;
+            }
+            break;
+        case UPDATE_OP_COPY:
+            if (op.src_blocks != op.dst_blocks || op.data_length != 0) {
+                return UPDATE_ERR_FORMAT;
+            }
+            break;
+        case UPDATE_OP_DIFF:
+            if (op.data_length < sizeof(uint32_t) || op.data_length > kMaxOpBytes) {
+                return UPDATE_ERR_FORMAT;
+            }
+            break;
+        default:
+            return UPDATE_ERR_FORMAT;
+        }
+    }
+
+    // Destinos disjuntos: é o que torna as operações independentes
+    std::sort(by_dst.begin(), by_dst.end(),
+              [&](uint32_t a, uint32_t b) { return ops[a].dst_start < ops[b].dst_start; });
+    for (size_t i = 1; i < by_dst.size(); i++) {
+        const UpdateDeltaOp& prev = ops[by_dst[i - 1]];
+        if (prev.dst_start + prev.dst_blocks > ops[by_dst[i]].dst_start) {
+            return UPDATE_ERR_FORMAT;
+        }
+    }
+    return UPDATE_OK;
+}
+
+uint64_t delta_device_blocks(int fd, uint32_t block_size) {
+    struct stat st;
+    if (fstat(fd, &st) != 0 || block_size == 0) {
+        return 0;
+    }
+    uint64_t bytes = static_cast<uint64_t>(st.st_size);
+    if (S_ISBLK(st.st_mode) && ioctl(fd, BLKGETSIZE64, &bytes) != 0) {
+        return 0;
+    }
+    return bytes / block_size;
+}
+
+int delta_prepare_target(int fd, const UpdateDeltaHeader& header) {
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        return UPDATE_ERR_IO;
+    }
+    if (S_ISREG(st.st_mode)) {
+        uint64_t bytes = header.target_blocks * header.block_size;
+        return ftruncate(fd, static_cast<off_t>(bytes)) == 0 ? UPDATE_OK : UPDATE_ERR_IO;
+    }
+    return delta_device_blocks(fd, header.block_size) >= header.target_blocks ? UPDATE_OK : UPDATE_ERR_FORMAT;
+}
+
+int delta_verify_target(int fd, const UpdateDeltaHeader& header) {
+    static const uint8_t kNoHash[32] = {};
+    if (std::memcmp(header.target_sha256, kNoHash, sizeof(kNoHash)) == 0) {
+        return UPDATE_OK;
+    }
+    Sha256 sha;
+    std::vector<uint8_t> buf(1024 * 1024);
+    uint64_t bytes = header.target_blocks * header.block_size;
+    uint64_t offset = 0;
+    while (offset < bytes) {
+        size_t want = static_cast<size_t>(std::min<uint64_t>(buf.size(), bytes - offset));
+        ssize_t n = pread(fd, buf.data(), want, static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return UPDATE_ERR_IO;
+        }
+        sha.update(buf.data(), static_cast<size_t>(n));
+        offset += static_cast<uint64_t>(n);
+    }
+    uint8_t digest[32];
+    sha.finish(digest);
+    return std::memcmp(digest, header.target_sha256, sizeof(digest)) == 0 ? UPDATE_OK : UPDATE_ERR_HASH;
+}
+
+// Aplica o diff estilo bsdiff de 'payload' sobre 'source', produzindo 'out' inteiro
+static int applyDiff(const uint8_t* source, size_t source_len, const uint8_t* payload, size_t payload_len,
+                     uint8_t* out, size_t out_len) {
+    uint32_t count;
+    std::memcpy(&count, payload, sizeof(count));
+    size_t header = sizeof(count) + static_cast<size_t>(count) * sizeof(UpdateDiffControl);
+    if (count > payload_len / sizeof(UpdateDiffControl) || header > payload_len) {
+        return UPDATE_ERR_FORMAT;
+    }
+
+    const uint8_t* stream = payload + header;
+    size_t stream_left = payload_len - header;
+    size_t produced = 0;
+    int64_t pos = 0;
+    for (uint32_t c = 0; c < count; c++) {
+        UpdateDiffControl ctl;
+        std::memcpy(&ctl, payload + sizeof(count) + c * sizeof(ctl), sizeof(ctl));
+        uint64_t total = static_cast<uint64_t>(ctl.add_len) + ctl.copy_len;
+        if (total > out_len - produced || total > stream_left ||
+            pos < 0 || static_cast<uint64_t>(pos) + ctl.add_len > source_len) {
+            return UPDATE_ERR_FORMAT;
+        }
+        const uint8_t* from = source + pos;
+        for (uint32_t i = 0; i < ctl.add_len; i++) {
+            out[produced + i] = static_cast<uint8_t>(from[i] + stream[i]);
+        }
+        std::memcpy(out + produced + ctl.add_len, stream + ctl.add_len, ctl.copy_len);
+        produced += total;
+        stream += total;
+        stream_left -= total;
+        pos += static_cast<int64_t>(ctl.add_len) + ctl.seek;
+    }
+    return produced == out_len && stream_left == 0 ? UPDATE_OK : UPDATE_ERR_FORMAT;
+}
+
+DeltaEngine::DeltaEngine(int source_fd, int target_fd, uint32_t block_size,
+                         unsigned threads, size_t max_inflight_bytes)
+    : source_fd_(source_fd), target_fd_(target_fd), block_size_(block_size),
+      max_inflight_(max_inflight_bytes ? max_inflight_bytes : 64 * 1024 * 1024) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (unsigned i = 0; i < threads; i++) {
+        workers_.emplace_back(&DeltaEngine::workerLoop, this);
+    }
+}
+
+DeltaEngine::~DeltaEngine() {
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        stopping_ = true;
+    }
+    work_ready_.notify_all();
+    for (std::thread& t : workers_) {
+        t.join();
+    }
+    for (Task* task : queue_) {
+        delete task;
+    }
+}
+
+void DeltaEngine::setError(int error) {
+    int expected = UPDATE_OK;
+    error_.compare_exchange_strong(expected, error, std::memory_order_acq_rel);
+}
+
+int DeltaEngine::submit(const UpdateDeltaOp& op, const uint8_t* payload, std::vector<uint8_t>&& owned) {
+    if (status() != UPDATE_OK) {
+        return status();
+    }
+    Task* task = new Task();
+    task->op = op;
+    task->owned = std::move(owned);
+    task->payload = task->owned.empty() ? payload : task->owned.data();
+
+    bool uses_source = op.type == UPDATE_OP_COPY || op.type == UPDATE_OP_DIFF;
+    size_t source_len = uses_source ? static_cast<size_t>(op.src_blocks * block_size_) : 0;
+    task->cost = source_len + task->owned.size() +
+                 (op.type == UPDATE_OP_DIFF ? static_cast<size_t>(op.dst_blocks * block_size_) : 0);
+
+    {
+        // Uma operação maior que o limite ainda passa sozinha
+        std::unique_lock<std::mutex> lock(lock_);
+        space_ready_.wait(lock, [&] {
+            return inflight_ == 0 || inflight_ + task->cost <= max_inflight_ || status() != UPDATE_OK;
+        });
+        inflight_ += task->cost;
+        // Conta a tarefa já na reserva: finish() espera por ela mesmo antes de
+        // entrar na fila (a leitura da origem abaixo é feita sem a trava)
+        pending_++;
+    }
+
+    // Leitura da origem aqui, na ordem em que o chamador submete
+    if (uses_source) {
+        task->source.resize(source_len);
+        uint8_t* p = task->source.data();
+        uint64_t offset = op.src_start * block_size_;
+        size_t left = source_len;
+        while (left > 0) {
+            ssize_t n = pread(source_fd_, p, left, static_cast<off_t>(offset));
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                setError(UPDATE_ERR_IO);
+                break;
+            }
+            p += n;
+            offset += static_cast<uint64_t>(n);
+            left -= static_cast<size_t>(n);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        queue_.push_back(task);
+    }
+    work_ready_.notify_one();
+    return status();
+}
+
+void DeltaEngine::workerLoop() {
+    for (;;) {
+        Task* task;
+        {
+            std::unique_lock<std::mutex> lock(lock_);
+            work_ready_.wait(lock, [&] { return stopping_ || !queue_.empty(); });
+            if (queue_.empty()) {
+                return;
+            }
+            task = queue_.front();
+            queue_.pop_front();
+        }
+
+        if (status() == UPDATE_OK) {
+            int result = execute(*task);
+            if (result != UPDATE_OK) {
+                setError(result);
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            inflight_ -= task->cost;
+            pending_--;
+        }
+        delete task;
+        space_ready_.notify_all();
+    }
+}
+
+int DeltaEngine::execute(Task& task) {
+    const UpdateDeltaOp& op = task.op;
+    uint64_t dst_offset = op.dst_start * block_size_;
+    size_t dst_len = static_cast<size_t>(op.dst_blocks * block_size_);
+
+    if ((op.type == UPDATE_OP_COPY || op.type == UPDATE_OP_DIFF) &&
+        !sha256Matches(task.source.data(), task.source.size(), op.src_sha256)) {
+        return UPDATE_ERR_HASH; // Slot ativo diferente do esperado pelo pacote
+    }
+    if ((op.type == UPDATE_OP_REPLACE || op.type == UPDATE_OP_DIFF) &&
+        !sha256Matches(task.payload, static_cast<size_t>(op.data_length), op.data_sha256)) {
+        return UPDATE_ERR_HASH;
+    }
+
+    switch (op.type) {
+    case UPDATE_OP_REPLACE:
+        return writeTarget(dst_offset, task.payload, dst_len);
+    case UPDATE_OP_ZERO:
+        return zeroTarget(dst_offset, dst_len);
+    case UPDATE_OP_COPY:
+        return writeTarget(dst_offset, task.source.data(), dst_len);
+    case UPDATE_OP_DIFF: {
+        std::vector<uint8_t> out(dst_len);
+        int result = applyDiff(task.source.data(), task.source.size(), task.payload,
+                               static_cast<size_t>(op.data_length), out.data(), out.size());
+        return result == UPDATE_OK ? writeTarget(dst_offset, out.data(), out.size()) : result;
+    }
+    default:
+        return UPDATE_ERR_FORMAT;
+    }
+}
+
+int DeltaEngine::writeTarget(uint64_t offset, const uint8_t* data, size_t len) {
+    size_t total = len;
+    while (len > 0) {
+        ssize_t n = pwrite(target_fd_, data, len, static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return UPDATE_ERR_IO;
+        }
+        data += n;
+        offset += static_cast<uint64_t>(n);
+        len -= static_cast<size_t>(n);
+    }
+    written_.fetch_add(total, std::memory_order_relaxed);
+    return UPDATE_OK;
+}
+
+int DeltaEngine::zeroTarget(uint64_t offset, uint64_t len) {
+    // Sem transferir zeros: ZERO_RANGE em arquivos, BLKZEROOUT em nós de bloco
+    if (fallocate(target_fd_, FALLOC_FL_ZERO_RANGE | FALLOC_FL_KEEP_SIZE,
+                  static_cast<off_t>(offset), static_cast<off_t>(len)) == 0) {
+        written_.fetch_add(len, std::memory_order_relaxed);
+        return UPDATE_OK;
+    }
+    uint64_t range[2] = { offset, len };
+    if (ioctl(target_fd_, BLKZEROOUT, range) == 0) {
+        written_.fetch_add(len, std::memory_order_relaxed);
+        return UPDATE_OK;
+    }
+    static const uint8_t zeros[64 * 1024] = {};
+    while (len > 0) {
+        size_t n = static_cast<size_t>(std::min<uint64_t>(len, sizeof(zeros)));
+        int result = writeTarget(offset, zeros, n);
+        if (result != UPDATE_OK) {
+            return result;
+        }
+        offset += n;
+        len -= n;
+    }
+    return UPDATE_OK;
+}
+
+int DeltaEngine::finish() {
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        space_ready_.wait(lock, [&] { return pending_ == 0; });
+    }
+    if (status() == UPDATE_OK && fdatasync(target_fd_) != 0) {
+        setError(UPDATE_ERR_IO);
+    }
+    return status();
+}
+
+} // namespace arcanos::update
@@ -0,0 +1,110 @@
+// src/update/delta_engine.h
+// Motor interno de aplicação das operações delta (compartilhado pelos modos de update).
+
+#ifndef ARCANOS_UPDATE_DELTA_ENGINE_H
+#define ARCANOS_UPDATE_DELTA_ENGINE_H
+
+#include "update_delta.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace arcanos::update {
+
+// Descritor fechado ao sair do escopo
+struct ScopedFd {
+    int fd = -1;
+    ScopedFd() = default;
+    explicit ScopedFd(int f) : fd(f) {}
+    ~ScopedFd();
+    ScopedFd(const ScopedFd&) = delete;
+    ScopedFd& operator=(const ScopedFd&) = delete;
+};
+
+// Confere cabeçalho e tabela de operações: tipos, limites e destinos disjuntos.
+// 'data_size' = bytes disponíveis na área de dados (UINT64_MAX se desconhecido).
+int delta_validate(const UpdateDeltaHeader& header, const UpdateDeltaOp* ops,
+                   uint64_t source_blocks, uint64_t data_size);
+
+// Tamanho do dispositivo/arquivo em blocos (0 em erro)
+uint64_t delta_device_blocks(int fd, uint32_t block_size);
+
+// Destino em arquivo (testes, imagens) ganha o tamanho final; nó de bloco precisa caber
+int delta_prepare_target(int fd, const UpdateDeltaHeader& header);
+
+// Confere header.target_sha256 (se não for zero) lendo o destino em sequência
+int delta_verify_target(int fd, const UpdateDeltaHeader& header);
+
+/**
+ * @brief Executa operações delta em um conjunto de threads.
+ *
+ * submit() lê os blocos de origem na thread chamadora (quem chama decide a
+ * ordem das leituras) e entrega a operação a um worker, que confere os
+ * hashes, aplica e grava no destino. submit() bloqueia enquanto os buffers em
+ * voo passam de 'max_inflight_bytes'. O primeiro erro cancela o restante.
+ */
+class DeltaEngine {
+public:
+    DeltaEngine(int source_fd, int target_fd, uint32_t block_size,
+                unsigned threads, size_t max_inflight_bytes);
+    ~DeltaEngine();
+    DeltaEngine(const DeltaEngine&) = delete;
+    DeltaEngine& operator=(const DeltaEngine&) = delete;
+
+    // 'payload' deve continuar válido até finish(); 'owned' (se não vazio) é o próprio payload.
+    // Pode ser chamado de mais de uma thread.
+    int submit(const UpdateDeltaOp& op, const uint8_t* payload, std::vector<uint8_t>&& owned);
+
+    // Espera as operações já submetidas e faz o flush do destino. Pode ser
+    // chamado várias vezes (barreira antes de um checkpoint). Com submit()
+    // concorrente, inclui toda operação cujo submit() já passou da reserva de
+    // memória, mesmo que ainda esteja lendo a origem.
+    int finish();
+
+    // Primeiro erro até agora (UPDATE_OK se nenhum)
+    int status() const { return error_.load(std::memory_order_acquire); }
+
+    // Bytes de destino já gravados (para progresso)
+    uint64_t bytesWritten() const { return written_.load(std::memory_order_relaxed); }
+
+private:
+    struct Task {
+        UpdateDeltaOp op;
+        const uint8_t* payload = nullptr;
+        std::vector<uint8_t> owned;
+        std::vector<uint8_t> source;
+        size_t cost = 0;
+    };
+
+    void workerLoop();
+    int execute(Task& task);
+    int writeTarget(uint64_t offset, const uint8_t* data, size_t len);
+    int zeroTarget(uint64_t offset, uint64_t len);
+    void setError(int error);
+
+    int source_fd_;
+    int target_fd_;
+    uint32_t block_size_;
+    size_t max_inflight_;
+
+    std::mutex lock_;
+    std::condition_variable work_ready_;
+    std::condition_variable space_ready_;
+    std::deque<Task*> queue_;
+    size_t inflight_ = 0;
+    size_t pending_ = 0; // Reservadas em submit() e ainda não concluídas
+    bool stopping_ = false;
+
+    std::atomic<int> error_{UPDATE_OK};
+    std::atomic<uint64_t> written_{0};
+    std::vector<std::thread> workers_;
+};
+
+} // namespace arcanos::update
+
+#endif // ARCANOS_UPDATE_DELTA_ENGINE_H
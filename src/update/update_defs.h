@@ -12,8 +12,12 @@
 // Variáveis Globais de Estado (Declaradas, a serem definidas em var.cc)
 // ----------------------------------------------------------------------
 
-// O estado atual do processo de atualização (ex: IDLE, DOWNLOAD, APPLY, REBOOT)
-extern int g_update_state; 
+// O estado atual do processo de atualização (ex: IDLE, DOWNLOAD, APPLY, REBOOT).
+// Publicado junto com o progresso em g_update_progress (update_progress.h).
+#define UPDATE_STATE_IDLE     0
+#define UPDATE_STATE_DOWNLOAD 1
+#define UPDATE_STATE_APPLY    2
+#define UPDATE_STATE_REBOOT   3
 
 // A versão do OS para a qual estamos atualizando
 extern char g_target_os_version[32];
@@ -21,6 +25,13 @@ extern char g_target_os_version[32];
 // O status da partição de backup (A/B)
 extern bool g_is_ab_partition_valid;
 
+// Slot ativo (origem das operações delta) e slot inativo (destino do update)
+extern char g_update_source_slot[128];
+extern char g_update_target_slot[128];
+
+// Checkpoint da instalação em streaming (retomada após interrupção)
+extern char g_update_checkpoint_path[128];
+
 // Contador de tentativas de aplicação da atualização (para rollback)
 extern uint8_t g_update_try_count;
 
@@ -29,16 +40,17 @@ extern uint8_t g_update_try_count;
 // Estruturas e Constantes
 // ----------------------------------------------------------------------
 
-// Estrutura para rastrear o progresso do download
+// Retrato do progresso do download/aplicação (ver update_progress_read())
 typedef struct {
+    int state;                 // UPDATE_STATE_*
     uint64_t total_size;
     uint64_t bytes_downloaded;
     bool is_verified;
+    uint64_t elapsed_ms;       // Desde o início da fase atual
+    uint64_t bytes_per_second; // Vazão média da fase atual
+    int64_t eta_seconds;       // -1 = desconhecido
 } UpdateProgress;
 
-// Declaração da instância da estrutura de progresso
-extern UpdateProgress g_current_progress;
-
 
 // ----------------------------------------------------------------------
 // Interfaces de Módulos (Simuladas)
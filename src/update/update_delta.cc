@@ -0,0 +1,147 @@
+// src/update/update_delta.cc
+// Aplicação de pacotes delta no slot A/B inativo.
+
+#include "update_delta.h"
+#include "delta_engine.h"
+#include "update_defs.h"
+#include "update_progress.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+using arcanos::update::DeltaEngine;
+using arcanos::update::ScopedFd;
+
+namespace {
+
+struct Mapping {
+    void* base = MAP_FAILED;
+    size_t length = 0;
+    ~Mapping() {
+        if (base != MAP_FAILED) {
+            munmap(base, length);
+        }
+    }
+};
+
+} // namespace
+
+int update_apply_delta(const char* package_path, const UpdateApplyConfig* config) {
+    if (package_path == nullptr || config == nullptr ||
+        config->source_path == nullptr || config->target_path == nullptr) {
+        return UPDATE_ERR_FORMAT;
+    }
+
+    ScopedFd package, source, target;
+    package.fd = open(package_path, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (package.fd < 0 || fstat(package.fd, &st) != 0) {
+        return UPDATE_ERR_IO;
+    }
+    size_t package_size = static_cast<size_t>(st.st_size);
+    if (package_size < sizeof(UpdateDeltaHeader)) {
+        return UPDATE_ERR_FORMAT;
+    }
+
+    // Payloads são lidos direto do mapeamento, sem cópia para a área de trabalho
+    Mapping map;
+    map.length = package_size;
+    map.base = mmap(nullptr, package_size, PROT_READ, MAP_PRIVATE, package.fd, 0);
+    if (map.base == MAP_FAILED) {
+        return UPDATE_ERR_IO;
+    }
+    madvise(map.base, package_size, MADV_SEQUENTIAL);
+    const uint8_t* bytes = static_cast<const uint8_t*>(map.base);
+
+    UpdateDeltaHeader header;
+    std::memcpy(&header, bytes, sizeof(header));
+    uint64_t table_end = sizeof(header) + static_cast<uint64_t>(header.op_count) * sizeof(UpdateDeltaOp);
+    if (table_end > header.data_offset || header.data_offset > package_size) {
+        return UPDATE_ERR_FORMAT;
+    }
+    std::vector<UpdateDeltaOp> ops(header.op_count);
+    if (!ops.empty()) {
+        std::memcpy(ops.data(), bytes + sizeof(header), ops.size() * sizeof(UpdateDeltaOp));
+    }
+
+    source.fd = open(config->source_path, O_RDONLY | O_CLOEXEC);
+    target.fd = open(config->target_path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (source.fd < 0 || target.fd < 0 || header.block_size == 0) {
+        return source.fd < 0 || target.fd < 0 ? UPDATE_ERR_IO : UPDATE_ERR_FORMAT;
+    }
+
+    int result = arcanos::update::delta_validate(header, ops.data(),
+                                                 arcanos::update::delta_device_blocks(source.fd, header.block_size),
+                                                 package_size - header.data_offset);
+    if (result != UPDATE_OK) {
+        return result;
+    }
+
+    result = arcanos::update::delta_prepare_target(target.fd, header);
+    if (result != UPDATE_OK) {
+        return result;
+    }
+
+    // O slot inativo deixa de ser bootável até a última operação conferir
+    g_is_ab_partition_valid = false;
+
+    // Operações sem origem primeiro (ocupam os workers enquanto a origem é lida);
+    // depois as que leem a origem, em ordem crescente de bloco
+    std::vector<const UpdateDeltaOp*> order;
+    order.reserve(ops.size());
+    for (const UpdateDeltaOp& op : ops) {
+        if (op.type == UPDATE_OP_REPLACE || op.type == UPDATE_OP_ZERO) {
+            order.push_back(&op);
+        }
+    }
+    size_t first_source = order.size();
+    for (const UpdateDeltaOp& op : ops) {
+        if (op.type == UPDATE_OP_COPY || op.type == UPDATE_OP_DIFF) {
+            order.push_back(&op);
+        }
+    }
+    std::sort(order.begin() + first_source, order.end(),
+              [](const UpdateDeltaOp* a, const UpdateDeltaOp* b) { return a->src_start < b->src_start; });
+
+    // Progresso em bytes do destino gravados pelos workers
+    const uint8_t* data_area = bytes + header.data_offset;
+    update_progress_start(UPDATE_STATE_APPLY, header.target_blocks * header.block_size, 0);
+    {
+        DeltaEngine engine(source.fd, target.fd, header.block_size, config->threads, config->max_inflight_bytes);
+        for (const UpdateDeltaOp* op : order) {
+            if (engine.submit(*op, data_area + op->data_offset, std::vector<uint8_t>()) != UPDATE_OK) {
+                break;
+            }
+            update_progress_advance(engine.bytesWritten());
+        }
+        result = engine.finish();
+        update_progress_advance(engine.bytesWritten());
+    }
+    if (result == UPDATE_OK) {
+        result = arcanos::update::delta_verify_target(target.fd, header);
+    }
+    if (result != UPDATE_OK) {
+        printf("update: falha ao aplicar o pacote delta %s (erro %d)\n", package_path, result);
+        return result;
+    }
+
+    g_is_ab_partition_valid = true;
+    printf("update: pacote delta aplicado em %s (%u operações)\n", config->target_path, header.op_count);
+    return UPDATE_OK;
+}
+
+int update_apply_package(const char* package_path) {
+    UpdateApplyConfig config = {};
+    config.source_path = g_update_source_slot;
+    config.target_path = g_update_target_slot;
+
+    g_update_try_count++;
+    int result = update_apply_delta(package_path, &config);
+    update_progress_finish(result == UPDATE_OK ? UPDATE_STATE_REBOOT : UPDATE_STATE_IDLE, result == UPDATE_OK);
+    return result;
+}
@@ -0,0 +1,103 @@
+// src/update/update_delta.h
+// Formato do pacote delta (diferença por blocos) e motor de aplicação no slot A/B inativo.
+
+#ifndef ARCANOS_UPDATE_DELTA_H
+#define ARCANOS_UPDATE_DELTA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// ----------------------------------------------------------------------
+// Formato do pacote (little-endian)
+// ----------------------------------------------------------------------
+//
+//   UpdateDeltaHeader
+//   UpdateDeltaOp[op_count]
+//   área de dados (payloads de REPLACE e DIFF, referenciados por offset)
+//
+// Cada operação produz 'dst_blocks' blocos no slot de destino a partir de
+// dados do pacote e/ou de blocos do slot ativo (origem). Os blocos de
+// destino de operações diferentes não se sobrepõem, então todas são
+// independentes entre si.
+
+#define UPDATE_DELTA_MAGIC "ARCDLTA1"
+#define UPDATE_DELTA_VERSION 1
+
+// Tipos de operação
+#define UPDATE_OP_REPLACE 1 // Payload cru gravado no destino
+#define UPDATE_OP_ZERO    2 // Blocos de destino zerados
+#define UPDATE_OP_COPY    3 // Blocos da origem copiados (conferidos por hash)
+#define UPDATE_OP_DIFF    4 // Origem + diff binário (formato abaixo)
+
+typedef struct {
+    char magic[8];              // UPDATE_DELTA_MAGIC
+    uint32_t version;
+    uint32_t block_size;        // Tamanho do bloco (múltiplo de 512)
+    uint32_t op_count;
+    uint32_t reserved;
+    uint64_t target_blocks;     // Tamanho do slot de destino, em blocos
+    uint64_t data_offset;       // Início da área de dados no pacote
+    uint8_t target_sha256[32];  // Hash da partição final (zeros = não conferir)
+} UpdateDeltaHeader;
+
+typedef struct {
+    uint32_t type;              // UPDATE_OP_*
+    uint32_t reserved;
+    uint64_t src_start;         // Extensão de origem (COPY/DIFF), em blocos
+    uint64_t src_blocks;
+    uint64_t dst_start;         // Extensão de destino, em blocos
+    uint64_t dst_blocks;
+    uint64_t data_offset;       // Payload, relativo a header.data_offset
+    uint64_t data_length;
+    uint8_t src_sha256[32];     // Hash dos blocos de origem (COPY/DIFF)
+    uint8_t data_sha256[32];    // Hash do payload (REPLACE/DIFF)
+} UpdateDeltaOp;
+
+// Payload de UPDATE_OP_DIFF (estilo bsdiff, sem compressão):
+//   uint32_t control_count
+//   UpdateDiffControl[control_count]
+//   bytes de diff e extra, na ordem dos controles
+// Para cada controle: add_len bytes de saída = origem[pos + i] + diff[i];
+// em seguida copy_len bytes literais; depois pos += add_len + seek.
+typedef struct {
+    uint32_t add_len;
+    uint32_t copy_len;
+    int64_t seek;
+} UpdateDiffControl;
+
+// ----------------------------------------------------------------------
+// Aplicação
+// ----------------------------------------------------------------------
+
+// Códigos de retorno (0 = sucesso)
+#define UPDATE_OK            0
+#define UPDATE_ERR_IO       -1 // Falha de leitura/escrita
+#define UPDATE_ERR_FORMAT   -2 // Pacote malformado
+#define UPDATE_ERR_HASH     -3 // Origem, payload ou destino com hash divergente
+#define UPDATE_ERR_NOMEM    -4
+
+typedef struct {
+    const char* source_path;    // Slot ativo (somente leitura)
+    const char* target_path;    // Slot inativo
+    unsigned threads;           // Operações em paralelo (0 = todos os núcleos)
+    size_t max_inflight_bytes;  // Memória para blocos de origem lidos e ainda não aplicados (0 = 64 MiB)
+} UpdateApplyConfig;
+
+/**
+ * @brief Aplica um pacote delta no slot inativo.
+ *
+ * As leituras da origem são feitas por uma única thread, em ordem crescente
+ * de bloco (acesso sequencial ao disco ativo); a conferência de hashes, o
+ * diff e a escrita rodam em paralelo. Só blocos alterados trafegam no pacote.
+ * g_is_ab_partition_valid fica false durante a aplicação e só volta a true
+ * depois que todas as operações (e o hash final, se presente) conferem.
+ *
+ * @return UPDATE_OK ou um UPDATE_ERR_*.
+ */
+int update_apply_delta(const char* package_path, const UpdateApplyConfig* config);
+
+// Autoteste da aplicação e da origem corrompida (update_stream_test.cc); arquivos em 'work_dir'
+int update_delta_run_selftest(const char* work_dir);
+
+#endif // ARCANOS_UPDATE_DELTA_H
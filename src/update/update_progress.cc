@@ -0,0 +1,82 @@
+// src/update/update_progress.cc
+// Seqlock do progresso do update.
+
+#include "update_progress.h"
+#include <chrono>
+#include <thread>
+
+namespace {
+
+uint64_t nowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Abre e fecha a janela de escrita: o par de stores no contador de sequência.
+// Os campos são gravados com release e lidos com acquire: quem enxerga um
+// campo novo enxerga também o contador ímpar e descarta a leitura.
+struct WriteSection {
+    uint32_t seq;
+    WriteSection() : seq(g_update_progress.sequence.load(std::memory_order_relaxed)) {
+        g_update_progress.sequence.store(seq + 1, std::memory_order_relaxed);
+    }
+    ~WriteSection() {
+        g_update_progress.sequence.store(seq + 2, std::memory_order_release);
+    }
+};
+
+} // namespace
+
+void update_progress_start(int state, uint64_t total_size, uint64_t done) {
+    WriteSection section;
+    g_update_progress.state.store(state, std::memory_order_release);
+    g_update_progress.total_size.store(total_size, std::memory_order_release);
+    g_update_progress.bytes_downloaded.store(done, std::memory_order_release);
+    g_update_progress.is_verified.store(false, std::memory_order_release);
+    g_update_progress.start_ns.store(nowNs(), std::memory_order_release);
+    g_update_progress.start_bytes.store(done, std::memory_order_release);
+}
+
+void update_progress_advance(uint64_t bytes_downloaded) {
+    WriteSection section;
+    g_update_progress.bytes_downloaded.store(bytes_downloaded, std::memory_order_release);
+}
+
+void update_progress_finish(int state, bool verified) {
+    WriteSection section;
+    g_update_progress.state.store(state, std::memory_order_release);
+    g_update_progress.is_verified.store(verified, std::memory_order_release);
+}
+
+void update_progress_read(UpdateProgress* out) {
+    uint64_t start_ns, start_bytes;
+    for (;;) {
+        uint32_t seq = g_update_progress.sequence.load(std::memory_order_acquire);
+        if (seq & 1) {
+            std::this_thread::yield(); // Escritor no meio da atualização
+            continue;
+        }
+        out->state = g_update_progress.state.load(std::memory_order_acquire);
+        out->total_size = g_update_progress.total_size.load(std::memory_order_acquire);
+        out->bytes_downloaded = g_update_progress.bytes_downloaded.load(std::memory_order_acquire);
+        out->is_verified = g_update_progress.is_verified.load(std::memory_order_acquire);
+        start_ns = g_update_progress.start_ns.load(std::memory_order_acquire);
+        start_bytes = g_update_progress.start_bytes.load(std::memory_order_acquire);
+        if (g_update_progress.sequence.load(std::memory_order_relaxed) == seq) {
+            break;
+        }
+    }
+
+    // Derivados calculados fora da seção crítica
+    uint64_t now = nowNs();
+    out->elapsed_ms = start_ns != 0 && now > start_ns ? (now - start_ns) / 1000000 : 0;
+    uint64_t done = out->bytes_downloaded > start_bytes ? out->bytes_downloaded - start_bytes : 0;
+    out->bytes_per_second = out->elapsed_ms > 0 ? done * 1000 / out->elapsed_ms : 0;
+    if (out->bytes_downloaded >= out->total_size && out->total_size > 0) {
+        out->eta_seconds = 0;
+    } else if (out->bytes_per_second > 0) {
+        out->eta_seconds = static_cast<int64_t>((out->total_size - out->bytes_downloaded) / out->bytes_per_second);
+    } else {
+        out->eta_seconds = -1;
+    }
+}
@@ -0,0 +1,56 @@
+// src/update/update_progress.h
+// Progresso do update publicado sob seqlock: o escritor nunca bloqueia e o leitor nunca vê valores rasgados.
+
+#ifndef ARCANOS_UPDATE_PROGRESS_H
+#define ARCANOS_UPDATE_PROGRESS_H
+
+#include "update_defs.h"
+#include <atomic>
+
+// Registro compartilhado. Só deve ser acessado pelas funções abaixo.
+// Todos os campos são atômicos (leitura concorrente sem UB); a consistência
+// entre eles vem do contador de sequência.
+typedef struct {
+    std::atomic<uint32_t> sequence;         // Ímpar = escrita em andamento
+    std::atomic<int> state;                 // UPDATE_STATE_*
+    std::atomic<uint64_t> total_size;
+    std::atomic<uint64_t> bytes_downloaded;
+    std::atomic<bool> is_verified;
+    std::atomic<uint64_t> start_ns;         // Relógio monotônico no início da fase
+    std::atomic<uint64_t> start_bytes;      // Bytes já feitos no início (retomada não infla a taxa)
+} UpdateProgressRecord;
+
+// Instância global (definida em var.cc)
+extern UpdateProgressRecord g_update_progress;
+
+// ----------------------------------------------------------------------
+// Escrita (um escritor por vez: a thread que conduz o update). Cada chamada
+// publica seus campos de uma vez, então estado e contadores nunca aparecem
+// misturados de fases diferentes.
+// ----------------------------------------------------------------------
+
+// Início de uma fase: novo estado, zera a taxa e marca 'done' bytes como já feitos
+void update_progress_start(int state, uint64_t total_size, uint64_t done);
+
+void update_progress_advance(uint64_t bytes_downloaded);
+
+// Fim da fase: estado final (REBOOT/IDLE) e resultado da verificação
+void update_progress_finish(int state, bool verified);
+
+// ----------------------------------------------------------------------
+// Leitura (qualquer thread, sem bloqueio)
+// ----------------------------------------------------------------------
+
+/**
+ * @brief Copia um retrato consistente do progresso para 'out'.
+ *
+ * Repete a leitura enquanto houver uma escrita em andamento. Vazão e ETA são
+ * calculados a partir do início da fase; eta_seconds = -1 enquanto não há
+ * dados suficientes.
+ */
+void update_progress_read(UpdateProgress* out);
+
+// Autoteste do seqlock com escritor e leitores concorrentes (update_progress_test.cc)
+int update_progress_run_selftest();
+
+#endif // ARCANOS_UPDATE_PROGRESS_H
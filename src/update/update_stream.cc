@@ -0,0 +1,267 @@
+// src/update/update_stream.cc
+// Instalação em streaming de pacotes delta, com checkpoints para retomada.
+
+#include "update_stream.h"
+#include "delta_engine.h"
+#include "update_defs.h"
+#include "update_progress.h"
+#include "../android/fastboot/sha256.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using arcanos::update::DeltaEngine;
+using arcanos::update::ScopedFd;
+
+namespace {
+
+// Limite da tabela de operações (evita alocar a partir de um cabeçalho corrompido)
+constexpr uint32_t kMaxOps = 1u << 20;
+
+bool readFully(int fd, void* buf, size_t len) {
+    uint8_t* p = static_cast<uint8_t*>(buf);
+    while (len > 0) {
+        ssize_t n = read(fd, p, len);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false; // Erro ou fim prematuro do fluxo
+        }
+        p += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Avança o fluxo: lseek quando possível, senão lê e descarta
+bool skipBytes(int fd, uint64_t len) {
+    if (len == 0) {
+        return true;
+    }
+    if (lseek(fd, static_cast<off_t>(len), SEEK_CUR) != static_cast<off_t>(-1)) {
+        return true;
+    }
+    std::vector<uint8_t> scratch(static_cast<size_t>(std::min<uint64_t>(len, 1024 * 1024)));
+    while (len > 0) {
+        size_t n = static_cast<size_t>(std::min<uint64_t>(len, scratch.size()));
+        if (!readFully(fd, scratch.data(), n)) {
+            return false;
+        }
+        len -= n;
+    }
+    return true;
+}
+
+bool loadCheckpoint(const char* path, const uint8_t manifest[32], UpdateCheckpoint& out) {
+    ScopedFd fd(open(path, O_RDONLY | O_CLOEXEC));
+    if (fd.fd < 0 || !readFully(fd.fd, &out, sizeof(out))) {
+        return false;
+    }
+    return std::memcmp(out.magic, UPDATE_CHECKPOINT_MAGIC, sizeof(out.magic)) == 0 &&
+           std::memcmp(out.manifest_sha256, manifest, sizeof(out.manifest_sha256)) == 0;
+}
+
+// Grava em arquivo temporário e renomeia: um checkpoint nunca fica pela metade
+bool saveCheckpoint(const char* path, const UpdateCheckpoint& checkpoint) {
+    std::string tmp = std::string(path) + ".tmp";
+    {
+        ScopedFd fd(open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600));
+        if (fd.fd < 0 || write(fd.fd, &checkpoint, sizeof(checkpoint)) != static_cast<ssize_t>(sizeof(checkpoint)) ||
+            fsync(fd.fd) != 0) {
+            return false;
+        }
+    }
+    if (rename(tmp.c_str(), path) != 0) {
+        return false;
+    }
+    std::string dir(path);
+    size_t slash = dir.rfind('/');
+    dir = slash == std::string::npos ? "." : (slash == 0 ? "/" : dir.substr(0, slash));
+    ScopedFd dir_fd(open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+    return dir_fd.fd >= 0 && fsync(dir_fd.fd) == 0;
+}
+
+} // namespace
+
+int update_stream_apply(int package_fd, const UpdateStreamConfig* config) {
+    if (package_fd < 0 || config == nullptr || config->source_path == nullptr || config->target_path == nullptr) {
+        return UPDATE_ERR_FORMAT;
+    }
+
+    // Cabeçalho e tabela de operações chegam primeiro
+    UpdateDeltaHeader header;
+    if (!readFully(package_fd, &header, sizeof(header))) {
+        return UPDATE_ERR_IO;
+    }
+    uint64_t table_end = sizeof(header) + static_cast<uint64_t>(header.op_count) * sizeof(UpdateDeltaOp);
+    if (header.op_count > kMaxOps || header.block_size == 0 || table_end > header.data_offset) {
+        return UPDATE_ERR_FORMAT;
+    }
+    std::vector<UpdateDeltaOp> ops(header.op_count);
+    if ((!ops.empty() && !readFully(package_fd, ops.data(), ops.size() * sizeof(UpdateDeltaOp))) ||
+        !skipBytes(package_fd, header.data_offset - table_end)) {
+        return UPDATE_ERR_IO;
+    }
+
+    uint8_t manifest[32];
+    {
+        arcanos::fastboot::Sha256 sha;
+        sha.update(&header, sizeof(header));
+        sha.update(ops.data(), ops.size() * sizeof(UpdateDeltaOp));
+        sha.finish(manifest);
+    }
+
+    ScopedFd source(open(config->source_path, O_RDONLY | O_CLOEXEC));
+    ScopedFd target(open(config->target_path, O_RDWR | O_CREAT | O_CLOEXEC, 0644));
+    if (source.fd < 0 || target.fd < 0) {
+        return UPDATE_ERR_IO;
+    }
+    int result = arcanos::update::delta_validate(header, ops.data(),
+                                                 arcanos::update::delta_device_blocks(source.fd, header.block_size),
+                                                 UINT64_MAX);
+    if (result != UPDATE_OK) {
+        return result;
+    }
+
+    // Operações com payload seguem a ordem do fluxo; as demais, a ordem da origem
+    std::vector<const UpdateDeltaOp*> data_ops, source_ops;
+    for (const UpdateDeltaOp& op : ops) {
+        (op.data_length > 0 ? data_ops : source_ops).push_back(&op);
+    }
+    std::sort(data_ops.begin(), data_ops.end(),
+              [](const UpdateDeltaOp* a, const UpdateDeltaOp* b) { return a->data_offset < b->data_offset; });
+    std::sort(source_ops.begin(), source_ops.end(),
+              [](const UpdateDeltaOp* a, const UpdateDeltaOp* b) { return a->src_start < b->src_start; });
+    uint64_t data_end = 0;
+    for (const UpdateDeltaOp* op : data_ops) {
+        if (op->data_offset < data_end) {
+            return UPDATE_ERR_FORMAT; // Payloads sobrepostos não podem ser consumidos em fluxo
+        }
+        data_end = op->data_offset + op->data_length;
+    }
+
+    result = arcanos::update::delta_prepare_target(target.fd, header);
+    if (result != UPDATE_OK) {
+        return result;
+    }
+
+    // Retomada: só vale para o mesmo pacote (mesmo manifesto)
+    UpdateCheckpoint checkpoint = {};
+    std::memcpy(checkpoint.magic, UPDATE_CHECKPOINT_MAGIC, sizeof(checkpoint.magic));
+    std::memcpy(checkpoint.manifest_sha256, manifest, sizeof(manifest));
+    UpdateCheckpoint saved;
+    if (config->checkpoint_path != nullptr && loadCheckpoint(config->checkpoint_path, manifest, saved) &&
+        saved.next_data_op <= data_ops.size() && saved.data_consumed <= data_end &&
+        (saved.next_data_op == data_ops.size() || saved.data_consumed <= data_ops[saved.next_data_op]->data_offset)) {
+        checkpoint.next_data_op = saved.next_data_op;
+        checkpoint.source_ops_done = saved.source_ops_done;
+        checkpoint.data_consumed = saved.data_consumed;
+        printf("update: retomando do checkpoint (%u operações, %llu bytes já aplicados)\n",
+               checkpoint.next_data_op, static_cast<unsigned long long>(checkpoint.data_consumed));
+    }
+    if (!skipBytes(package_fd, checkpoint.data_consumed)) {
+        return UPDATE_ERR_IO;
+    }
+
+    g_is_ab_partition_valid = false;
+    update_progress_start(UPDATE_STATE_DOWNLOAD, header.data_offset + data_end,
+                          header.data_offset + checkpoint.data_consumed);
+
+    const uint64_t interval = config->checkpoint_interval ? config->checkpoint_interval : 32ull * 1024 * 1024;
+    DeltaEngine engine(source.fd, target.fd, header.block_size, config->threads, config->max_inflight_bytes);
+
+    // COPY/ZERO não dependem do download: rodam enquanto os bytes chegam
+    std::atomic<bool> source_ops_submitted{checkpoint.source_ops_done != 0};
+    std::thread source_thread;
+    if (!checkpoint.source_ops_done) {
+        source_thread = std::thread([&] {
+            for (const UpdateDeltaOp* op : source_ops) {
+                if (engine.submit(*op, nullptr, std::vector<uint8_t>()) != UPDATE_OK) {
+                    return;
+                }
+            }
+            source_ops_submitted.store(true, std::memory_order_release);
+        });
+    }
+
+    // Barreira + checkpoint: tudo antes de 'next' está no disco
+    auto persist = [&](uint32_t next) {
+        bool sources = source_ops_submitted.load(std::memory_order_acquire);
+        if (engine.finish() != UPDATE_OK || config->checkpoint_path == nullptr) {
+            return;
+        }
+        checkpoint.next_data_op = next;
+        checkpoint.source_ops_done = sources ? 1 : 0;
+        if (!saveCheckpoint(config->checkpoint_path, checkpoint)) {
+            printf("update: falha ao gravar o checkpoint %s\n", config->checkpoint_path);
+        }
+    };
+
+    uint64_t since_checkpoint = 0;
+    for (uint32_t k = checkpoint.next_data_op; k < data_ops.size(); k++) {
+        const UpdateDeltaOp& op = *data_ops[k];
+        std::vector<uint8_t> payload(static_cast<size_t>(op.data_length));
+        if (!skipBytes(package_fd, op.data_offset - checkpoint.data_consumed) ||
+            !readFully(package_fd, payload.data(), payload.size())) {
+            // Download interrompido: guarda o que já foi aplicado para a próxima tentativa
+            persist(k);
+            result = UPDATE_ERR_IO;
+            break;
+        }
+        checkpoint.data_consumed = op.data_offset + op.data_length;
+        update_progress_advance(header.data_offset + checkpoint.data_consumed);
+
+        // Conferência e escrita acontecem nos workers enquanto o próximo payload chega
+        if (engine.submit(op, nullptr, std::move(payload)) != UPDATE_OK) {
+            break;
+        }
+        since_checkpoint += op.data_length;
+        if (since_checkpoint >= interval) {
+            persist(k + 1);
+            since_checkpoint = 0;
+        }
+    }
+
+    if (source_thread.joinable()) {
+        source_thread.join();
+    }
+    int engine_result = engine.finish();
+    if (result == UPDATE_OK) {
+        result = engine_result;
+    }
+    if (result == UPDATE_OK) {
+        result = arcanos::update::delta_verify_target(target.fd, header);
+    }
+    if (result != UPDATE_OK) {
+        printf("update: instalação em streaming interrompida (erro %d)\n", result);
+        return result;
+    }
+
+    if (config->checkpoint_path != nullptr) {
+        unlink(config->checkpoint_path);
+    }
+    g_is_ab_partition_valid = true;
+    printf("update: instalação em streaming concluída em %s (%u operações)\n",
+           config->target_path, header.op_count);
+    return UPDATE_OK;
+}
+
+int update_install_stream(int package_fd) {
+    UpdateStreamConfig config = {};
+    config.source_path = g_update_source_slot;
+    config.target_path = g_update_target_slot;
+    config.checkpoint_path = g_update_checkpoint_path;
+
+    g_update_try_count++;
+    int result = update_stream_apply(package_fd, &config); // Estado DOWNLOAD: download e aplicação juntos
+    update_progress_finish(result == UPDATE_OK ? UPDATE_STATE_REBOOT : UPDATE_STATE_IDLE, result == UPDATE_OK);
+    return result;
+}
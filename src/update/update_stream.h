@@ -0,0 +1,55 @@
+// src/update/update_stream.h
+// Instalação durante o download: o pacote delta é aplicado à medida que chega.
+
+#ifndef ARCANOS_UPDATE_STREAM_H
+#define ARCANOS_UPDATE_STREAM_H
+
+#include "update_delta.h"
+
+// Checkpoint persistido entre tentativas (little-endian)
+#define UPDATE_CHECKPOINT_MAGIC "ARCCKPT1"
+
+typedef struct {
+    char magic[8];                // UPDATE_CHECKPOINT_MAGIC
+    uint8_t manifest_sha256[32];  // Cabeçalho + tabela de operações do pacote em andamento
+    uint32_t next_data_op;        // Operações com payload já aplicadas (na ordem do fluxo)
+    uint32_t source_ops_done;     // 1 = COPY/ZERO já aplicadas
+    uint64_t data_consumed;       // Bytes da área de dados já consumidos
+} UpdateCheckpoint;
+
+typedef struct {
+    const char* source_path;      // Slot ativo (somente leitura)
+    const char* target_path;      // Slot inativo
+    const char* checkpoint_path;  // NULL = sem retomada
+    unsigned threads;             // 0 = todos os núcleos
+    size_t max_inflight_bytes;    // 0 = 64 MiB
+    uint64_t checkpoint_interval; // Bytes de payload entre checkpoints (0 = 32 MiB)
+} UpdateStreamConfig;
+
+/**
+ * @brief Aplica um pacote delta lido de 'package_fd' (socket, pipe ou arquivo)
+ * sem armazená-lo: cada operação é conferida e aplicada assim que seus bytes
+ * chegam, direto no slot inativo, sem partição de rascunho.
+ *
+ * O pacote precisa ter os payloads na área de dados em ordem crescente de
+ * offset (como o gerador os escreve). COPY e ZERO são aplicadas em paralelo
+ * por outra thread, com leituras sequenciais da origem, enquanto o download
+ * continua.
+ *
+ * A cada 'checkpoint_interval' bytes, as operações concluídas são levadas ao
+ * disco e o checkpoint é gravado. Se o mesmo pacote for enviado de novo
+ * depois de uma interrupção, o que já foi aplicado é pulado (lseek em
+ * arquivos; leitura descartada em pipes/sockets). O checkpoint é removido
+ * quando o update termina.
+ *
+ * @return UPDATE_OK ou um UPDATE_ERR_*.
+ */
+int update_stream_apply(int package_fd, const UpdateStreamConfig* config);
+
+// Versão com os slots e o checkpoint globais (update_defs.h)
+int update_install_stream(int package_fd);
+
+// Autoteste com quedas e retomada (update_stream_test.cc); arquivos em 'work_dir'
+int update_stream_run_selftest(const char* work_dir);
+
+#endif // ARCANOS_UPDATE_STREAM_H
@@ -0,0 +1,343 @@
+// src/update/update_stream_test.cc
+// Autoteste da instalação em streaming: pacote delta recebido por pipe (a
+// "rede") ou arquivo, com quedas no meio do download e retomada do checkpoint.
+// Autoteste de update_apply_delta com o mesmo pacote, lido de arquivo.
+
+#include "update_stream.h"
+#include "delta_engine.h"
+#include "update_defs.h"
+#include "../android/fastboot/sha256.h"
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using arcanos::update::ScopedFd;
+
+namespace {
+
+constexpr uint32_t kBlockSize = 4096;
+constexpr uint64_t kBlocks = 1024;   // Slots de 4 MiB
+constexpr uint64_t kExtent = 32;     // Blocos por operação
+
+void sha256(const void* data, size_t len, uint8_t out[32]) {
+    arcanos::fastboot::Sha256 sha;
+    sha.update(data, len);
+    sha.finish(out);
+}
+
+// Monta um pacote cujas operações se alternam entre COPY (bloco movido), DIFF
+// (poucos bytes mudados), REPLACE (conteúdo novo) e ZERO. 'target' recebe o
+// slot esperado depois da aplicação.
+std::vector<uint8_t> buildPackage(const std::vector<uint8_t>& source, std::vector<uint8_t>& target) {
+    std::vector<UpdateDeltaOp> ops;
+    std::vector<uint8_t> data;
+    target.assign(source.size(), 0);
+    uint32_t rnd = 0x1234567u;
+    const size_t extent_bytes = kExtent * kBlockSize;
+
+    for (uint64_t dst = 0; dst < kBlocks; dst += kExtent) {
+        UpdateDeltaOp op = {};
+        op.dst_start = dst;
+        op.dst_blocks = kExtent;
+        uint8_t* out = target.data() + dst * kBlockSize;
+        switch ((dst / kExtent) % 4) {
+        case 0: { // Extensão movida
+            op.type = UPDATE_OP_COPY;
+            op.src_start = (dst + 5 * kExtent) % kBlocks;
+            op.src_blocks = kExtent;
+            std::memcpy(out, source.data() + op.src_start * kBlockSize, extent_bytes);
+            sha256(out, extent_bytes, op.src_sha256);
+            break;
+        }
+        case 1: { // Um controle "add" sobre a extensão inteira
+            op.type = UPDATE_OP_DIFF;
+            op.src_start = dst;
+            op.src_blocks = kExtent;
+            const uint8_t* from = source.data() + dst * kBlockSize;
+            std::memcpy(out, from, extent_bytes);
+            for (size_t i = 0; i < extent_bytes; i += 509) {
+                out[i] ^= 0x5A;
+            }
+            uint32_t count = 1;
+            UpdateDiffControl ctl = { static_cast<uint32_t>(extent_bytes), 0, 0 };
+            std::vector<uint8_t> payload(sizeof(count) + sizeof(ctl));
+            std::memcpy(payload.data(), &count, sizeof(count));
+            std::memcpy(payload.data() + sizeof(count), &ctl, sizeof(ctl));
+            for (size_t i = 0; i < extent_bytes; i++) {
+                payload.push_back(static_cast<uint8_t>(out[i] - from[i]));
+            }
+            sha256(from, extent_bytes, op.src_sha256);
+            sha256(payload.data(), payload.size(), op.data_sha256);
+            op.data_offset = data.size();
+            op.data_length = payload.size();
+            data.insert(data.end(), payload.begin(), payload.end());
+            break;
+        }
+        case 2: { // Conteúdo novo
+            op.type = UPDATE_OP_REPLACE;
+            for (size_t i = 0; i < extent_bytes; i++) {
+                rnd = rnd * 1103515245u + 12345u;
+                out[i] = static_cast<uint8_t>(rnd >> 16);
+            }
+            sha256(out, extent_bytes, op.data_sha256);
+            op.data_offset = data.size();
+            op.data_length = extent_bytes;
+            data.insert(data.end(), out, out + extent_bytes);
+            break;
+        }
+        default:
+            op.type = UPDATE_OP_ZERO;
+            break;
+        }
+        ops.push_back(op);
+    }
+
+    UpdateDeltaHeader header = {};
+    std::memcpy(header.magic, UPDATE_DELTA_MAGIC, sizeof(header.magic));
+    header.version = UPDATE_DELTA_VERSION;
+    header.block_size = kBlockSize;
+    header.op_count = static_cast<uint32_t>(ops.size());
+    header.target_blocks = kBlocks;
+    header.data_offset = sizeof(header) + ops.size() * sizeof(UpdateDeltaOp);
+    sha256(target.data(), target.size(), header.target_sha256);
+
+    std::vector<uint8_t> package(header.data_offset);
+    std::memcpy(package.data(), &header, sizeof(header));
+    std::memcpy(package.data() + sizeof(header), ops.data(), ops.size() * sizeof(UpdateDeltaOp));
+    package.insert(package.end(), data.begin(), data.end());
+    return package;
+}
+
+bool writeFile(const std::string& path, const std::vector<uint8_t>& bytes) {
+    ScopedFd fd(open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644));
+    return fd.fd >= 0 && write(fd.fd, bytes.data(), bytes.size()) == static_cast<ssize_t>(bytes.size());
+}
+
+bool fileMatches(const std::string& path, const std::vector<uint8_t>& expected) {
+    std::vector<uint8_t> bytes(expected.size() + 1);
+    ScopedFd fd(open(path.c_str(), O_RDONLY | O_CLOEXEC));
+    return fd.fd >= 0 && pread(fd.fd, bytes.data(), bytes.size(), 0) == static_cast<ssize_t>(expected.size()) &&
+           std::memcmp(bytes.data(), expected.data(), expected.size()) == 0;
+}
+
+// A "rede": outra thread escreve os primeiros 'limit' bytes do pacote num pipe
+// e fecha, como uma conexão que cai
+int applyOverPipe(const std::vector<uint8_t>& package, size_t limit, const UpdateStreamConfig& config) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return UPDATE_ERR_IO;
+    }
+    std::thread network([&] {
+        size_t end = std::min(limit, package.size());
+        for (size_t pos = 0; pos < end;) {
+            ssize_t n = write(fds[1], package.data() + pos, std::min<size_t>(7777, end - pos));
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                break; // O instalador desistiu e fechou o pipe
+            }
+            pos += static_cast<size_t>(n);
+        }
+        close(fds[1]);
+    });
+    int result = update_stream_apply(fds[0], &config);
+    close(fds[0]);
+    network.join();
+    return result;
+}
+
+bool readCheckpoint(const char* path, UpdateCheckpoint& out) {
+    ScopedFd fd(open(path, O_RDONLY | O_CLOEXEC));
+    return fd.fd >= 0 && read(fd.fd, &out, sizeof(out)) == static_cast<ssize_t>(sizeof(out));
+}
+
+// Slot ativo com conteúdo pseudoaleatório
+std::vector<uint8_t> makeSource() {
+    std::vector<uint8_t> source(kBlocks * kBlockSize);
+    uint32_t rnd = 0xC0FFEEu;
+    for (uint8_t& b : source) {
+        rnd = rnd * 1103515245u + 12345u;
+        b = static_cast<uint8_t>(rnd >> 16);
+    }
+    return source;
+}
+
+} // namespace
+
+/**
+ * @brief Instala um pacote delta em streaming: fluxo completo por pipe, quedas
+ * no meio do download seguidas de retomada pelo checkpoint (por pipe, que
+ * descarta o que já foi aplicado, e por arquivo, que usa lseek) e rejeição de
+ * um payload corrompido.
+ * @param work_dir Diretório para os slots, o pacote e o checkpoint.
+ * @return 0 se o teste for bem-sucedido, 1 caso contrário.
+ */
+int update_stream_run_selftest(const char* work_dir) {
+    printf("--- ARCANOS UPDATE STREAM: SELF-TEST ---\n");
+    signal(SIGPIPE, SIG_IGN); // Escrita no pipe depois que o instalador desiste
+
+    std::string dir(work_dir);
+    std::string source_path = dir + "/selftest_source.img";
+    std::string target_path = dir + "/selftest_target.img";
+    std::string package_path = dir + "/selftest_package.bin";
+    std::string checkpoint_path = dir + "/selftest_update.ckpt";
+
+    std::vector<uint8_t> source = makeSource();
+    std::vector<uint8_t> expected;
+    std::vector<uint8_t> package = buildPackage(source, expected);
+    if (!writeFile(source_path, source) || !writeFile(package_path, package)) {
+        printf("TEST FAILED: Nao foi possivel criar os arquivos em %s.\n", work_dir);
+        return 1;
+    }
+
+    UpdateStreamConfig config = {};
+    config.source_path = source_path.c_str();
+    config.target_path = target_path.c_str();
+    config.checkpoint_path = checkpoint_path.c_str();
+    config.threads = 3;
+    config.checkpoint_interval = 128 * 1024; // Vários checkpoints ao longo do pacote
+
+    // 1. Fluxo completo
+    unlink(target_path.c_str());
+    unlink(checkpoint_path.c_str());
+    if (applyOverPipe(package, package.size(), config) != UPDATE_OK || !fileMatches(target_path, expected) ||
+        access(checkpoint_path.c_str(), F_OK) == 0) {
+        printf("TEST FAILED: Instalacao completa por pipe.\n");
+        return 1;
+    }
+
+    // 2. Quedas em pontos diferentes, duas seguidas, e retomada por pipe
+    for (size_t cut : { package.size() / 3, package.size() * 2 / 3 }) {
+        unlink(target_path.c_str());
+        unlink(checkpoint_path.c_str());
+        UpdateCheckpoint first, second;
+        if (applyOverPipe(package, cut, config) != UPDATE_ERR_IO ||
+            !readCheckpoint(checkpoint_path.c_str(), first) || first.next_data_op == 0) {
+            printf("TEST FAILED: Queda em %zu nao deixou checkpoint.\n", cut);
+            return 1;
+        }
+        if (applyOverPipe(package, package.size() * 9 / 10, config) != UPDATE_ERR_IO ||
+            !readCheckpoint(checkpoint_path.c_str(), second) || second.data_consumed <= first.data_consumed) {
+            printf("TEST FAILED: Segunda queda nao avancou o checkpoint.\n");
+            return 1;
+        }
+        if (applyOverPipe(package, package.size(), config) != UPDATE_OK || !fileMatches(target_path, expected) ||
+            access(checkpoint_path.c_str(), F_OK) == 0) {
+            printf("TEST FAILED: Retomada por pipe apos queda em %zu.\n", cut);
+            return 1;
+        }
+    }
+
+    // 3. Queda por pipe, retomada lendo o pacote de um arquivo (lseek)
+    unlink(target_path.c_str());
+    unlink(checkpoint_path.c_str());
+    if (applyOverPipe(package, package.size() / 2, config) != UPDATE_ERR_IO) {
+        printf("TEST FAILED: Queda antes da retomada por arquivo.\n");
+        return 1;
+    }
+    {
+        ScopedFd file(open(package_path.c_str(), O_RDONLY | O_CLOEXEC));
+        if (update_stream_apply(file.fd, &config) != UPDATE_OK || !fileMatches(target_path, expected)) {
+            printf("TEST FAILED: Retomada lendo o pacote de arquivo.\n");
+            return 1;
+        }
+    }
+
+    // 4. Payload corrompido: erro de hash, slot não fica válido
+    std::vector<uint8_t> corrupted = package;
+    corrupted[corrupted.size() - 100] ^= 1;
+    unlink(target_path.c_str());
+    unlink(checkpoint_path.c_str());
+    if (applyOverPipe(corrupted, corrupted.size(), config) != UPDATE_ERR_HASH) {
+        printf("TEST FAILED: Payload corrompido nao retornou UPDATE_ERR_HASH.\n");
+        return 1;
+    }
+
+    unlink(source_path.c_str());
+    unlink(target_path.c_str());
+    unlink(package_path.c_str());
+    unlink(checkpoint_path.c_str());
+    printf("--- ARCANOS UPDATE STREAM: TESTE BEM-SUCEDIDO ---\n");
+    return 0;
+}
+
+/**
+ * @brief Aplica o pacote delta do autoteste de streaming com update_apply_delta
+ * (pacote em arquivo, mapeado): o slot inativo deve sair igual ao esperado e
+ * g_is_ab_partition_valid deve voltar a true, também com pouca memória para
+ * blocos de origem em trânsito. Com um byte da origem corrompido dentro de uma
+ * extensão COPY, retorna UPDATE_ERR_HASH e o slot continua inválido.
+ * @param work_dir Diretório para os slots e o pacote.
+ * @return 0 se o teste for bem-sucedido, 1 caso contrário.
+ */
+int update_delta_run_selftest(const char* work_dir) {
+    printf("--- ARCANOS UPDATE DELTA: SELF-TEST ---\n");
+
+    std::string dir(work_dir);
+    std::string source_path = dir + "/selftest_delta_source.img";
+    std::string target_path = dir + "/selftest_delta_target.img";
+    std::string package_path = dir + "/selftest_delta_package.bin";
+
+    std::vector<uint8_t> source = makeSource();
+    std::vector<uint8_t> expected;
+    std::vector<uint8_t> package = buildPackage(source, expected);
+    if (!writeFile(source_path, source) || !writeFile(package_path, package)) {
+        printf("TEST FAILED: Nao foi possivel criar os arquivos em %s.\n", work_dir);
+        return 1;
+    }
+
+    UpdateApplyConfig config = {};
+    config.source_path = source_path.c_str();
+    config.target_path = target_path.c_str();
+    config.threads = 3;
+
+    // 1. Aplicação completa, com a memória padrão e com pouca memória em trânsito
+    for (size_t inflight : { size_t(0), size_t(2) * kExtent * kBlockSize }) {
+        config.max_inflight_bytes = inflight;
+        unlink(target_path.c_str());
+        g_is_ab_partition_valid = false;
+        if (update_apply_delta(package_path.c_str(), &config) != UPDATE_OK ||
+            !fileMatches(target_path, expected) || !g_is_ab_partition_valid) {
+            printf("TEST FAILED: Aplicacao do pacote (max_inflight_bytes %zu).\n", inflight);
+            return 1;
+        }
+    }
+
+    // 2. Origem corrompida (bloco lido pela primeira operação COPY): erro de hash,
+    // slot continua inválido
+    std::vector<uint8_t> corrupted = source;
+    corrupted[5 * kExtent * kBlockSize + 1234] ^= 1;
+    if (!writeFile(source_path, corrupted)) {
+        printf("TEST FAILED: Nao foi possivel corromper a origem.\n");
+        return 1;
+    }
+    unlink(target_path.c_str());
+    g_is_ab_partition_valid = true; // Precisa ser derrubado pela aplicação
+    if (update_apply_delta(package_path.c_str(), &config) != UPDATE_ERR_HASH || g_is_ab_partition_valid) {
+        printf("TEST FAILED: Origem corrompida nao retornou UPDATE_ERR_HASH com o slot invalido.\n");
+        return 1;
+    }
+
+    unlink(source_path.c_str());
+    unlink(target_path.c_str());
+    unlink(package_path.c_str());
+    printf("--- ARCANOS UPDATE DELTA: TESTE BEM-SUCEDIDO ---\n");
+    return 0;
+}
+
+// Opcional: Função main simulada para execução direta do teste
+/*
+int main() {
+    if (update_stream_run_selftest("/tmp") != 0) {
+        return 1;
+    }
+    return update_delta_run_selftest("/tmp");
+}
+*/
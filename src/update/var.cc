@@ -4,6 +4,7 @@
 // em diversos headers (.h) sejam definidas em UM SO ARQUIVO de objeto.
 
 #include "update_defs.h"
+#include "update_progress.h"
 
 // Note: Se houvesse mais headers de update (ex: update_security.h, update_ui.h),
 // eles seriam incluidos AQUI também.
@@ -16,23 +17,24 @@
 // ======================================================================
 
 // Variáveis de Estado (Definindo as 'extern' de update_defs.h)
-int g_update_state = 0; // 0 = IDLE
-
 // A versão para a qual estamos atualizando (inicialmente vazia)
 char g_target_os_version[32] = {0};
 
 // O status da partição de backup
 bool g_is_ab_partition_valid = false;
 
+// Slots A/B (o bootloader troca os papéis depois de um update bem-sucedido)
+char g_update_source_slot[128] = "/dev/block/by-name/system_a";
+char g_update_target_slot[128] = "/dev/block/by-name/system_b";
+
+// Checkpoint da instalação em streaming
+char g_update_checkpoint_path[128] = "/data/ota/update.ckpt";
+
 // Contador de tentativas de aplicação da atualização
 uint8_t g_update_try_count = 0;
 
-// Instância da estrutura de progresso (Inicializada)
-UpdateProgress g_current_progress = {
-    .total_size = 0,
-    .bytes_downloaded = 0,
-    .is_verified = false
-};
+// Estado e progresso sob seqlock (zerado = IDLE, sequência par)
+UpdateProgressRecord g_update_progress = {};
 
 // ======================================================================
 // (Outras definições de variaveis globais iriam aqui)
@@ -2,12 +2,19 @@
 #include <iostream>
 #include <cstdlib> // Para chamadas de sistema (boot final)
 #include <fstream> // Para simular leitura de disco/rede
+#include <cstring> // Para memcpy
 
 using namespace ArcanOS;
 
 ZipArchiveLoader::ZipArchiveLoader(const std::vector<ArchivePart>& parts)
     : archive_parts(parts) {}
 
+void ZipArchiveLoader::set_ramdisk_region(uint8_t* base, size_t capacity) {
+    ramdisk_base = base;
+    ramdisk_capacity = capacity;
+    ramdisk_used = 0;
+}
+
 bool ZipArchiveLoader::fetch_part(const ArchivePart& part) {
     std::cout << "Tentando buscar parte: " << part.filename 
               << " (" << part.size_bytes / (1024*1024) << " MB)" << std::endl;
@@ -29,9 +36,21 @@ bool ZipArchiveLoader::decompress_to_ram(const std::string& data) {
     // LÓGICA DE DESCOMPRESSÃO AQUI:
     // Usaria a biblioteca 'zlib' ou 'libzip' para descompactar
     // o conteúdo diretamente para o ponto de montagem do ramdisk.
+    // A saída do inflate vai direto para ramdisk_base + ramdisk_used.
     // *******************************************************
 
-    // Simulação de sucesso
+    if (ramdisk_base == nullptr) {
+        // Simulação de sucesso (sem região entregue pelo boot)
+        return true;
+    }
+
+    // Simulação: os dados "descompactados" são copiados para o fim do ramdisk
+    if (data.size() > ramdisk_capacity - ramdisk_used) {
+        std::cerr << "ERRO: Ramdisk cheio (" << ramdisk_capacity / (1024*1024) << " MB)." << std::endl;
+        return false;
+    }
+    std::memcpy(ramdisk_base + ramdisk_used, data.data(), data.size());
+    ramdisk_used += data.size();
     return true;
 }
 
@@ -3,6 +3,8 @@
 
 #include <string>
 #include <vector>
+#include <cstddef>
+#include <cstdint>
 
 // Define a estrutura para as partes do arquivo (part1, part2, etc.)
 struct ArchivePart {
@@ -22,9 +24,18 @@ public:
     // Retorna true em sucesso, false em falha.
     bool load_system_to_ram();
 
+    // Define a região contígua (ArcBootInfo::ramdisk_paddr/ramdisk_size, já mapeada
+    // com páginas de 2 MiB) onde o sistema é descompactado diretamente, sem realocar.
+    void set_ramdisk_region(uint8_t* base, size_t capacity);
+
 private:
     std::vector<ArchivePart> archive_parts;
 
+    // Região de destino do ramdisk (nullptr = nenhuma região entregue pelo boot)
+    uint8_t* ramdisk_base = nullptr;
+    size_t ramdisk_capacity = 0;
+    size_t ramdisk_used = 0;
+
     // Métodos privados auxiliares
     bool fetch_part(const ArchivePart& part);
     bool decompress_to_ram(const std::string& data);